@@ -0,0 +1,78 @@
+/**
+ * @file attention_bench.cpp
+ * @author Krish Suraparaju (csurapar@andrew.cmu.edu)
+ * @brief Measures the throughput and the memory of MultiHeadAttention over a
+ * range of sequence lengths, next to an attention that materializes the
+ * T x T probabilities of every head. The blocked layer keeps O(T) state for
+ * backward; the materialized attention needs O(T^2) just for the scores.
+ * fwd_ms and bwd_ms include the four projections, materialized_ms is the
+ * attention core alone (without projections, without backward).
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include <Eigen/Dense>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include "../include/nn/attention.h"
+
+template <typename F>
+static double time_ms(F&& fn, int reps) {
+    fn();  // Warm up
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < reps; r++) {
+        fn();
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count() / reps;
+}
+
+// softmax(Q K^T / sqrt(d_head)) V of every head, with the scores materialized
+static Eigen::MatrixXd materialized(const Eigen::MatrixXd& Q, const Eigen::MatrixXd& K,
+                                    const Eigen::MatrixXd& V, size_t T, size_t H) {
+    size_t dh = Q.cols() / H;
+    Eigen::MatrixXd O(Q.rows(), Q.cols());
+    for (size_t r0 = 0; r0 < static_cast<size_t>(Q.rows()); r0 += T) {
+        for (size_t h = 0; h < H; h++) {
+            Eigen::MatrixXd S = Q.block(r0, h * dh, T, dh) * K.block(r0, h * dh, T, dh).transpose()
+                / std::sqrt(static_cast<double>(dh));
+            Eigen::ArrayXXd P = (S.array().colwise() - S.rowwise().maxCoeff().array()).exp();
+            P.colwise() /= P.rowwise().sum();
+            O.block(r0, h * dh, T, dh) = P.matrix() * V.block(r0, h * dh, T, dh);
+        }
+    }
+    return O;
+}
+
+int main() {
+    const size_t d_model = 128, num_heads = 2, batch = 2;
+    const size_t seq_lens[] = {64, 128, 256, 512, 1024, 2048};
+
+    std::cout << "d_model=" << d_model << " heads=" << num_heads << " batch=" << batch << std::endl;
+    std::cout << "  T     fwd_ms   bwd_ms   tokens/s   state_MB   scores_MB   materialized_ms"
+              << std::endl;
+    for (size_t T : seq_lens) {
+        MultiHeadAttention mha(d_model, num_heads, T);
+        Eigen::MatrixXd A = Eigen::MatrixXd::Random(batch * T, d_model);
+        Eigen::MatrixXd dLdZ = Eigen::MatrixXd::Random(batch * T, d_model);
+        int reps = T <= 256 ? 10 : 2;
+
+        double fwd_ms = time_ms([&]() { mha.forward(A); }, reps);
+        double bwd_ms = time_ms([&]() { mha.forward(A); mha.backward(dLdZ); }, reps) - fwd_ms;
+        mha.forward(A);
+        double state_mb = mha.cache_bytes() / 1e6;
+        // What the probabilities of all heads alone would take if kept for backward
+        double scores_mb = static_cast<double>(batch * num_heads * T * T * sizeof(double)) / 1e6;
+        double naive_ms = time_ms([&]() { materialized(mha.Q_, mha.K_, mha.V_, T, num_heads); }, reps);
+
+        std::cout << "  " << T << "\t" << fwd_ms << "\t" << bwd_ms << "\t"
+                  << batch * T / ((fwd_ms + bwd_ms) / 1e3) << "\t" << state_mb << "\t"
+                  << scores_mb << "\t" << naive_ms << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,60 @@
+/**
+ * @file autotune_bench.cpp
+ * @author Krish Suraparaju (csurapar@andrew.cmu.edu)
+ * @brief Tunes a 784-256-256-10 MLP for training on this machine, prints every
+ * measured setting and saves the best one to a profile file (the first
+ * argument, or mlp.tune).
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include <Eigen/Dense>
+#include <iostream>
+#include <memory>
+#include <vector>
+#include "../include/nn/autotune.h"
+#include "../include/nn/model.h"
+
+// The backend of a measurement, with the micro-kernel for the packed backend
+static const char* setting_name(const TuneProfile& profile) {
+    return profile.backend == GemmBackend::Packed ? gemm_kernel_name(profile.kernel)
+                                                  : gemm_backend_name(profile.backend);
+}
+
+int main(int argc, char** argv) {
+    const char* path = argc > 1 ? argv[1] : "mlp.tune";
+    std::vector<std::unique_ptr<Layer>> layers;
+    std::vector<std::unique_ptr<ActivationFunction>> activations;
+    std::unique_ptr<LossFunction> loss = std::make_unique<SoftmaxCrossEntropy>();
+    layers.emplace_back(std::make_unique<Linear>(784, 256));
+    layers.emplace_back(std::make_unique<Linear>(256, 256));
+    layers.emplace_back(std::make_unique<Linear>(256, 10));
+    activations.emplace_back(std::make_unique<ReLU>());
+    activations.emplace_back(std::make_unique<ReLU>());
+    activations.emplace_back(std::make_unique<Identity>());
+    Model model(layers, activations, loss);
+
+    Eigen::MatrixXd X = Eigen::MatrixXd::Random(256, 784);
+    Eigen::MatrixXd Y = Eigen::MatrixXd::Zero(256, 10);
+    for (int i = 0; i < 256; i++) {
+        Y(i, i % 10) = 1;
+    }
+
+    TuneResult result = autotune(model, X, Y);
+    std::cout << "  backend\tthreads  batch  latency_ms  samples/s" << std::endl;
+    for (const TuneProfile& profile : result.measurements) {
+        std::cout << "  " << setting_name(profile) << "\t" << profile.num_threads
+                  << "\t   " << profile.batch_size << "\t  " << profile.latency_ms
+                  << "\t" << profile.samples_per_sec << std::endl;
+    }
+    const TuneProfile& best = result.best;
+    std::cout << "best: " << setting_name(best) << ", " << best.num_threads
+              << " threads, batch " << best.batch_size << " (" << best.samples_per_sec
+              << " samples/s), saved to " << path << std::endl;
+    save_profile(path, best);
+    return 0;
+}
@@ -0,0 +1,54 @@
+/**
+ * @file checkpoint_bench.cpp
+ * @author Krish Suraparaju (csurapar@andrew.cmu.edu)
+ * @brief Reports the peak memory held for the backward pass and the time of
+ * one training step of deep MLPs, without checkpoints and with sqrt(L)
+ * checkpoints.
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include <Eigen/Dense>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <vector>
+#include "../include/nn/model.h"
+
+int main() {
+    const size_t width = 256, batch = 256, steps = 3;
+    std::cout << "depth  checkpoints  peak_MB  step_ms" << std::endl;
+    for (size_t depth : {16, 64, 256}) {
+        std::vector<std::unique_ptr<Layer>> layers;
+        std::vector<std::unique_ptr<ActivationFunction>> activations;
+        std::unique_ptr<LossFunction> loss = std::make_unique<MeanSquaredError>();
+        for (size_t i = 0; i < depth; i++) {
+            layers.emplace_back(std::make_unique<Linear>(width, width));
+            activations.emplace_back(std::make_unique<Tanh>());
+        }
+        Model model(layers, activations, loss);
+        Eigen::MatrixXd X = Eigen::MatrixXd::Random(batch, width);
+        Eigen::MatrixXd Y = Eigen::MatrixXd::Random(batch, width);
+
+        for (bool checkpointing : {false, true}) {
+            if (checkpointing) {
+                model.set_sqrt_checkpoints();
+            } else {
+                model.set_checkpoints({});
+            }
+            auto start = std::chrono::steady_clock::now();
+            for (size_t step = 0; step < steps; step++) {
+                loss->forward(model.forward(X), Y);
+                model.backward();
+            }
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / steps;
+            std::cout << depth << "\t" << model.checkpoints_.size() << "\t     "
+                      << model.peak_cache_bytes_ / 1e6 << "\t" << ms << std::endl;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,62 @@
+/**
+ * @file gemm_bench.cpp
+ * @author Krish Suraparaju (csurapar@andrew.cmu.edu)
+ * @brief Compares the GEMM backends on the three products of a Linear layer
+ * (forward, dL/dA and dL/dW) for typical layer shapes, including the
+ * tall-skinny ones of small batches and narrow layers. Build with
+ * -DDNN_USE_CBLAS=ON to include an external BLAS in the comparison.
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include <Eigen/Dense>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include "../include/nn/layer.h"
+#include "../include/utils/gemm.h"
+
+template <typename F>
+static double time_ms(F&& fn, int reps) {
+    fn();  // Warm up
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < reps; r++) {
+        fn();
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count() / reps;
+}
+
+int main() {
+    // Batch size, input size, output size
+    const size_t shapes[][3] = {{1, 1024, 1024}, {16, 1024, 1024}, {64, 784, 128},
+                                {256, 1024, 1024}, {256, 4096, 256}, {1024, 128, 10}};
+    const GemmBackend backends[] = {GemmBackend::Eigen, GemmBackend::Cblas, GemmBackend::Packed};
+
+    std::cout << "  N     in    out   backend          fwd_ms   bwd_ms   GFLOP/s" << std::endl;
+    for (const auto& shape : shapes) {
+        size_t N = shape[0], in = shape[1], out = shape[2];
+        Linear linear(in, out);
+        Eigen::MatrixXd A = Eigen::MatrixXd::Random(N, in);
+        Eigen::MatrixXd dLdZ = Eigen::MatrixXd::Random(N, out);
+        double flops = 3.0 * 2.0 * N * in * out;  // Forward, dL/dA and dL/dW
+        int reps = static_cast<int>(std::max(3.0, 2e9 / flops));
+
+        for (GemmBackend backend : backends) {
+            if (!gemm_backend_available(backend)) {
+                continue;
+            }
+            set_gemm_backend(backend);
+            double fwd_ms = time_ms([&]() { linear.forward(A); }, reps);
+            double bwd_ms = time_ms([&]() { linear.backward(dLdZ); }, reps);
+            std::cout << "  " << N << "\t" << in << "\t" << out << "\t" << gemm_backend_name(backend)
+                      << "\t" << fwd_ms << "\t" << bwd_ms << "\t"
+                      << flops / ((fwd_ms + bwd_ms) * 1e6) << std::endl;
+        }
+    }
+    return 0;
+}
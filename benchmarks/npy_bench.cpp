@@ -0,0 +1,65 @@
+/**
+ * @file npy_bench.cpp
+ * @author Krish Suraparaju (csurapar@andrew.cmu.edu)
+ * @brief Compares loading a weight matrix from a text dump, from a .npy file
+ * into a MatrixXd, and by memory-mapping the .npy file, for a few sizes.
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include <Eigen/Dense>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include "../include/utils/npy.h"
+
+template <typename F>
+static double time_ms(F&& fn) {
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+int main() {
+    const char* text_path = "npy_bench.txt";
+    const char* npy_path = "npy_bench.npy";
+    std::cout << "  size       text_ms   npy_load_ms  npy_map_ms  (map + sum)" << std::endl;
+    for (size_t n : {256, 1024, 2048}) {
+        Eigen::MatrixXd W = Eigen::MatrixXd::Random(n, n);
+        {
+            std::ofstream text(text_path);
+            text.precision(17);
+            text << W;
+        }
+        save_npy(npy_path, W);
+
+        double text_ms = time_ms([&]() {
+            std::ifstream text(text_path);
+            Eigen::MatrixXd loaded(n, n);
+            for (size_t i = 0; i < n; i++) {
+                for (size_t j = 0; j < n; j++) {
+                    text >> loaded(i, j);
+                }
+            }
+        });
+        double load_ms = time_ms([&]() { load_npy(npy_path); });
+        double map_ms = 0.0, sum_ms = 0.0, sum = 0.0;
+        {
+            std::unique_ptr<NpyMap> map;
+            map_ms = time_ms([&]() { map = std::make_unique<NpyMap>(npy_path); });
+            sum_ms = time_ms([&]() { sum = map->matrix().sum(); });
+        }
+        std::cout << "  " << n << "x" << n << "\t" << text_ms << "\t" << load_ms << "\t"
+                  << map_ms << "\t(" << map_ms + sum_ms << ", sum " << sum << ")" << std::endl;
+    }
+    std::remove(text_path);
+    std::remove(npy_path);
+    return 0;
+}
@@ -0,0 +1,66 @@
+/**
+ * @file pipeline_bench.cpp
+ * @author Krish Suraparaju (csurapar@andrew.cmu.edu)
+ * @brief Compares the training throughput of a deep MLP run through the
+ * single-threaded Model::forward/backward against PipelineModel with several
+ * stage counts and both schedules.
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include <Eigen/Dense>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "../include/nn/model.h"
+#include "../include/nn/pipeline.h"
+
+int main() {
+    const size_t depth = 8, width = 512, batch = 512, steps = 5;
+    std::vector<std::unique_ptr<Layer>> layers;
+    std::vector<std::unique_ptr<ActivationFunction>> activations;
+    std::unique_ptr<LossFunction> loss = std::make_unique<MeanSquaredError>();
+    for (size_t i = 0; i < depth; i++) {
+        layers.emplace_back(std::make_unique<Linear>(width, width));
+        activations.emplace_back(std::make_unique<ReLU>());
+    }
+    Model model(layers, activations, loss);
+    Eigen::MatrixXd X = Eigen::MatrixXd::Random(batch, width);
+    Eigen::MatrixXd Y = Eigen::MatrixXd::Random(batch, width);
+
+    auto report = [&](const char* name, double seconds) {
+        std::cout << name << ": " << steps * batch / seconds << " samples/s" << std::endl;
+    };
+
+    std::cout << "depth=" << depth << " width=" << width << " batch=" << batch
+              << " cores=" << std::thread::hardware_concurrency() << std::endl;
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t step = 0; step < steps; step++) {
+        loss->forward(model.forward(X), Y);
+        model.backward();
+    }
+    report("Model (single thread)", std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+
+    for (size_t stages : {2, 4, 8}) {
+        for (PipelineSchedule schedule : {PipelineSchedule::GPipe, PipelineSchedule::OneFOneB}) {
+            PipelineModel pipeline(model, stages, 2 * stages, schedule);
+            pipeline.train_step(X, Y);  // Warm up
+            start = std::chrono::steady_clock::now();
+            for (size_t step = 0; step < steps; step++) {
+                pipeline.train_step(X, Y);
+            }
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            std::string name = "Pipeline " + std::to_string(stages) + " stages, "
+                               + (schedule == PipelineSchedule::GPipe ? "GPipe" : "1F1B");
+            report(name.c_str(), seconds);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,75 @@
+/**
+ * @file sparse_linear_bench.cpp
+ * @author Krish Suraparaju (csurapar@andrew.cmu.edu)
+ * @brief Compares the forward pass of a pruned SparseLinear layer against the
+ * dense GEMM of Linear over a range of sparsities, and reports the sparsity at
+ * which the sparse kernel starts to win for each shape. Both layers are timed
+ * with predict, so neither pays for caching its input for backward.
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include <Eigen/Dense>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <vector>
+#include "../include/nn/model.h"
+#include "../include/nn/prune.h"
+
+template <typename F>
+static double time_ms(F&& fn, int reps) {
+    fn();  // Warm up
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < reps; r++) {
+        fn();
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count() / reps;
+}
+
+int main() {
+    const std::vector<double> sparsities = {0.0, 0.5, 0.7, 0.8, 0.9, 0.95, 0.98, 0.99};
+    const size_t shapes[][3] = {{1, 1024, 1024}, {32, 1024, 1024}, {256, 1024, 1024}, {256, 4096, 256}};
+
+    for (const auto& shape : shapes) {
+        size_t N = shape[0], in = shape[1], out = shape[2];
+        Eigen::MatrixXd X = Eigen::MatrixXd::Random(N, in);
+        int reps = N == 1 ? 200 : 10;
+        double crossover = -1.0;
+
+        std::cout << "N=" << N << " in=" << in << " out=" << out << std::endl;
+        std::cout << "  sparsity  dense_ms  sparse_ms  speedup" << std::endl;
+        for (double sparsity : sparsities) {
+            std::vector<std::unique_ptr<Layer>> layers;
+            std::vector<std::unique_ptr<ActivationFunction>> activations;
+            std::unique_ptr<LossFunction> loss = std::make_unique<MeanSquaredError>();
+            layers.emplace_back(std::make_unique<Linear>(in, out));
+            Model model(layers, activations, loss);
+
+            magnitude_prune(model, {0}, sparsity, PruneScope::Global, false);
+            Layer& dense = *layers[0];
+            double dense_ms = time_ms([&]() { dense.predict(X); }, reps);
+
+            magnitude_prune(model, {0}, sparsity, PruneScope::Global, true);
+            Layer& sparse = *layers[0];
+            double sparse_ms = time_ms([&]() { sparse.predict(X); }, reps);
+
+            if (crossover < 0 && sparse_ms < dense_ms) {
+                crossover = sparsity;
+            }
+            std::cout << "  " << sparsity << "\t    " << dense_ms << "\t" << sparse_ms
+                      << "\t   " << dense_ms / sparse_ms << "x" << std::endl;
+        }
+        if (crossover < 0) {
+            std::cout << "  sparse kernel never beat dense GEMM" << std::endl;
+        } else {
+            std::cout << "  crossover sparsity: " << crossover << std::endl;
+        }
+    }
+    return 0;
+}
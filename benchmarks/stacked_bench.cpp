@@ -0,0 +1,88 @@
+/**
+ * @file stacked_bench.cpp
+ * @author Krish Suraparaju (csurapar@andrew.cmu.edu)
+ * @brief Compares one training step of K small MLPs run one by one as separate
+ * Models against the same K models stacked into StackedLinear layers, for a
+ * few ensemble sizes and batch sizes.
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include <Eigen/Dense>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <vector>
+#include "../include/nn/model.h"
+#include "../include/optim/sgd.h"
+#include "../include/utils/parallel.h"
+
+template <typename F>
+static double time_ms(F&& fn, int reps) {
+    fn();  // Warm up
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < reps; r++) {
+        fn();
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count() / reps;
+}
+
+int main() {
+    const size_t in = 16, hidden = 32, out = 1;
+    const size_t shapes[][2] = {{8, 32}, {32, 32}, {64, 128}, {128, 64}};
+    std::cout << "threads=" << num_threads() << " mlp=" << in << "-" << hidden << "-" << out << std::endl;
+    std::cout << "  K    N   separate_ms  stacked_ms  speedup" << std::endl;
+
+    for (const auto& shape : shapes) {
+        size_t K = shape[0], N = shape[1];
+        Eigen::MatrixXd X = Eigen::MatrixXd::Random(N, in);
+        Eigen::MatrixXd Y = Eigen::MatrixXd::Random(N, out);
+
+        std::vector<std::vector<std::unique_ptr<Layer>>> layers(K);
+        std::vector<std::vector<std::unique_ptr<ActivationFunction>>> activations(K);
+        std::vector<std::unique_ptr<LossFunction>> losses(K);
+        std::vector<std::unique_ptr<Model>> models;
+        std::vector<std::unique_ptr<SGD>> sgds;
+        for (size_t k = 0; k < K; k++) {
+            layers[k].emplace_back(std::make_unique<Linear>(in, hidden));
+            layers[k].emplace_back(std::make_unique<Linear>(hidden, out));
+            activations[k].emplace_back(std::make_unique<ReLU>());
+            activations[k].emplace_back(std::make_unique<Identity>());
+            losses[k] = std::make_unique<MeanSquaredError>();
+            models.push_back(std::make_unique<Model>(layers[k], activations[k], losses[k]));
+            sgds.push_back(std::make_unique<SGD>(layers[k], 0.01));
+        }
+        double separate_ms = time_ms([&]() {
+            for (size_t k = 0; k < K; k++) {
+                losses[k]->forward(models[k]->forward(X), Y);
+                models[k]->backward();
+                sgds[k]->step();
+            }
+        }, 20);
+
+        std::vector<std::unique_ptr<Layer>> stacked_layers;
+        std::vector<std::unique_ptr<ActivationFunction>> stacked_activations;
+        std::unique_ptr<LossFunction> stacked_loss = std::make_unique<StackedLoss>(
+            K, []() { return std::make_unique<MeanSquaredError>(); });
+        stacked_layers.emplace_back(std::make_unique<StackedLinear>(K, in, hidden));
+        stacked_layers.emplace_back(std::make_unique<StackedLinear>(K, hidden, out));
+        stacked_activations.emplace_back(std::make_unique<ReLU>());
+        stacked_activations.emplace_back(std::make_unique<Identity>());
+        Model stacked(stacked_layers, stacked_activations, stacked_loss);
+        SGD stacked_sgd(stacked_layers, std::vector<double>(K, 0.01));
+        double stacked_ms = time_ms([&]() {
+            stacked_loss->forward(stacked.forward(X), Y);
+            stacked.backward();
+            stacked_sgd.step();
+        }, 20);
+
+        std::cout << "  " << K << "\t" << N << "\t" << separate_ms << "\t" << stacked_ms
+                  << "\t" << separate_ms / stacked_ms << "x" << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,101 @@
+#include <gtest/gtest.h>
+#include <Eigen/Dense>
+#include "../include/nn/attention.h"
+#include "../include/optim/sgd.h"
+#include <cmath>
+#include <memory>
+#include <vector>
+
+// Reference attention that materializes the T x T scores of every head
+static Eigen::MatrixXd naive_attention(MultiHeadAttention& mha, const Eigen::MatrixXd& A) {
+    size_t T = mha.seq_len_, H = mha.num_heads_, dh = mha.head_dim_;
+    Linear q(mha.query_), k(mha.key_), v(mha.value_), out(mha.output_);
+    Eigen::MatrixXd Q = q.forward(A), K = k.forward(A), V = v.forward(A);
+    Eigen::MatrixXd O(A.rows(), A.cols());
+    for (size_t r0 = 0; r0 < static_cast<size_t>(A.rows()); r0 += T) {
+        for (size_t h = 0; h < H; h++) {
+            Eigen::MatrixXd S = Q.block(r0, h * dh, T, dh) * K.block(r0, h * dh, T, dh).transpose()
+                / std::sqrt(static_cast<double>(dh));
+            for (size_t i = 0; i < T; i++) {
+                Eigen::RowVectorXd e = (S.row(i).array() - S.row(i).maxCoeff()).exp();
+                S.row(i) = e / e.sum();
+            }
+            O.block(r0, h * dh, T, dh) = S * V.block(r0, h * dh, T, dh);
+        }
+    }
+    return out.forward(O);
+}
+
+TEST(MultiHeadAttentionTest, MatchesMaterializedAttention) {
+    // 150 tokens span several blocks, the last one partial
+    MultiHeadAttention mha(8, 2, 150);
+    Eigen::MatrixXd A = Eigen::MatrixXd::Random(300, 8);
+    Eigen::MatrixXd Z = mha.forward(A);
+    ASSERT_EQ(Z.rows(), 300);
+    ASSERT_EQ(Z.cols(), 8);
+    ASSERT_TRUE(Z.isApprox(naive_attention(mha, A), 1e-10));
+}
+
+TEST(MultiHeadAttentionTest, GradientsMatchFiniteDifferences) {
+    MultiHeadAttention mha(6, 3, 70);
+    Eigen::MatrixXd A = Eigen::MatrixXd::Random(140, 6);
+    Eigen::MatrixXd R = Eigen::MatrixXd::Random(140, 6);  // L = sum(R .* Z)
+    auto loss = [&]() { return mha.forward(A).cwiseProduct(R).sum(); };
+
+    mha.forward(A);
+    Eigen::MatrixXd dLdA = mha.backward(R);
+    Eigen::MatrixXd dLdWq = mha.query_.dLdW_;
+    Eigen::MatrixXd dLdbk = mha.key_.dLdb_;
+    Eigen::MatrixXd dLdWv = mha.value_.dLdW_;
+
+    const double eps = 1e-6;
+    auto check = [&](double& x, double expected) {
+        double saved = x;
+        x = saved + eps;
+        double up = loss();
+        x = saved - eps;
+        double down = loss();
+        x = saved;
+        ASSERT_NEAR((up - down) / (2 * eps), expected, 1e-6 * std::max(1.0, std::abs(expected)));
+    };
+    for (Eigen::Index i : {0, 17, 69, 70, 139}) {
+        check(A(i, i % 6), dLdA(i, i % 6));
+    }
+    for (Eigen::Index i = 0; i < 6; i++) {
+        check(mha.query_.W_(i, 5 - i), dLdWq(i, 5 - i));
+        check(mha.key_.b_(i), dLdbk(i));
+        check(mha.value_.W_(i, i), dLdWv(i, i));
+    }
+}
+
+TEST(MultiHeadAttentionTest, SwapCacheRestoresForwardState) {
+    MultiHeadAttention mha(8, 4, 20);
+    Eigen::MatrixXd A1 = Eigen::MatrixXd::Random(40, 8);
+    Eigen::MatrixXd A2 = Eigen::MatrixXd::Random(60, 8);
+    Eigen::MatrixXd dLdZ = Eigen::MatrixXd::Random(40, 8);
+
+    mha.forward(A1);
+    Eigen::MatrixXd expected = mha.backward(dLdZ);
+
+    mha.forward(A1);
+    Layer::Cache cache;
+    mha.swap_cache(cache);
+    ASSERT_EQ(mha.cache_bytes(), 0);
+    mha.forward(A2);
+    mha.swap_cache(cache);
+    ASSERT_TRUE(mha.backward(dLdZ).isApprox(expected, 1e-12));
+}
+
+TEST(MultiHeadAttentionTest, SGDUpdatesProjections) {
+    std::vector<std::unique_ptr<Layer>> layers;
+    layers.emplace_back(std::make_unique<MultiHeadAttention>(4, 2, 5));
+    MultiHeadAttention& mha = static_cast<MultiHeadAttention&>(*layers[0]);
+    Eigen::MatrixXd A = Eigen::MatrixXd::Random(10, 4);
+    mha.forward(A);
+    mha.backward(Eigen::MatrixXd::Ones(10, 4));
+
+    Eigen::MatrixXd expected = mha.query_.W_ - 0.1 * mha.query_.dLdW_;
+    SGD sgd(layers, 0.1);
+    sgd.step();
+    ASSERT_TRUE(mha.query_.W_.isApprox(expected, 1e-12));
+}
@@ -0,0 +1,132 @@
+#include <gtest/gtest.h>
+#include <Eigen/Dense>
+#include "../include/nn/autotune.h"
+#include "../include/nn/model.h"
+#include "../include/utils/parallel.h"
+#include "../include/utils/thread_pool.h"
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+static size_t supported_kernel_count() {
+    size_t count = 0;
+    for (GemmKernel kernel : {GemmKernel::Portable, GemmKernel::AVX2, GemmKernel::AVX512}) {
+        count += gemm_kernel_supported(kernel) ? 1 : 0;
+    }
+    return count;
+}
+
+static TuneOptions quick_options() {
+    TuneOptions options;
+    options.batch_sizes = {4, 16, 64};
+    options.thread_counts = {1, 2};
+    options.min_time_ms = 1.0;
+    return options;
+}
+
+TEST(AutotuneTest, PicksTheFastestSetting) {
+    std::vector<std::unique_ptr<Layer>> layers;
+    std::vector<std::unique_ptr<ActivationFunction>> activations;
+    std::unique_ptr<LossFunction> loss = std::make_unique<MeanSquaredError>();
+    layers.emplace_back(std::make_unique<Linear>(8, 16));
+    layers.emplace_back(std::make_unique<Linear>(16, 2));
+    activations.emplace_back(std::make_unique<ReLU>());
+    Model model(layers, activations, loss);
+    Eigen::MatrixXd X = Eigen::MatrixXd::Random(10, 8);
+    Eigen::MatrixXd Y = Eigen::MatrixXd::Random(10, 2);
+    Eigen::MatrixXd W = layers[0]->W_;
+    GemmBackend backend = gemm_backend();
+    GemmKernel kernel = gemm_kernel();
+    size_t threads = num_threads();
+
+    TuneOptions options = quick_options();
+    options.backends = {GemmBackend::Eigen, GemmBackend::Packed};
+    TuneResult result = autotune(model, X, Y, options);
+
+    // Every supported packed kernel is tried as its own setting
+    ASSERT_EQ(result.measurements.size(), (1 + supported_kernel_count()) * 2 * 3);
+    std::vector<bool> tried(3, false);
+    for (const TuneProfile& profile : result.measurements) {
+        ASSERT_GT(profile.latency_ms, 0.0);
+        ASSERT_LE(profile.samples_per_sec, result.best.samples_per_sec);
+        if (profile.backend == GemmBackend::Packed) {
+            tried[static_cast<size_t>(profile.kernel)] = true;
+        }
+    }
+    for (GemmKernel k : {GemmKernel::Portable, GemmKernel::AVX2, GemmKernel::AVX512}) {
+        ASSERT_EQ(tried[static_cast<size_t>(k)], gemm_kernel_supported(k));
+    }
+    // Tuning leaves the model and the global settings as they were
+    ASSERT_TRUE(layers[0]->W_.isApprox(W));
+    ASSERT_EQ(gemm_backend(), backend);
+    ASSERT_EQ(gemm_kernel(), kernel);
+    ASSERT_EQ(num_threads(), threads);
+}
+
+TEST(AutotuneTest, RespectsConstraints) {
+    std::vector<std::unique_ptr<Layer>> layers;
+    std::vector<std::unique_ptr<ActivationFunction>> activations;
+    std::unique_ptr<LossFunction> loss = std::make_unique<MeanSquaredError>();
+    layers.emplace_back(std::make_unique<Linear>(32, 32));
+    Model model(layers, activations, loss);
+    Eigen::MatrixXd X = Eigen::MatrixXd::Random(4, 32);
+
+    TuneOptions options = quick_options();
+    options.training = false;
+    options.objective = TuneObjective::Latency;
+    TuneResult result = autotune(model, X, Eigen::MatrixXd(), options);
+    for (const TuneProfile& profile : result.measurements) {
+        ASSERT_GE(profile.latency_ms, result.best.latency_ms);
+    }
+    ASSERT_FALSE(result.best.training);
+
+    // The most throughput among the settings fast enough per batch. The bound
+    // leaves room for timing noise between the two runs
+    options.objective = TuneObjective::Throughput;
+    options.max_latency_ms = result.best.latency_ms * 4;
+    TuneResult bounded = autotune(model, X, Eigen::MatrixXd(), options);
+    ASSERT_LE(bounded.best.latency_ms, options.max_latency_ms);
+
+    options.max_latency_ms = 1e-9;
+    ASSERT_THROW(autotune(model, X, Eigen::MatrixXd(), options), std::runtime_error);
+}
+
+TEST(AutotuneTest, ProfileRoundTrip) {
+    TuneProfile profile;
+    profile.batch_size = 64;
+    profile.num_threads = 3;
+    profile.backend = GemmBackend::Packed;
+    profile.kernel = GemmKernel::Portable;
+    profile.training = false;
+    profile.latency_ms = 1.25;
+    profile.samples_per_sec = 51200;
+    const char* path = "autotune_test.tune";
+
+    save_profile(path, profile);
+    TuneProfile loaded = load_profile(path);
+    ASSERT_EQ(loaded.batch_size, 64);
+    ASSERT_EQ(loaded.num_threads, 3);
+    ASSERT_EQ(loaded.backend, GemmBackend::Packed);
+    ASSERT_EQ(loaded.kernel, GemmKernel::Portable);
+    ASSERT_FALSE(loaded.training);
+    ASSERT_DOUBLE_EQ(loaded.latency_ms, 1.25);
+    ASSERT_DOUBLE_EQ(loaded.samples_per_sec, 51200);
+
+    GemmBackend backend = gemm_backend();
+    GemmKernel kernel = gemm_kernel();
+    size_t threads = num_threads();
+    apply_profile(loaded);
+    ASSERT_EQ(gemm_backend(), GemmBackend::Packed);
+    ASSERT_EQ(gemm_kernel(), GemmKernel::Portable);
+    ASSERT_EQ(num_threads(), 3);
+    set_gemm_backend(backend);
+    set_gemm_kernel(kernel);
+    ThreadPool::configure(threads);
+
+    std::ofstream(path) << "batch_size=64\nnum_threads=two\n";
+    ASSERT_THROW(load_profile(path), std::runtime_error);
+    std::remove(path);
+    ASSERT_THROW(load_profile(path), std::runtime_error);
+}
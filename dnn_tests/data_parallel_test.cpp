@@ -0,0 +1,187 @@
+#include <gtest/gtest.h>
+#include <Eigen/Dense>
+#include "../include/dist/allreduce.h"
+#include "../include/dist/data_parallel.h"
+#include "../include/nn/model.h"
+#include "../include/optim/sgd.h"
+#include "../include/utils/parallel.h"
+#include "../include/utils/thread_pool.h"
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include <csignal>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/**
+ * Runs fn(rank) in world_size processes: ranks 1.. in forked children and
+ * rank 0 in the test process. Returns true if every rank returned true. The
+ * global thread pool is shrunk to the calling thread while forking, so that
+ * no worker can hold a lock that the children would inherit.
+ */
+static bool run_ranks(size_t world_size, const std::function<bool(size_t)>& fn) {
+    size_t threads = num_threads();
+    ThreadPool::configure(1);
+    std::vector<pid_t> children;
+    for (size_t rank = 1; rank < world_size; rank++) {
+        pid_t pid = fork();
+        if (pid == 0) {
+            _exit(fn(rank) ? 0 : 1);
+        }
+        children.push_back(pid);
+    }
+    bool ok = fn(0);
+    for (pid_t pid : children) {
+        int status = 0;
+        waitpid(pid, &status, 0);
+        ok = ok && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    }
+    ThreadPool::configure(threads);
+    return ok;
+}
+
+static std::string segment_name(const char* test) {
+    return std::string("/dnn_cpp_") + test + "_" + std::to_string(getpid());
+}
+
+TEST(ShmAllReduceTest, SumMeanAndBroadcast) {
+    const size_t world_size = 3;
+    std::string name = segment_name("collectives");
+    bool ok = run_ranks(world_size, [&](size_t rank) {
+        // A tiny capacity forces the buffers to be reduced in several pieces
+        ShmAllReduce comm(name, rank, world_size, 7);
+        std::vector<double> data(20);
+        for (size_t k = 0; k < data.size(); k++) {
+            data[k] = rank * 100.0 + k;
+        }
+        comm.allreduce_sum(data.data(), data.size());
+        bool ok = true;
+        for (size_t k = 0; k < data.size(); k++) {
+            ok = ok && data[k] == 300.0 + 3.0 * k;
+        }
+
+        std::vector<double> mean(5, static_cast<double>(rank));
+        comm.allreduce_mean(mean.data(), mean.size());
+        for (double v : mean) {
+            ok = ok && v == 1.0;
+        }
+
+        std::vector<double> root(9, static_cast<double>(rank + 1));
+        comm.broadcast(root.data(), root.size(), 2);
+        for (double v : root) {
+            ok = ok && v == 3.0;
+        }
+        return ok;
+    });
+    ASSERT_TRUE(ok);
+}
+
+TEST(ShmAllReduceTest, ReplacesSegmentOfDeadRun) {
+    // A rank 0 that dies while waiting for the other ranks leaves its segment
+    // behind, with one rank counted as arrived at the barrier
+    std::string name = segment_name("stale");
+    pid_t dead = fork();
+    if (dead == 0) {
+        ShmAllReduce comm(name, 0, 2);
+        _exit(0);
+    }
+    usleep(50000);
+    kill(dead, SIGKILL);
+    waitpid(dead, nullptr, 0);
+
+    bool ok = run_ranks(2, [&](size_t rank) {
+        ShmAllReduce comm(name, rank, 2);
+        std::vector<double> data(4, static_cast<double>(rank + 1));
+        comm.allreduce_sum(data.data(), data.size());
+        return data[0] == 3.0 && data[3] == 3.0;
+    });
+    ASSERT_TRUE(ok);
+}
+
+TEST(DataParallelTest, AveragedGradientsMatchFullBatch) {
+    const size_t world_size = 2;
+    const size_t shard = 8;
+    std::vector<std::unique_ptr<Layer>> layers;
+    std::vector<std::unique_ptr<ActivationFunction>> activations;
+    std::unique_ptr<LossFunction> loss = std::make_unique<MeanSquaredError>();
+    layers.emplace_back(std::make_unique<Linear>(4, 16));
+    layers.emplace_back(std::make_unique<Linear>(16, 16));
+    layers.emplace_back(std::make_unique<Linear>(16, 3));
+    activations.emplace_back(std::make_unique<Tanh>());
+    activations.emplace_back(std::make_unique<ReLU>());
+    Model model(layers, activations, loss);
+
+    Eigen::MatrixXd X = Eigen::MatrixXd::Random(world_size * shard, 4);
+    Eigen::MatrixXd Y = Eigen::MatrixXd::Random(world_size * shard, 3);
+
+    // Reference: one optimizer step on the full batch in a single process
+    std::vector<Eigen::MatrixXd> W_start;
+    for (auto& layer : layers) {
+        W_start.push_back(layer->W_);
+    }
+    loss->forward(model.forward(X), Y);
+    model.backward();
+    std::vector<Eigen::MatrixXd> expected_dLdW;
+    for (auto& layer : layers) {
+        expected_dLdW.push_back(layer->dLdW_);
+    }
+
+    std::string name = segment_name("ddp");
+    bool ok = run_ranks(world_size, [&](size_t rank) {
+        ShmAllReduce comm(name, rank, world_size);
+        // Small buckets, so that several reductions overlap the backward pass
+        DataParallel ddp(model, comm, 64);
+
+        // Start from different weights; the broadcast must undo this
+        for (size_t i = 0; i < layers.size(); i++) {
+            layers[i]->W_ = W_start[i].array() + static_cast<double>(rank);
+        }
+        ddp.broadcast_parameters();
+
+        loss->forward(model.forward(X.middleRows(rank * shard, shard)),
+                      Y.middleRows(rank * shard, shard));
+        ddp.backward();
+
+        bool ok = true;
+        for (size_t i = 0; i < layers.size(); i++) {
+            ok = ok && layers[i]->dLdW_.isApprox(expected_dLdW[i], 1e-10);
+        }
+        SGD sgd(layers, 0.1);
+        sgd.step();
+        for (size_t i = 0; i < layers.size(); i++) {
+            ok = ok && layers[i]->W_.isApprox(W_start[i] - 0.1 * expected_dLdW[i], 1e-10);
+        }
+        return ok;
+    });
+    ASSERT_TRUE(ok);
+}
+
+TEST(DataParallelTest, BroadcastsCompressedLayers) {
+    // HalfLinear and SparseLinear keep their weights outside W_
+    Linear dense(6, 5), pruned(5, 3);
+    pruned.W_ = (pruned.W_.array().abs() > 0.5).select(pruned.W_, 0.0);
+    HalfLinear half(dense);
+    SparseLinear sparse(pruned);
+    Eigen::MatrixXd half_W = half.dense(), sparse_W = sparse.dense();
+
+    std::string name = segment_name("compressed");
+    bool ok = run_ranks(2, [&](size_t rank) {
+        std::vector<std::unique_ptr<Layer>> layers;
+        std::vector<std::unique_ptr<ActivationFunction>> activations;
+        std::unique_ptr<LossFunction> loss = std::make_unique<MeanSquaredError>();
+        layers.emplace_back(half.clone());
+        layers.emplace_back(sparse.clone());
+        if (rank != 0) {
+            layers[0]->set_weights(Eigen::MatrixXd::Random(5, 6));
+            layers[1]->set_weights(Eigen::MatrixXd::Random(3, 5));
+        }
+        Model model(layers, activations, loss);
+        ShmAllReduce comm(name, rank, 2);
+        DataParallel ddp(model, comm);
+        ddp.broadcast_parameters();
+        return layers[0]->weights() == half_W && layers[1]->weights() == sparse_W
+            && dynamic_cast<SparseLinear&>(*layers[1]).nnz() == sparse.nnz();
+    });
+    ASSERT_TRUE(ok);
+}
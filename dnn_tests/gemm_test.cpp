@@ -0,0 +1,108 @@
+#include <gtest/gtest.h>
+#include <Eigen/Dense>
+#include "../include/nn/layer.h"
+#include "../include/utils/gemm.h"
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+static std::vector<GemmBackend> available_backends() {
+    std::vector<GemmBackend> backends;
+    for (GemmBackend backend : {GemmBackend::Eigen, GemmBackend::Cblas, GemmBackend::Packed}) {
+        if (gemm_backend_available(backend)) {
+            backends.push_back(backend);
+        }
+    }
+    return backends;
+}
+
+static std::vector<GemmKernel> supported_kernels() {
+    std::vector<GemmKernel> kernels;
+    for (GemmKernel kernel : {GemmKernel::Portable, GemmKernel::AVX2, GemmKernel::AVX512}) {
+        if (gemm_kernel_supported(kernel)) {
+            kernels.push_back(kernel);
+        }
+    }
+    return kernels;
+}
+
+TEST(GemmTest, BackendsMatchReference) {
+    // Shapes that are not multiples of any micro-kernel tile or cache block
+    const size_t shapes[][3] = {{1, 1, 1}, {7, 5, 3}, {33, 19, 300}, {130, 27, 9}, {17, 4100, 2}};
+    for (const auto& shape : shapes) {
+        size_t M = shape[0], N = shape[1], K = shape[2];
+        for (bool trans_a : {false, true}) {
+            for (bool trans_b : {false, true}) {
+                Eigen::MatrixXd A = trans_a ? Eigen::MatrixXd::Random(K, M) : Eigen::MatrixXd::Random(M, K);
+                Eigen::MatrixXd B = trans_b ? Eigen::MatrixXd::Random(N, K) : Eigen::MatrixXd::Random(K, N);
+                Eigen::MatrixXd C0 = Eigen::MatrixXd::Random(M, N);
+                Eigen::MatrixXd opA = trans_a ? Eigen::MatrixXd(A.transpose()) : A;
+                Eigen::MatrixXd opB = trans_b ? Eigen::MatrixXd(B.transpose()) : B;
+                Eigen::MatrixXd expected = 0.5 * opA * opB - 2.0 * C0;
+
+                for (GemmBackend backend : available_backends()) {
+                    Eigen::MatrixXd C = C0;
+                    gemm(trans_a, trans_b, M, N, K, 0.5, A.data(), A.rows(), B.data(), B.rows(),
+                         -2.0, C.data(), C.rows(), backend);
+                    ASSERT_TRUE(C.isApprox(expected, 1e-12)) << gemm_backend_name(backend);
+                }
+                for (GemmKernel kernel : supported_kernels()) {
+                    set_gemm_kernel(kernel);
+                    Eigen::MatrixXd C = C0;
+                    gemm(trans_a, trans_b, M, N, K, 0.5, A.data(), A.rows(), B.data(), B.rows(),
+                         -2.0, C.data(), C.rows(), GemmBackend::Packed);
+                    ASSERT_TRUE(C.isApprox(expected, 1e-12)) << gemm_kernel_name(kernel);
+                }
+                set_gemm_kernel(detect_gemm_kernel());
+            }
+        }
+    }
+}
+
+TEST(GemmTest, ZeroBetaIgnoresOutput) {
+    Eigen::MatrixXd A = Eigen::MatrixXd::Random(9, 4);
+    Eigen::MatrixXd B = Eigen::MatrixXd::Random(4, 6);
+    for (GemmBackend backend : available_backends()) {
+        Eigen::MatrixXd C = Eigen::MatrixXd::Constant(9, 6, std::nan(""));
+        gemm(false, false, 9, 6, 4, 1.0, A.data(), 9, B.data(), 4, 0.0, C.data(), 9, backend);
+        ASSERT_TRUE(C.isApprox(A * B, 1e-12)) << gemm_backend_name(backend);
+    }
+}
+
+TEST(GemmTest, LinearIsBackendIndependent) {
+    Linear linear(37, 23);
+    Eigen::MatrixXd A = Eigen::MatrixXd::Random(29, 37);
+    Eigen::MatrixXd dLdZ = Eigen::MatrixXd::Random(29, 23);
+
+    set_gemm_backend(GemmBackend::Eigen);
+    Eigen::MatrixXd Z = linear.forward(A);
+    Eigen::MatrixXd dLdA = linear.backward(dLdZ);
+    Eigen::MatrixXd dLdW = linear.dLdW_;
+    Eigen::MatrixXd dLdb = linear.dLdb_;
+
+    for (GemmBackend backend : available_backends()) {
+        set_gemm_backend(backend);
+        ASSERT_TRUE(linear.forward(A).isApprox(Z, 1e-12)) << gemm_backend_name(backend);
+        ASSERT_TRUE(linear.backward(dLdZ).isApprox(dLdA, 1e-12)) << gemm_backend_name(backend);
+        ASSERT_TRUE(linear.dLdW_.isApprox(dLdW, 1e-12)) << gemm_backend_name(backend);
+        ASSERT_TRUE(linear.dLdb_.isApprox(dLdb, 1e-12)) << gemm_backend_name(backend);
+    }
+    set_gemm_backend(GemmBackend::Eigen);
+}
+
+TEST(GemmTest, KernelSelection) {
+    ASSERT_TRUE(gemm_kernel_supported(GemmKernel::Portable));
+    ASSERT_TRUE(gemm_kernel_supported(detect_gemm_kernel()));
+    ASSERT_EQ(gemm_kernel(), detect_gemm_kernel());
+
+    set_gemm_kernel(GemmKernel::Portable);
+    ASSERT_EQ(gemm_kernel(), GemmKernel::Portable);
+    ASSERT_STREQ(gemm_backend_name(GemmBackend::Packed), "packed-portable");
+    for (GemmKernel kernel : {GemmKernel::AVX2, GemmKernel::AVX512}) {
+        if (!gemm_kernel_supported(kernel)) {
+            ASSERT_THROW(set_gemm_kernel(kernel), std::invalid_argument);
+            ASSERT_EQ(gemm_kernel(), GemmKernel::Portable);
+        }
+    }
+    set_gemm_kernel(detect_gemm_kernel());
+}
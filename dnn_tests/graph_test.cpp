@@ -0,0 +1,225 @@
+#include <gtest/gtest.h>
+#include <Eigen/Dense>
+#include "../include/nn/graph.h"
+#include "../include/nn/model.h"
+#include <functional>
+#include <memory>
+#include <vector>
+
+/**
+ * Checks the gradient the graph computed for layer.W_ against central finite
+ * differences of loss(graph.forward(X)).
+ */
+static void check_gradient(Graph& graph, Layer& layer, const Eigen::MatrixXd& X,
+                           const Eigen::MatrixXd& Y) {
+    MeanSquaredError loss;
+    loss.forward(graph.forward({X}), Y);
+    graph.backward(loss);
+    Eigen::MatrixXd dLdW = layer.dLdW_;
+
+    const double h = 1e-6;
+    for (int r = 0; r < layer.W_.rows(); r++) {
+        for (int c = 0; c < layer.W_.cols(); c++) {
+            double w = layer.W_(r, c);
+            layer.W_(r, c) = w + h;
+            double plus = loss.forward(graph.forward({X}), Y);
+            layer.W_(r, c) = w - h;
+            double minus = loss.forward(graph.forward({X}), Y);
+            layer.W_(r, c) = w;
+            ASSERT_NEAR(dLdW(r, c), (plus - minus) / (2 * h), 1e-6);
+        }
+    }
+}
+
+TEST(GraphTest, ChainMatchesModel) {
+    std::vector<std::unique_ptr<Layer>> layers;
+    std::vector<std::unique_ptr<ActivationFunction>> activations;
+    std::unique_ptr<LossFunction> loss = std::make_unique<SoftmaxCrossEntropy>();
+    layers.emplace_back(std::make_unique<Linear>(5, 8));
+    layers.emplace_back(std::make_unique<Linear>(8, 4));
+    layers.emplace_back(std::make_unique<Linear>(4, 3));
+    activations.emplace_back(std::make_unique<ReLU>());
+    activations.emplace_back(std::make_unique<Sigmoid>());
+    Model model(layers, activations, loss);
+
+    Graph graph;
+    Graph::Value x = graph.input(5);
+    x = graph.activation(*activations[0], graph.layer(*layers[0], x));
+    x = graph.activation(*activations[1], graph.layer(*layers[1], x));
+    graph.layer(*layers[2], x);
+
+    Eigen::MatrixXd X = Eigen::MatrixXd::Random(6, 5);
+    Eigen::MatrixXd Y = Eigen::MatrixXd::Identity(6, 3);
+
+    loss->forward(model.forward(X), Y);
+    model.backward();
+    std::vector<Eigen::MatrixXd> dLdW;
+    for (auto& layer : layers) {
+        dLdW.push_back(layer->dLdW_);
+    }
+
+    Eigen::MatrixXd out = graph.forward({X});
+    ASSERT_TRUE(out.isApprox(model.forward(X), 1e-12));
+    loss->forward(out, Y);
+    graph.backward(*loss);
+    for (size_t i = 0; i < layers.size(); i++) {
+        ASSERT_TRUE(layers[i]->dLdW_.isApprox(dLdW[i], 1e-12));
+    }
+}
+
+TEST(GraphTest, ResidualConnection) {
+    Linear in(3, 6), block(6, 6), out(6, 2);
+    Tanh tanh1, tanh2;
+    Graph graph;
+    Graph::Value h = graph.activation(tanh1, graph.layer(in, graph.input(3)));
+    Graph::Value r = graph.add(h, graph.activation(tanh2, graph.layer(block, h)));
+    graph.layer(out, r);
+
+    Eigen::MatrixXd X = Eigen::MatrixXd::Random(4, 3);
+    Eigen::MatrixXd Y = Eigen::MatrixXd::Random(4, 2);
+    check_gradient(graph, in, X, Y);
+    check_gradient(graph, block, X, Y);
+}
+
+TEST(GraphTest, SharedLayerAndBranches) {
+    // The same layer and activation object are applied twice, and two
+    // branches are merged with a concat
+    Linear shared(4, 4), left(4, 3), head(5, 2);
+    Linear right(4, 2);
+    Sigmoid sigmoid;
+    Graph graph;
+    Graph::Value x = graph.input(4);
+    Graph::Value h = graph.activation(sigmoid, graph.layer(shared, x));
+    h = graph.activation(sigmoid, graph.layer(shared, h));
+    Graph::Value merged = graph.concat(graph.layer(left, h), graph.layer(right, x));
+    graph.layer(head, merged);
+
+    Eigen::MatrixXd X = Eigen::MatrixXd::Random(5, 4);
+    Eigen::MatrixXd Y = Eigen::MatrixXd::Random(5, 2);
+    check_gradient(graph, shared, X, Y);
+    check_gradient(graph, right, X, Y);
+}
+
+TEST(GraphTest, SharedEmbedding) {
+    // One table looks up two index inputs; the rows both use, and the rows
+    // only one of them uses, must all get their gradient
+    Embedding embedding(6, 3);
+    Linear head(6, 2);
+    Graph graph;
+    Graph::Value a = graph.layer(embedding, graph.input(2));
+    Graph::Value b = graph.layer(embedding, graph.input(2));
+    graph.layer(head, graph.add(a, b));
+
+    Eigen::MatrixXd X1(3, 2), X2(3, 2);
+    X1 << 0, 1,
+          2, 1,
+          4, 0;
+    X2 << 1, 3,
+          5, 2,
+          3, 3;
+    Eigen::MatrixXd Y = Eigen::MatrixXd::Random(3, 2);
+    MeanSquaredError loss;
+    loss.forward(graph.forward({X1, X2}), Y);
+    graph.backward(loss);
+    Eigen::MatrixXd dLdW = Eigen::MatrixXd::Zero(embedding.W_.rows(), embedding.W_.cols());
+    for (size_t s = 0; s < embedding.sparse_indices_.size(); s++) {
+        dLdW.col(embedding.sparse_indices_[s]) += embedding.sparse_values_.col(s);
+    }
+    ASSERT_EQ(embedding.sparse_indices_.size(), 6);
+
+    const double h = 1e-6;
+    for (int r = 0; r < embedding.W_.rows(); r++) {
+        for (int c = 0; c < embedding.W_.cols(); c++) {
+            double w = embedding.W_(r, c);
+            embedding.W_(r, c) = w + h;
+            double plus = loss.forward(graph.forward({X1, X2}), Y);
+            embedding.W_(r, c) = w - h;
+            double minus = loss.forward(graph.forward({X1, X2}), Y);
+            embedding.W_(r, c) = w;
+            ASSERT_NEAR(dLdW(r, c), (plus - minus) / (2 * h), 1e-6);
+        }
+    }
+}
+
+TEST(GraphTest, MultipleInputs) {
+    Linear a(2, 3), b(4, 3), head(3, 1);
+    Graph graph;
+    Graph::Value x1 = graph.input(2);
+    Graph::Value x2 = graph.input(4);
+    graph.layer(head, graph.add(graph.layer(a, x1), graph.layer(b, x2)));
+
+    Eigen::MatrixXd X1 = Eigen::MatrixXd::Random(3, 2);
+    Eigen::MatrixXd X2 = Eigen::MatrixXd::Random(3, 4);
+    Eigen::MatrixXd expected = head.forward(a.forward(X1) + b.forward(X2));
+    ASSERT_TRUE(graph.forward({X1, X2}).isApprox(expected, 1e-12));
+}
+
+TEST(GraphTest, MemoryPlanReusesBuffers) {
+    const size_t depth = 16;
+    std::vector<std::unique_ptr<Linear>> layers;
+    std::vector<std::unique_ptr<ReLU>> activations;
+    Graph graph;
+    Graph::Value x = graph.input(32);
+    for (size_t i = 0; i < depth; i++) {
+        layers.emplace_back(std::make_unique<Linear>(32, 32));
+        activations.emplace_back(std::make_unique<ReLU>());
+        x = graph.activation(*activations.back(), graph.layer(*layers.back(), x));
+    }
+
+    Eigen::MatrixXd X = Eigen::MatrixXd::Random(10, 32);
+    Eigen::MatrixXd out = graph.forward({X});
+    graph.backward(Eigen::MatrixXd::Ones(10, 32));
+
+    // Unplanned, the input and every value and gradient have their own buffer.
+    // Planned, only the input and the ReLU outputs stay alive for backward,
+    // next to at most one pre-activation or two gradients.
+    size_t buffer = 10 * 32 * sizeof(double);
+    ASSERT_EQ(graph.unplanned_bytes(), (1 + 4 * depth) * buffer);
+    ASSERT_LE(graph.planned_bytes(), (depth + 3) * buffer);
+    ASSERT_EQ(graph.cache_bytes(), 0u);
+
+    // A second run with a different batch size is planned again
+    graph.forward({Eigen::MatrixXd::Random(3, 32)});
+    ASSERT_LE(graph.planned_bytes(), (depth + 3) * 3 * 32 * sizeof(double));
+}
+
+TEST(GraphTest, PeakMemoryBelowModel) {
+    const size_t depth = 8, N = 64;
+    std::vector<std::unique_ptr<Layer>> layers;
+    std::vector<std::unique_ptr<ActivationFunction>> activations;
+    std::unique_ptr<LossFunction> loss = std::make_unique<MeanSquaredError>();
+    for (size_t i = 0; i < depth; i++) {
+        layers.emplace_back(std::make_unique<Linear>(i == 0 ? 16 : 48, 48));
+        activations.emplace_back(std::make_unique<Tanh>());
+    }
+    Model model(layers, activations, loss);
+
+    Graph graph;
+    Graph::Value x = graph.input(16);
+    for (size_t i = 0; i < depth; i++) {
+        x = graph.activation(*activations[i], graph.layer(*layers[i], x));
+    }
+
+    Eigen::MatrixXd X = Eigen::MatrixXd::Random(N, 16);
+    Eigen::MatrixXd Y = Eigen::MatrixXd::Random(N, 48);
+    loss->forward(model.forward(X), Y);
+    model.backward();
+    std::vector<Eigen::MatrixXd> expected;
+    for (const std::unique_ptr<Layer>& layer : layers) {
+        expected.push_back(layer->dLdW_);
+    }
+
+    MeanSquaredError graph_loss;
+    graph_loss.forward(graph.forward({X}), Y);
+    size_t graph_peak = graph.planned_bytes() + graph.cache_bytes();
+    graph.backward(graph_loss);
+    for (size_t i = 0; i < depth; i++) {
+        ASSERT_TRUE(layers[i]->dLdW_.isApprox(expected[i], 1e-10));
+    }
+
+    // The arena holds the saved state, every intermediate value and every
+    // gradient, and is still smaller than the state Model alone keeps
+    // (a copy of each layer's input and each activation's output)
+    ASSERT_GT(model.peak_cache_bytes_, 0u);
+    ASSERT_LT(graph_peak, model.peak_cache_bytes_);
+}
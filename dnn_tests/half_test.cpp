@@ -0,0 +1,132 @@
+#include <gtest/gtest.h>
+#include <Eigen/Dense>
+#include "../include/nn/half.h"
+#include "../include/nn/layer.h"
+#include "../include/nn/model.h"
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <vector>
+
+TEST(HalfTest, KnownConversions) {
+    EXPECT_EQ(float_to_half(1.0f, HalfFormat::Float16), 0x3c00);
+    EXPECT_EQ(float_to_half(-2.0f, HalfFormat::Float16), 0xc000);
+    EXPECT_EQ(float_to_half(65504.0f, HalfFormat::Float16), 0x7bff);
+    EXPECT_EQ(float_to_half(1e6f, HalfFormat::Float16), 0x7c00);
+    EXPECT_EQ(float_to_half(5.9604645e-8f, HalfFormat::Float16), 0x0001);
+    EXPECT_EQ(float_to_half(1.0f, HalfFormat::BFloat16), 0x3f80);
+    EXPECT_EQ(float_to_half(-2.0f, HalfFormat::BFloat16), 0xc000);
+
+    // 1 + 2^-8 is exactly between two bfloat16 values and rounds to even
+    EXPECT_EQ(float_to_half(1.00390625f, HalfFormat::BFloat16), 0x3f80);
+    EXPECT_EQ(float_to_half(1.01171875f, HalfFormat::BFloat16), 0x3f82);
+
+    EXPECT_TRUE(std::isnan(half_to_float(float_to_half(std::nanf(""), HalfFormat::Float16), HalfFormat::Float16)));
+    EXPECT_TRUE(std::isnan(half_to_float(float_to_half(std::nanf(""), HalfFormat::BFloat16), HalfFormat::BFloat16)));
+}
+
+TEST(HalfTest, RoundTripIsExact) {
+    for (uint32_t h = 0; h < 0x10000; h++) {
+        uint16_t bits = static_cast<uint16_t>(h);
+        float f16 = half_to_float(bits, HalfFormat::Float16);
+        if (!std::isnan(f16)) {
+            ASSERT_EQ(float_to_half(f16, HalfFormat::Float16), bits);
+        }
+        float bf16 = half_to_float(bits, HalfFormat::BFloat16);
+        if (!std::isnan(bf16)) {
+            ASSERT_EQ(float_to_half(bf16, HalfFormat::BFloat16), bits);
+        }
+    }
+}
+
+TEST(HalfTest, KernelsAgree) {
+    const size_t N = 7, K = 37, M = 11;
+    std::vector<float> A(N * K), b(M);
+    std::vector<uint16_t> W(M * K);
+    for (size_t i = 0; i < A.size(); i++) A[i] = std::sin(0.37f * i);
+    for (size_t i = 0; i < W.size(); i++) W[i] = float_to_half(std::cos(0.11f * i), HalfFormat::BFloat16);
+    for (size_t i = 0; i < M; i++) b[i] = 0.1f * i;
+
+    std::vector<float> expected(N * M), Z(N * M);
+    half_gemm(A.data(), W.data(), b.data(), expected.data(), N, K, M,
+              HalfFormat::BFloat16, HalfIsa::Portable);
+
+    std::vector<HalfIsa> isas = {HalfIsa::Portable};
+    if (detect_half_isa() == HalfIsa::AVX512) isas = {HalfIsa::AVX2, HalfIsa::AVX512};
+    if (detect_half_isa() == HalfIsa::AVX2) isas = {HalfIsa::AVX2};
+    for (HalfIsa isa : isas) {
+        half_gemm(A.data(), W.data(), b.data(), Z.data(), N, K, M, HalfFormat::BFloat16, isa);
+        for (size_t i = 0; i < Z.size(); i++) {
+            ASSERT_NEAR(Z[i], expected[i], 1e-4);
+        }
+    }
+}
+
+/**
+ * Each weight carries a relative rounding error of at most 2^-8 (bfloat16)
+ * or 2^-11 (float16), and the input and the float sums add about 2^-23 each.
+ * So |Z - Z_ref| <= (u + K * 2^-23) * |A| * |W|^T, elementwise.
+ */
+static void check_error_bound(HalfFormat format, double u) {
+    const size_t N = 16, K = 300, M = 40;
+    Linear linear(K, M);
+    Eigen::MatrixXd A = Eigen::MatrixXd::Random(N, K);
+    Eigen::MatrixXd expected = linear.forward(A);
+
+    HalfLinear half(linear, format);
+    Eigen::MatrixXd Z = half.forward(A);
+
+    Eigen::MatrixXd bound = (u + K * std::pow(2.0, -23)) * (A.cwiseAbs() * linear.W_.cwiseAbs().transpose());
+    bound.array() += 1e-6;
+    ASSERT_TRUE(((Z - expected).cwiseAbs().array() <= bound.array()).all());
+
+    // The error actually comes from the weight rounding, not from a wrong kernel
+    Linear rounded(K, M);
+    rounded.W_ = half.dense();
+    rounded.b_ = linear.b_;
+    ASSERT_TRUE(Z.isApprox(rounded.forward(A), 1e-5));
+}
+
+TEST(HalfLinearTest, BFloat16ErrorBound) {
+    check_error_bound(HalfFormat::BFloat16, std::pow(2.0, -8));
+}
+
+TEST(HalfLinearTest, Float16ErrorBound) {
+    check_error_bound(HalfFormat::Float16, std::pow(2.0, -11));
+}
+
+TEST(HalfLinearTest, BackwardMatchesLinear) {
+    Linear linear(8, 5);
+    HalfLinear half(linear, HalfFormat::Float16, true);
+    ASSERT_EQ(half.W_.size(), 0);
+    ASSERT_EQ(half.W_half_.size(), 40);
+
+    Eigen::MatrixXd A = Eigen::MatrixXd::Random(6, 8);
+    Eigen::MatrixXd dLdZ = Eigen::MatrixXd::Random(6, 5);
+    linear.forward(A);
+    half.forward(A);
+    Eigen::MatrixXd expected_dLdA = linear.backward(dLdZ);
+    Eigen::MatrixXd dLdA = half.backward(dLdZ);
+
+    ASSERT_TRUE(dLdA.isApprox(expected_dLdA, 1e-2));
+    ASSERT_TRUE(half.dLdW_.isApprox(linear.dLdW_, 1e-2));
+    ASSERT_TRUE(half.dLdb_.isApprox(linear.dLdb_, 1e-12));
+}
+
+TEST(HalfLinearTest, ModelCountsHalfCache) {
+    std::vector<std::unique_ptr<Layer>> layers;
+    std::vector<std::unique_ptr<ActivationFunction>> activations;
+    std::unique_ptr<LossFunction> loss = std::make_unique<MeanSquaredError>();
+    for (size_t i = 0; i < 4; i++) {
+        layers.emplace_back(std::make_unique<HalfLinear>(Linear(8, 8), HalfFormat::BFloat16, true));
+    }
+    Model model(layers, activations, loss);
+    model.set_checkpoints({2});
+
+    // Each layer keeps its 6 x 8 input in 16 bits; with checkpoints only the
+    // last segment's caches and the input of the first segment remain
+    model.forward(Eigen::MatrixXd::Random(6, 8));
+    size_t half_input = 6 * 8 * sizeof(uint16_t);
+    ASSERT_EQ(model.cache_bytes(), 2 * half_input + 6 * 8 * sizeof(double));
+    ASSERT_GE(model.peak_cache_bytes_, 2 * half_input + 6 * 8 * sizeof(double));
+}
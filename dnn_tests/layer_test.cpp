@@ -1,7 +1,11 @@
 #include <gtest/gtest.h>
 #include <Eigen/Dense>
+#include "../include/nn/activation.h"
 #include "../include/nn/layer.h"
+#include <cmath>
 #include <iostream>
+#include <memory>
+#include <stdexcept>
 
 TEST(LinearTest, Forward) {
     // Will initially be random, but we set it to a known value for testing
@@ -82,3 +86,137 @@ TEST(LinearTest, Backward) {
     ASSERT_TRUE(linear.dLdb_.isApprox(expected_dLdb, 1e-12));
 }
 
+
+TEST(EmbeddingTest, Forward) {
+    Embedding embedding(4, 2);
+    embedding.W_ = Eigen::MatrixXd(2, 4);
+    embedding.W_ << 0.0, 1.0, 2.0, 3.0,
+                    4.0, 5.0, 6.0, 7.0;
+
+    // Two samples with two categorical fields each
+    Eigen::MatrixXd A(2, 2);
+    A << 3, 0,
+         1, 1;
+
+    Eigen::MatrixXd Z = embedding.forward(A);
+
+    Eigen::MatrixXd expected_Z(2, 4);
+    expected_Z << 3.0, 7.0, 0.0, 4.0,
+                  1.0, 5.0, 1.0, 5.0;
+
+    ASSERT_TRUE(Z.isApprox(expected_Z, 1e-12));
+}
+
+TEST(EmbeddingTest, Backward) {
+    Embedding embedding(4, 2);
+
+    Eigen::MatrixXd A(3, 1);
+    A << 2,
+         0,
+         2;
+    embedding.forward(A);
+
+    Eigen::MatrixXd dLdZ(3, 2);
+    dLdZ << 1.0, 2.0,
+            3.0, 4.0,
+            5.0, 6.0;
+    Eigen::MatrixXd dLdA = embedding.backward(dLdZ);
+
+    // Repeated lookups of index 2 are summed, index 1 and 3 are never touched
+    std::vector<Eigen::Index> expected_indices = {0, 2};
+    Eigen::MatrixXd expected_values(2, 2);
+    expected_values << 3.0, 6.0,
+                       4.0, 8.0;
+
+    ASSERT_EQ(embedding.sparse_indices_, expected_indices);
+    ASSERT_TRUE(embedding.sparse_values_.isApprox(expected_values, 1e-12));
+    ASSERT_TRUE(dLdA.isZero());
+    ASSERT_EQ(embedding.dLdW_.size(), 0);
+}
+
+TEST(EmbeddingTest, RejectsOutOfRangeIndices) {
+    Embedding embedding(5, 2);
+    Eigen::MatrixXd A(2, 2);
+    A << 0, 4,
+         3, 1;
+    Eigen::MatrixXd Z = embedding.forward(A);
+    for (double bad : {-1.0, 5.0, 1e20, std::nan("")}) {
+        Eigen::MatrixXd B = A;
+        B(1, 0) = bad;
+        ASSERT_THROW(embedding.forward(B), std::out_of_range);
+        ASSERT_THROW(embedding.predict(B), std::out_of_range);
+    }
+    // A rejected batch leaves the last good one cached
+    ASSERT_EQ(embedding.A_, A);
+}
+
+TEST(EmbeddingTest, MatchesLinearOnOneHot) {
+    // Large enough to take the parallel path
+    const size_t num_embeddings = 1200;
+    const size_t dim = 8;
+    const size_t N = 4096;
+    Embedding embedding(num_embeddings, dim);
+    Linear linear(num_embeddings, dim);
+    linear.W_ = embedding.W_;
+    linear.b_ = Eigen::MatrixXd::Zero(dim, 1);
+
+    Eigen::MatrixXd A(N, 1);
+    Eigen::MatrixXd one_hot = Eigen::MatrixXd::Zero(N, num_embeddings);
+    for (size_t n = 0; n < N; n++) {
+        A(n, 0) = (n * 7919) % 1000;
+        one_hot(n, (n * 7919) % 1000) = 1.0;
+    }
+
+    ASSERT_TRUE(embedding.forward(A).isApprox(linear.forward(one_hot), 1e-12));
+
+    Eigen::MatrixXd dLdZ = Eigen::MatrixXd::Random(N, dim);
+    embedding.backward(dLdZ);
+    linear.backward(dLdZ);
+
+    Eigen::MatrixXd dense = Eigen::MatrixXd::Zero(dim, num_embeddings);
+    for (size_t s = 0; s < embedding.sparse_indices_.size(); s++) {
+        dense.col(embedding.sparse_indices_[s]) = embedding.sparse_values_.col(s);
+    }
+    ASSERT_EQ(embedding.sparse_indices_.size(), 1000);
+    ASSERT_TRUE(dense.isApprox(linear.dLdW_, 1e-10));
+}
+
+// A user-defined layer that only implements what a subclass must
+class DoubleLayer : public Layer {
+public:
+    DoubleLayer() : Layer(3, 3) {}
+    std::unique_ptr<Layer> clone() const override { return std::make_unique<DoubleLayer>(*this); }
+    Eigen::MatrixXd forward(const Eigen::MatrixXd& A) override {
+        this->A_ = A;
+        this->N_ = A.rows();
+        return 2 * A;
+    }
+    Eigen::MatrixXd backward(const Eigen::MatrixXd& dLdZ) override { return 2 * dLdZ; }
+};
+
+class SquareActivation : public ActivationFunction {
+public:
+    std::unique_ptr<ActivationFunction> clone() const override {
+        return std::make_unique<SquareActivation>(*this);
+    }
+    Eigen::MatrixXd forward(const Eigen::MatrixXd& Z) override {
+        this->A_ = Z.array().square();
+        return this->A_;
+    }
+    Eigen::MatrixXd backward(const Eigen::MatrixXd& dLdA) override { return dLdA; }
+};
+
+TEST(LayerTest, DefaultPredictKeepsForwardState) {
+    DoubleLayer layer;
+    SquareActivation activation;
+    Eigen::MatrixXd A = Eigen::MatrixXd::Random(4, 3);
+    Eigen::MatrixXd B = Eigen::MatrixXd::Random(2, 3);
+    activation.forward(layer.forward(A));
+
+    ASSERT_EQ(layer.predict(B), 2 * B);
+    ASSERT_EQ(activation.predict(B), Eigen::MatrixXd(B.array().square()));
+    // The state of the training forward pass is still there for backward
+    ASSERT_EQ(layer.A_, A);
+    ASSERT_EQ(layer.N_, 4);
+    ASSERT_EQ(activation.A_, Eigen::MatrixXd((2 * A).array().square()));
+}
@@ -0,0 +1,169 @@
+#include <gtest/gtest.h>
+#include <Eigen/Dense>
+#include "../include/metrics/metrics.h"
+#include "../include/nn/model.h"
+#include <memory>
+#include <vector>
+
+TEST(MetricsTest, TopKAccuracy) {
+    Eigen::MatrixXd P(4, 3);
+    P << 0.7, 0.2, 0.1,
+         0.1, 0.3, 0.6,
+         0.2, 0.5, 0.3,
+         0.4, 0.1, 0.5;
+    Eigen::MatrixXd Y(4, 1);
+    Y << 0, 1, 1, 1;
+
+    Accuracy top1;
+    TopKAccuracy top2(2);
+    top1.update(P, Y);
+    top2.update(P, Y);
+
+    // Sample 1 has its target second, sample 3 last
+    ASSERT_DOUBLE_EQ(top1.result(), 0.5);
+    ASSERT_DOUBLE_EQ(top2.result(), 0.75);
+}
+
+TEST(MetricsTest, ConfusionMatrixScores) {
+    // One-hot targets and a binary classifier with a single score column
+    Eigen::MatrixXd P(6, 1);
+    P << 0.9, 0.8, 0.3, 0.6, 0.1, 0.2;
+    Eigen::MatrixXd Y(6, 2);
+    Y << 0, 1,
+         0, 1,
+         0, 1,
+         1, 0,
+         1, 0,
+         1, 0;
+
+    ConfusionMatrix cm(2);
+    Precision precision(2);
+    Recall recall(2);
+    F1Score f1(2);
+    for (Metric* m : std::vector<Metric*>{&cm, &precision, &recall, &f1}) {
+        m->update(P, Y);
+    }
+
+    ASSERT_EQ(cm.count(1, 1), 2);
+    ASSERT_EQ(cm.count(1, 0), 1);
+    ASSERT_EQ(cm.count(0, 1), 1);
+    ASSERT_EQ(cm.count(0, 0), 2);
+    ASSERT_DOUBLE_EQ(cm.result(), 4.0 / 6.0);
+    ASSERT_DOUBLE_EQ(cm.precision(1), 2.0 / 3.0);
+    ASSERT_DOUBLE_EQ(cm.recall(1), 2.0 / 3.0);
+    ASSERT_DOUBLE_EQ(precision.result(), 2.0 / 3.0);
+    ASSERT_DOUBLE_EQ(recall.result(), 2.0 / 3.0);
+    ASSERT_DOUBLE_EQ(f1.result(), 2.0 / 3.0);
+
+    // A class that never occurs scores 0 instead of dividing by zero
+    ConfusionMatrix empty(3);
+    empty.update(Eigen::MatrixXd::Identity(2, 3), Eigen::MatrixXd::Identity(2, 3));
+    ASSERT_DOUBLE_EQ(empty.precision(2), 0.0);
+    ASSERT_DOUBLE_EQ(empty.recall(2), 0.0);
+    ASSERT_DOUBLE_EQ(empty.f1(2), 0.0);
+}
+
+TEST(MetricsTest, RegressionErrors) {
+    Eigen::MatrixXd P(2, 2);
+    P << 1, 2,
+         3, 4;
+    Eigen::MatrixXd Y(2, 2);
+    Y << 1, 0,
+         4, 4;
+
+    MeanSquaredErrorMetric mse;
+    MeanAbsoluteErrorMetric mae;
+    mse.update(P, Y);
+    mae.update(P, Y);
+
+    ASSERT_DOUBLE_EQ(mse.result(), 5.0 / 4.0);
+    ASSERT_DOUBLE_EQ(mae.result(), 3.0 / 4.0);
+    mse.reset();
+    ASSERT_DOUBLE_EQ(mse.result(), 0.0);
+}
+
+TEST(MetricsTest, MergeMatchesSinglePass) {
+    Eigen::MatrixXd P = Eigen::MatrixXd::Random(40, 5);
+    Eigen::MatrixXd Y = Eigen::MatrixXd::Zero(40, 5);
+    for (int i = 0; i < 40; i++) {
+        Y(i, (i * 7) % 5) = 1;
+    }
+
+    std::vector<std::unique_ptr<Metric>> whole, first, second;
+    whole.push_back(std::make_unique<TopKAccuracy>(3));
+    whole.push_back(std::make_unique<F1Score>(5));
+    whole.push_back(std::make_unique<MeanAbsoluteErrorMetric>());
+    for (std::unique_ptr<Metric>& m : whole) {
+        first.push_back(m->fresh());
+        second.push_back(m->fresh());
+    }
+
+    for (size_t i = 0; i < whole.size(); i++) {
+        whole[i]->update(P, Y);
+        first[i]->update(P.topRows(15), Y.topRows(15));
+        second[i]->update(P.bottomRows(25), Y.bottomRows(25));
+        first[i]->merge(*second[i]);
+        ASSERT_NEAR(first[i]->result(), whole[i]->result(), 1e-12);
+    }
+}
+
+TEST(MetricsTest, PredictMatchesForward) {
+    std::vector<std::unique_ptr<Layer>> layers;
+    std::vector<std::unique_ptr<ActivationFunction>> activations;
+    std::unique_ptr<LossFunction> loss = std::make_unique<SoftmaxCrossEntropy>();
+    layers.emplace_back(std::make_unique<Linear>(6, 8));
+    layers.emplace_back(std::make_unique<Linear>(8, 3));
+    activations.emplace_back(std::make_unique<Tanh>());
+    activations.emplace_back(std::make_unique<Sigmoid>());
+    Model model(layers, activations, loss);
+
+    Eigen::MatrixXd X = Eigen::MatrixXd::Random(10, 6);
+    Eigen::MatrixXd expected = model.forward(X);
+
+    ASSERT_TRUE(model.predict(X).isApprox(expected, 1e-12));
+    // predict leaves the cache of the last forward pass alone
+    ASSERT_TRUE(layers[0]->A_.isApprox(X));
+    ASSERT_EQ(layers[0]->predict(Eigen::MatrixXd::Random(3, 6)).rows(), 3);
+    ASSERT_EQ(layers[0]->A_.rows(), 10);
+}
+
+TEST(MetricsTest, EvaluateStreamsBatches) {
+    std::vector<std::unique_ptr<Layer>> layers;
+    std::vector<std::unique_ptr<ActivationFunction>> activations;
+    std::unique_ptr<LossFunction> loss = std::make_unique<SoftmaxCrossEntropy>();
+    layers.emplace_back(std::make_unique<Linear>(4, 3));
+    activations.emplace_back(std::make_unique<ReLU>());
+    Model model(layers, activations, loss);
+
+    Eigen::MatrixXd X = Eigen::MatrixXd::Random(100, 4);
+    Eigen::MatrixXd Y(100, 1);
+    for (int i = 0; i < 100; i++) {
+        Y(i, 0) = i % 3;
+    }
+
+    size_t next = 0;
+    BatchSource source = [&](Eigen::MatrixXd& Xb, Eigen::MatrixXd& Yb) {
+        if (next >= 100) {
+            return false;
+        }
+        size_t rows = std::min<size_t>(16, 100 - next);
+        Xb = X.middleRows(next, rows);
+        Yb = Y.middleRows(next, rows);
+        next += rows;
+        return true;
+    };
+
+    Accuracy accuracy;
+    ConfusionMatrix cm(3);
+    evaluate(model, source, {&accuracy, &cm}, 4);
+
+    Accuracy expected_accuracy;
+    ConfusionMatrix expected_cm(3);
+    Eigen::MatrixXd P = model.predict(X);
+    expected_accuracy.update(P, Y);
+    expected_cm.update(P, Y);
+
+    ASSERT_DOUBLE_EQ(accuracy.result(), expected_accuracy.result());
+    ASSERT_EQ(accuracy.total_, 100);
+    ASSERT_EQ(cm.counts_, expected_cm.counts_);
+}
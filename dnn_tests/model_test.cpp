@@ -49,3 +49,74 @@ TEST(LinearModel, Forward) {
 
     std::cout << A << std::endl;
 }
+
+TEST(LinearModel, BackwardMatchesFiniteDifferences) {
+    std::vector<std::unique_ptr<Layer>> layers;
+    std::vector<std::unique_ptr<ActivationFunction>> activations;
+    std::unique_ptr<LossFunction> loss = std::make_unique<MeanSquaredError>();
+    layers.emplace_back(std::make_unique<Linear>(3, 4));
+    layers.emplace_back(std::make_unique<Linear>(4, 2));
+    activations.emplace_back(std::make_unique<Tanh>());
+    Model model(layers, activations, loss);
+
+    MatrixXd X = MatrixXd::Random(5, 3);
+    MatrixXd Y = MatrixXd::Random(5, 2);
+    loss->forward(model.forward(X), Y);
+    model.backward();
+
+    // Perturb every weight of the first layer, which sits below the activation
+    const double h = 1e-6;
+    for (int r = 0; r < layers[0]->W_.rows(); r++) {
+        for (int c = 0; c < layers[0]->W_.cols(); c++) {
+            double w = layers[0]->W_(r, c);
+            layers[0]->W_(r, c) = w + h;
+            double plus = loss->forward(model.forward(X), Y);
+            layers[0]->W_(r, c) = w - h;
+            double minus = loss->forward(model.forward(X), Y);
+            layers[0]->W_(r, c) = w;
+            EXPECT_NEAR(layers[0]->dLdW_(r, c), (plus - minus) / (2 * h), 1e-6);
+        }
+    }
+}
+
+TEST(LinearModel, CheckpointingMatchesAndSavesMemory) {
+    const size_t depth = 16;
+    std::vector<std::unique_ptr<Layer>> layers;
+    std::vector<std::unique_ptr<ActivationFunction>> activations;
+    std::unique_ptr<LossFunction> loss = std::make_unique<MeanSquaredError>();
+    for (size_t i = 0; i < depth; i++) {
+        layers.emplace_back(std::make_unique<Linear>(8, 8));
+        activations.emplace_back(std::make_unique<Tanh>());
+    }
+    Model model(layers, activations, loss);
+    MatrixXd X = MatrixXd::Random(10, 8);
+    MatrixXd Y = MatrixXd::Random(10, 8);
+
+    MatrixXd expected_out = model.forward(X);
+    loss->forward(expected_out, Y);
+    model.backward();
+    size_t full_peak = model.peak_cache_bytes_;
+    std::vector<MatrixXd> expected_dLdW;
+    for (auto& layer : layers) {
+        expected_dLdW.push_back(layer->dLdW_);
+    }
+
+    model.set_sqrt_checkpoints();
+    ASSERT_EQ(model.checkpoints_, std::vector<size_t>({4, 8, 12}));
+    for (int step = 0; step < 2; step++) {
+        MatrixXd out = model.forward(X);
+        ASSERT_TRUE(out.isApprox(expected_out, 1e-12));
+        loss->forward(out, Y);
+        model.backward();
+        for (size_t i = 0; i < depth; i++) {
+            ASSERT_TRUE(layers[i]->dLdW_.isApprox(expected_dLdW[i], 1e-12));
+        }
+    }
+
+    // 32 cached matrices without checkpoints; with 4 segments of 4 layers, at
+    // most 3 segment inputs plus the 8 caches of one segment
+    size_t matrix = 10 * 8 * sizeof(double);
+    ASSERT_EQ(full_peak, 2 * depth * matrix);
+    ASSERT_LE(model.peak_cache_bytes_, 11 * matrix);
+    ASSERT_EQ(model.cache_bytes(), 0);
+}
@@ -0,0 +1,293 @@
+#include <gtest/gtest.h>
+#include <Eigen/Dense>
+#include "../include/nn/attention.h"
+#include "../include/nn/model.h"
+#include "../include/utils/npy.h"
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Writes a .npy file the way NumPy does, for the given header
+ * dictionary and raw data.
+ */
+static void write_raw_npy(const std::string& path, std::string dict, const void* data, size_t bytes) {
+    size_t unpadded = 10 + dict.size() + 1;
+    dict += std::string((64 - unpadded % 64) % 64, ' ') + "\n";
+    std::ofstream file(path, std::ios::binary);
+    file.write("\x93NUMPY\x01\x00", 8);
+    uint16_t length = static_cast<uint16_t>(dict.size());
+    file.put(static_cast<char>(length & 0xFF));
+    file.put(static_cast<char>(length >> 8));
+    file << dict;
+    file.write(static_cast<const char*>(data), bytes);
+}
+
+static void put_u16(std::string& out, uint16_t v) {
+    for (int i = 0; i < 2; i++) {
+        out += static_cast<char>((v >> (8 * i)) & 0xFF);
+    }
+}
+
+static void put_u32(std::string& out, uint32_t v) {
+    for (int i = 0; i < 4; i++) {
+        out += static_cast<char>((v >> (8 * i)) & 0xFF);
+    }
+}
+
+static void put_u64(std::string& out, uint64_t v) {
+    for (int i = 0; i < 8; i++) {
+        out += static_cast<char>((v >> (8 * i)) & 0xFF);
+    }
+}
+
+static uint32_t crc32(const std::string& data) {
+    uint32_t crc = 0xFFFFFFFF;
+    for (char c : data) {
+        crc ^= static_cast<uint8_t>(c);
+        for (int k = 0; k < 8; k++) {
+            crc = (crc >> 1) ^ (0xEDB88320 & (0u - (crc & 1)));
+        }
+    }
+    return ~crc;
+}
+
+/**
+ * @brief Writes a one-entry stored zip archive whose sizes and offset are only
+ * in zip64 extra fields, as np.savez does for its local headers (it opens every
+ * entry with force_zip64) and as any zip64 writer does for large archives.
+ */
+static void write_zip64_npz(const std::string& path, const std::string& name, const std::string& npy) {
+    const uint32_t LIMIT = 0xFFFFFFFF;
+    std::string local;
+    put_u32(local, 0x04034b50);
+    put_u16(local, 45);  // Zip64 needs version 4.5
+    put_u16(local, 0);
+    put_u16(local, 0);  // Stored
+    put_u16(local, 0);
+    put_u16(local, 0x21);
+    put_u32(local, crc32(npy));
+    put_u32(local, LIMIT);
+    put_u32(local, LIMIT);
+    put_u16(local, static_cast<uint16_t>(name.size()));
+    put_u16(local, 20);
+    local += name;
+    put_u16(local, 0x0001);
+    put_u16(local, 16);
+    put_u64(local, npy.size());
+    put_u64(local, npy.size());
+    local += npy;
+
+    std::string directory;
+    put_u32(directory, 0x02014b50);
+    put_u16(directory, 45);
+    put_u16(directory, 45);
+    put_u16(directory, 0);
+    put_u16(directory, 0);
+    put_u16(directory, 0);
+    put_u16(directory, 0x21);
+    put_u32(directory, crc32(npy));
+    put_u32(directory, LIMIT);
+    put_u32(directory, LIMIT);
+    put_u16(directory, static_cast<uint16_t>(name.size()));
+    put_u16(directory, 28);
+    put_u16(directory, 0);
+    put_u16(directory, 0);
+    put_u16(directory, 0);
+    put_u32(directory, 0);
+    put_u32(directory, LIMIT);
+    directory += name;
+    put_u16(directory, 0x0001);
+    put_u16(directory, 24);
+    put_u64(directory, npy.size());  // Size
+    put_u64(directory, npy.size());  // Compressed size
+    put_u64(directory, 0);           // Offset of the local header
+
+    std::string end;
+    put_u32(end, 0x06054b50);
+    put_u16(end, 0);
+    put_u16(end, 0);
+    put_u16(end, 1);
+    put_u16(end, 1);
+    put_u32(end, static_cast<uint32_t>(directory.size()));
+    put_u32(end, static_cast<uint32_t>(local.size()));
+    put_u16(end, 0);
+    std::ofstream(path, std::ios::binary) << local << directory << end;
+}
+
+TEST(NpyTest, SaveLoadRoundTrip) {
+    Eigen::MatrixXd M = Eigen::MatrixXd::Random(7, 5);
+    const char* path = "npy_test_roundtrip.npy";
+
+    save_npy(path, M);
+    ASSERT_EQ(load_npy(path), M);
+    save_npy(path, M, NpyType::Float32);
+    ASSERT_TRUE(load_npy(path).isApprox(M, 1e-6));
+    std::remove(path);
+}
+
+TEST(NpyTest, MapsWithoutCopying) {
+    Eigen::MatrixXd M = Eigen::MatrixXd::Random(100, 30);
+    const char* path = "npy_test_map.npy";
+    save_npy(path, M);
+
+    {
+        NpyMap map(path);
+        ASSERT_EQ(map.rows(), 100);
+        ASSERT_EQ(map.cols(), 30);
+        Eigen::Map<const Eigen::MatrixXd> view = map.matrix();
+        ASSERT_EQ(view, M);
+        // The array starts 64-byte aligned in the page-aligned mapping
+        ASSERT_EQ(reinterpret_cast<uintptr_t>(view.data()) % 64, 0);
+        ASSERT_THROW(map.view<float>(), std::runtime_error);
+        ASSERT_THROW((map.view<double, Eigen::RowMajor>()), std::runtime_error);
+    }
+    std::remove(path);
+}
+
+TEST(NpyTest, ReadsNumpyLayouts) {
+    // np.arange(6, dtype=np.float32).reshape(2, 3), in C order
+    const float values[] = {0, 1, 2, 3, 4, 5};
+    const char* path = "npy_test_c_order.npy";
+    write_raw_npy(path, "{'descr': '<f4', 'fortran_order': False, 'shape': (2, 3), }", values, sizeof(values));
+
+    Eigen::MatrixXd expected(2, 3);
+    expected << 0, 1, 2,
+                3, 4, 5;
+    ASSERT_EQ(load_npy(path), expected);
+    {
+        NpyMap map(path);
+        ASSERT_EQ(map.header().dtype, NpyType::Float32);
+        ASSERT_EQ((map.view<float, Eigen::RowMajor>()), expected.cast<float>());
+        ASSERT_EQ(map.to_matrix(), expected);
+        ASSERT_THROW(map.matrix(), std::runtime_error);
+    }
+
+    // A 1-D array is a column
+    const double vector[] = {1.5, -2, 4};
+    write_raw_npy(path, "{'descr': '<f8', 'fortran_order': False, 'shape': (3,), }", vector, sizeof(vector));
+    Eigen::MatrixXd loaded = load_npy(path);
+    ASSERT_EQ(loaded.rows(), 3);
+    ASSERT_EQ(loaded.cols(), 1);
+    ASSERT_EQ(loaded(1, 0), -2);
+
+    const int32_t ints[] = {1, 2};
+    write_raw_npy(path, "{'descr': '<i4', 'fortran_order': False, 'shape': (2,), }", ints, sizeof(ints));
+    ASSERT_THROW(load_npy(path), std::runtime_error);
+    write_raw_npy(path, "{'descr': '<f8', 'fortran_order': False, 'shape': (4,), }", vector, sizeof(vector));
+    ASSERT_THROW(load_npy(path), std::runtime_error);
+    write_raw_npy(path, "{'descr': '<f8', 'fortran_order': False, 'shape': (x,), }", vector, sizeof(vector));
+    ASSERT_THROW(load_npy(path), std::runtime_error);
+    std::remove(path);
+    ASSERT_THROW(load_npy(path), std::runtime_error);
+}
+
+TEST(NpyTest, NpzRoundTrip) {
+    std::map<std::string, Eigen::MatrixXd> arrays;
+    arrays["weights"] = Eigen::MatrixXd::Random(4, 3);
+    arrays["bias"] = Eigen::MatrixXd::Random(4, 1);
+    arrays["scalar"] = Eigen::MatrixXd::Constant(1, 1, 3.0);
+    const char* path = "npy_test.npz";
+
+    save_npz(path, arrays);
+    std::map<std::string, Eigen::MatrixXd> loaded = load_npz(path);
+    ASSERT_EQ(loaded.size(), 3);
+    for (const auto& entry : arrays) {
+        ASSERT_EQ(loaded.at(entry.first), entry.second);
+    }
+
+    // A flipped byte in the data is caught by the checksum
+    {
+        std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(30 + 8 + 64 + 3);
+        file.put('\x7f');
+    }
+    ASSERT_THROW(load_npz(path), std::runtime_error);
+    std::remove(path);
+}
+
+TEST(NpyTest, ReadsZip64Entries) {
+    Eigen::MatrixXd M = Eigen::MatrixXd::Random(5, 3);
+    const char* npy_path = "npy_test_zip64.npy";
+    const char* path = "npy_test_zip64.npz";
+    save_npy(npy_path, M);
+    std::ifstream npy_file(npy_path, std::ios::binary);
+    std::string npy((std::istreambuf_iterator<char>(npy_file)), std::istreambuf_iterator<char>());
+    npy_file.close();
+    std::remove(npy_path);
+
+    write_zip64_npz(path, "weights.npy", npy);
+    std::map<std::string, Eigen::MatrixXd> loaded = load_npz(path);
+    ASSERT_EQ(loaded.size(), 1);
+    ASSERT_EQ(loaded.at("weights"), M);
+    std::remove(path);
+}
+
+TEST(NpyTest, SavesAndLoadsModelParameters) {
+    std::vector<std::unique_ptr<Layer>> layers;
+    std::vector<std::unique_ptr<ActivationFunction>> activations;
+    std::unique_ptr<LossFunction> loss = std::make_unique<MeanSquaredError>();
+    layers.emplace_back(std::make_unique<Linear>(8, 8));
+    layers.emplace_back(std::make_unique<MultiHeadAttention>(8, 2, 4));
+    Model model(layers, activations, loss);
+    const char* path = "npy_test_params.npz";
+    save_parameters(path, model);
+
+    std::vector<std::unique_ptr<Layer>> other_layers;
+    other_layers.emplace_back(std::make_unique<Linear>(8, 8));
+    other_layers.emplace_back(std::make_unique<MultiHeadAttention>(8, 2, 4));
+    Model other(other_layers, activations, loss);
+    load_parameters(path, other);
+
+    Eigen::MatrixXd X = Eigen::MatrixXd::Random(8, 8);
+    ASSERT_TRUE(other.predict(X).isApprox(model.predict(X), 1e-12));
+    ASSERT_EQ(load_npz(path).count("layer1.3.bias"), 1);
+
+    std::vector<std::unique_ptr<Layer>> wrong_layers;
+    wrong_layers.emplace_back(std::make_unique<Linear>(8, 4));
+    Model wrong(wrong_layers, activations, loss);
+    ASSERT_THROW(load_parameters(path, wrong), std::runtime_error);
+    std::remove(path);
+}
+
+TEST(NpyTest, SavesAndLoadsCompressedLayers) {
+    Linear dense(8, 6), pruned(6, 4);
+    pruned.W_ = (pruned.W_.array().abs() > 0.5).select(pruned.W_, 0.0);
+    std::vector<std::unique_ptr<Layer>> layers;
+    std::vector<std::unique_ptr<ActivationFunction>> activations;
+    std::unique_ptr<LossFunction> loss = std::make_unique<MeanSquaredError>();
+    layers.emplace_back(std::make_unique<HalfLinear>(dense));
+    layers.emplace_back(std::make_unique<SparseLinear>(pruned));
+    Model model(layers, activations, loss);
+    const char* path = "npy_test_compressed.npz";
+    save_parameters(path, model);
+
+    // The weights are saved densely, whatever the layer keeps them in
+    std::map<std::string, Eigen::MatrixXd> arrays = load_npz(path);
+    ASSERT_EQ(arrays.at("layer0.weight"), dynamic_cast<HalfLinear&>(*layers[0]).dense());
+    ASSERT_EQ(arrays.at("layer1.weight"), pruned.W_);
+
+    std::vector<std::unique_ptr<Layer>> other_layers;
+    other_layers.emplace_back(std::make_unique<HalfLinear>(Linear(8, 6)));
+    other_layers.emplace_back(std::make_unique<SparseLinear>(Linear(6, 4)));
+    Model other(other_layers, activations, loss);
+    load_parameters(path, other);
+    Eigen::MatrixXd X = Eigen::MatrixXd::Random(5, 8);
+    ASSERT_TRUE(other.predict(X).isApprox(model.predict(X), 1e-12));
+    ASSERT_EQ(dynamic_cast<SparseLinear&>(*other_layers[1]).nnz(),
+              dynamic_cast<SparseLinear&>(*layers[1]).nnz());
+
+    // And load into plain Linear layers
+    std::vector<std::unique_ptr<Layer>> linear_layers;
+    linear_layers.emplace_back(std::make_unique<Linear>(8, 6));
+    linear_layers.emplace_back(std::make_unique<Linear>(6, 4));
+    Model linear(linear_layers, activations, loss);
+    load_parameters(path, linear);
+    ASSERT_TRUE(linear.predict(X).isApprox(model.predict(X), 1e-5));
+    std::remove(path);
+}
@@ -0,0 +1,178 @@
+#include <gtest/gtest.h>
+#include <Eigen/Dense>
+#include "../include/nn/model.h"
+#include "../include/optim/online.h"
+#include "../include/optim/sgd.h"
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+// y = 2 x0 - x1 + 0.5
+static Eigen::MatrixXd target(const Eigen::MatrixXd& X) {
+    return ((2 * X.col(0) - X.col(1)).array() + 0.5).matrix();
+}
+
+TEST(OnlineTest, MatchesOfflineTraining) {
+    std::vector<std::unique_ptr<Layer>> layers;
+    std::vector<std::unique_ptr<ActivationFunction>> activations;
+    std::unique_ptr<LossFunction> loss = std::make_unique<MeanSquaredError>();
+    layers.emplace_back(std::make_unique<Linear>(2, 4));
+    layers.emplace_back(std::make_unique<Linear>(4, 1));
+    activations.emplace_back(std::make_unique<Tanh>());
+    Model model(layers, activations, loss);
+    SGD sgd(layers, 0.1);
+
+    // The same model, trained on the same batches by hand
+    std::vector<std::unique_ptr<Layer>> offline_layers;
+    std::vector<std::unique_ptr<ActivationFunction>> offline_activations;
+    std::unique_ptr<LossFunction> offline_loss = std::make_unique<MeanSquaredError>();
+    for (std::unique_ptr<Layer>& layer : layers) {
+        offline_layers.push_back(layer->clone());
+    }
+    offline_activations.emplace_back(std::make_unique<Tanh>());
+    Model offline(offline_layers, offline_activations, offline_loss);
+    SGD offline_sgd(offline_layers, 0.1);
+
+    Eigen::MatrixXd X = Eigen::MatrixXd::Random(100, 2);
+    Eigen::MatrixXd Y = target(X);
+    OnlineTrainer trainer(model, sgd, 2, 1, 16, 8, 4);
+    trainer.start();
+    // A small ring makes the producer wait for the trainer
+    for (int i = 0; i < 100; i += 5) {
+        ASSERT_TRUE(trainer.push(X.middleRows(i, 5), Y.middleRows(i, 5)));
+    }
+    trainer.stop();
+
+    // The 4 samples that do not fill a batch are left over
+    ASSERT_EQ(trainer.steps(), 12);
+    for (int i = 0; i + 8 <= 100; i += 8) {
+        offline_loss->forward(offline.forward(X.middleRows(i, 8)), Y.middleRows(i, 8));
+        offline.backward();
+        offline_sgd.step();
+    }
+    for (size_t l = 0; l < layers.size(); l++) {
+        ASSERT_TRUE(layers[l]->W_.isApprox(offline_layers[l]->W_, 1e-12));
+        ASSERT_TRUE(layers[l]->b_.isApprox(offline_layers[l]->b_, 1e-12));
+    }
+    ASSERT_EQ(trainer.snapshot()->step_, 12);
+    ASSERT_TRUE(trainer.snapshot()->predict(X).isApprox(model.predict(X), 1e-12));
+    ASSERT_FALSE(trainer.push(X.topRows(1), Y.topRows(1)));
+}
+
+TEST(OnlineTest, DropsOldestWhenFull) {
+    std::vector<std::unique_ptr<Layer>> layers;
+    std::vector<std::unique_ptr<ActivationFunction>> activations;
+    std::unique_ptr<LossFunction> loss = std::make_unique<MeanSquaredError>();
+    layers.emplace_back(std::make_unique<Linear>(2, 1));
+    Model model(layers, activations, loss);
+    SGD sgd(layers, 0.1);
+    std::unique_ptr<Layer> offline = layers[0]->clone();
+
+    Eigen::MatrixXd X = Eigen::MatrixXd::Random(20, 2);
+    Eigen::MatrixXd Y = target(X);
+    OnlineTrainer trainer(model, sgd, 2, 1, 8, 8, 1, true);
+    // Nobody is training yet, so only the last 8 samples survive
+    ASSERT_TRUE(trainer.push(X, Y));
+    ASSERT_EQ(trainer.dropped(), 12);
+    trainer.start();
+    trainer.stop();
+
+    ASSERT_EQ(trainer.steps(), 1);
+    MeanSquaredError offline_loss;
+    offline_loss.forward(offline->forward(X.bottomRows(8)), Y.bottomRows(8));
+    offline->backward(offline_loss.backward());
+    offline->W_ -= 0.1 * offline->dLdW_;
+    ASSERT_TRUE(layers[0]->W_.isApprox(offline->W_, 1e-12));
+}
+
+TEST(OnlineTest, ReadersSeeConsistentSnapshots) {
+    std::vector<std::unique_ptr<Layer>> layers;
+    std::vector<std::unique_ptr<ActivationFunction>> activations;
+    std::unique_ptr<LossFunction> loss = std::make_unique<MeanSquaredError>();
+    layers.emplace_back(std::make_unique<Linear>(2, 1));
+    Model model(layers, activations, loss);
+    SGD sgd(layers, 0.1);
+
+    OnlineTrainer trainer(model, sgd, 2, 1, 256, 32, 10);
+    trainer.start();
+    std::shared_ptr<const ModelSnapshot> first = trainer.snapshot();
+    Eigen::MatrixXd W0 = first->layers_[0]->W_;
+
+    std::atomic<bool> done{false};
+    std::vector<std::thread> readers;
+    for (int r = 0; r < 2; r++) {
+        readers.emplace_back([&]() {
+            Eigen::MatrixXd probe = Eigen::MatrixXd::Random(4, 2);
+            size_t last_step = 0;
+            while (!done.load()) {
+                std::shared_ptr<const ModelSnapshot> snapshot = trainer.snapshot();
+                ASSERT_TRUE(snapshot != nullptr);
+                ASSERT_GE(snapshot->step_, last_step);
+                last_step = snapshot->step_;
+                ASSERT_EQ(snapshot->predict(probe).rows(), 4);
+            }
+        });
+    }
+    for (int i = 0; i < 200; i++) {
+        Eigen::MatrixXd X = Eigen::MatrixXd::Random(50, 2);
+        trainer.push(X, target(X));
+    }
+    trainer.stop();
+    done.store(true);
+    for (std::thread& reader : readers) {
+        reader.join();
+    }
+
+    // 10000 samples give 312 steps, enough to fit the linear target
+    ASSERT_EQ(trainer.steps(), 312);
+    ASSERT_LT(trainer.last_loss(), 1e-4);
+    Eigen::MatrixXd X = Eigen::MatrixXd::Random(10, 2);
+    ASSERT_TRUE(trainer.snapshot()->predict(X).isApprox(target(X), 1e-2));
+    // Earlier snapshots are not touched by later training steps
+    ASSERT_TRUE(first->layers_[0]->W_.isApprox(W0));
+    ASSERT_EQ(first->step_, 0);
+    ASSERT_EQ(first->layers_[0]->A_.size(), 0);
+}
+
+TEST(OnlineTest, SnapshotOutlivesModel) {
+    std::shared_ptr<const ModelSnapshot> snapshot;
+    Eigen::MatrixXd X = Eigen::MatrixXd::Random(5, 3);
+    Eigen::MatrixXd expected;
+    {
+        std::vector<std::unique_ptr<Layer>> layers;
+        std::vector<std::unique_ptr<ActivationFunction>> activations;
+        std::unique_ptr<LossFunction> loss = std::make_unique<MeanSquaredError>();
+        layers.emplace_back(std::make_unique<Linear>(3, 4));
+        layers.emplace_back(std::make_unique<Linear>(4, 2));
+        activations.emplace_back(std::make_unique<Tanh>());
+        activations.emplace_back(std::make_unique<Scale>(3.0));
+        Model model(layers, activations, loss);
+        model.forward(X);
+        snapshot = std::make_shared<const ModelSnapshot>(model, 7);
+        expected = model.predict(X);
+    }
+    // The activations are copies, with their configuration and no cache
+    ASSERT_TRUE(snapshot->predict(X).isApprox(expected));
+    ASSERT_EQ(snapshot->activations_[0]->A_.size(), 0);
+    ASSERT_DOUBLE_EQ(dynamic_cast<const Scale&>(*snapshot->activations_[1]).scale_, 3.0);
+}
+
+// A layer that does not implement clone, like most user-defined layers
+class NoCloneLayer : public Layer {
+public:
+    NoCloneLayer() : Layer(2, 2) {}
+    Eigen::MatrixXd forward(const Eigen::MatrixXd& A) override { return A; }
+    Eigen::MatrixXd backward(const Eigen::MatrixXd& dLdZ) override { return dLdZ; }
+};
+
+TEST(OnlineTest, SnapshotNeedsClone) {
+    std::vector<std::unique_ptr<Layer>> layers;
+    std::vector<std::unique_ptr<ActivationFunction>> activations;
+    std::unique_ptr<LossFunction> loss = std::make_unique<MeanSquaredError>();
+    layers.emplace_back(std::make_unique<NoCloneLayer>());
+    Model model(layers, activations, loss);
+    ASSERT_TRUE(model.predict(Eigen::MatrixXd::Ones(3, 2)).isApprox(Eigen::MatrixXd::Ones(3, 2)));
+    ASSERT_THROW(ModelSnapshot(model, 0), std::runtime_error);
+}
@@ -0,0 +1,77 @@
+#include <gtest/gtest.h>
+#include <Eigen/Dense>
+#include "../include/nn/model.h"
+#include "../include/nn/optimize.h"
+#include <memory>
+#include <vector>
+
+TEST(OptimizeTest, FusesLinearChain) {
+    std::vector<std::unique_ptr<Layer>> layers;
+    std::vector<std::unique_ptr<ActivationFunction>> activations;
+    std::unique_ptr<LossFunction> loss = std::make_unique<MeanSquaredError>();
+    // 8 -> 32 -> 4 takes 8*32 + 32*4 multiply-adds, the fused 8 -> 4 only 8*4
+    layers.emplace_back(std::make_unique<Linear>(8, 32));
+    layers.emplace_back(std::make_unique<Linear>(32, 4));
+    activations.emplace_back(std::make_unique<Identity>());
+    activations.emplace_back(std::make_unique<Sigmoid>());
+    Model model(layers, activations, loss);
+
+    Eigen::MatrixXd X = Eigen::MatrixXd::Random(10, 8);
+    Eigen::MatrixXd expected = model.forward(X);
+    OptimizeStats stats = optimize_for_inference(model);
+
+    ASSERT_EQ(stats.fused_linears, 1);
+    ASSERT_EQ(stats.removed_identities, 1);
+    ASSERT_EQ(layers.size(), 1);
+    ASSERT_EQ(activations.size(), 1);
+    ASSERT_EQ(layers[0]->W_.rows(), 4);
+    ASSERT_EQ(layers[0]->W_.cols(), 8);
+    ASSERT_TRUE(model.forward(X).isApprox(expected, 1e-12));
+}
+
+TEST(OptimizeTest, KeepsBottleneck) {
+    std::vector<std::unique_ptr<Layer>> layers;
+    std::vector<std::unique_ptr<ActivationFunction>> activations;
+    std::unique_ptr<LossFunction> loss = std::make_unique<MeanSquaredError>();
+    // 32 -> 2 -> 32 is cheaper than the fused 32 -> 32
+    layers.emplace_back(std::make_unique<Linear>(32, 2));
+    layers.emplace_back(std::make_unique<Linear>(2, 32));
+    Model model(layers, activations, loss);
+
+    OptimizeStats stats = optimize_for_inference(model);
+
+    ASSERT_EQ(stats.fused_linears, 0);
+    ASSERT_EQ(layers.size(), 2);
+}
+
+TEST(OptimizeTest, FoldsScalesAndDropsIdentities) {
+    std::vector<std::unique_ptr<Layer>> layers;
+    std::vector<std::unique_ptr<ActivationFunction>> activations;
+    std::unique_ptr<LossFunction> loss = std::make_unique<MeanSquaredError>();
+    layers.emplace_back(std::make_unique<Linear>(6, 5));
+    layers.emplace_back(std::make_unique<Linear>(5, 5));
+    layers.emplace_back(std::make_unique<Linear>(5, 3));
+    layers.emplace_back(std::make_unique<Linear>(3, 3));
+    layers[1]->W_.setIdentity();
+    layers[1]->b_.setZero();
+    layers[3]->W_.setIdentity();
+    layers[3]->b_.setZero();
+    activations.emplace_back(std::make_unique<Identity>());
+    activations.emplace_back(std::make_unique<ReLU>());
+    activations.emplace_back(std::make_unique<Scale>(0.5));
+    activations.emplace_back(std::make_unique<Tanh>());
+    Model model(layers, activations, loss);
+
+    Eigen::MatrixXd X = Eigen::MatrixXd::Random(7, 6);
+    Eigen::MatrixXd expected = model.forward(X);
+    OptimizeStats stats = optimize_for_inference(model);
+
+    // Linear(6, 5) -> ReLU -> Linear(5, 3) * 0.5 -> Tanh
+    ASSERT_EQ(stats.folded_scales, 1);
+    ASSERT_EQ(stats.removed_identities, 3);
+    ASSERT_EQ(layers.size(), 2);
+    ASSERT_EQ(activations.size(), 2);
+    ASSERT_NE(dynamic_cast<ReLU*>(activations[0].get()), nullptr);
+    ASSERT_NE(dynamic_cast<Tanh*>(activations[1].get()), nullptr);
+    ASSERT_TRUE(model.forward(X).isApprox(expected, 1e-12));
+}
@@ -0,0 +1,83 @@
+#include <gtest/gtest.h>
+#include <Eigen/Dense>
+#include "../include/nn/model.h"
+#include "../include/nn/pipeline.h"
+#include <memory>
+#include <vector>
+
+class PipelineTest : public ::testing::Test {
+protected:
+    std::vector<std::unique_ptr<Layer>> layers_;
+    std::vector<std::unique_ptr<ActivationFunction>> activations_;
+    std::unique_ptr<LossFunction> loss_ = std::make_unique<SoftmaxCrossEntropy>();
+    Eigen::MatrixXd X_ = Eigen::MatrixXd::Random(23, 6);
+    Eigen::MatrixXd Y_ = Eigen::MatrixXd::Zero(23, 3);
+
+    void SetUp() override {
+        layers_.emplace_back(std::make_unique<Linear>(6, 16));
+        layers_.emplace_back(std::make_unique<Linear>(16, 16));
+        layers_.emplace_back(std::make_unique<Linear>(16, 8));
+        layers_.emplace_back(std::make_unique<Linear>(8, 3));
+        activations_.emplace_back(std::make_unique<ReLU>());
+        activations_.emplace_back(std::make_unique<Tanh>());
+        activations_.emplace_back(std::make_unique<Sigmoid>());
+        for (int n = 0; n < Y_.rows(); n++) {
+            Y_(n, n % 3) = 1.0;
+        }
+    }
+
+    void check_train_step(PipelineSchedule schedule, size_t stages, size_t micro_batches) {
+        Model model(layers_, activations_, loss_);
+        double expected_loss = loss_->forward(model.forward(X_), Y_);
+        model.backward();
+        std::vector<Eigen::MatrixXd> dLdW, dLdb;
+        for (auto& layer : layers_) {
+            dLdW.push_back(layer->dLdW_);
+            dLdb.push_back(layer->dLdb_);
+        }
+
+        PipelineModel pipeline(model, stages, micro_batches, schedule);
+        for (int step = 0; step < 2; step++) {
+            double loss = pipeline.train_step(X_, Y_);
+            ASSERT_NEAR(loss, expected_loss, 1e-10);
+            for (size_t i = 0; i < layers_.size(); i++) {
+                ASSERT_TRUE(layers_[i]->dLdW_.isApprox(dLdW[i], 1e-10));
+                ASSERT_TRUE(layers_[i]->dLdb_.isApprox(dLdb[i], 1e-10));
+            }
+        }
+    }
+};
+
+TEST_F(PipelineTest, StagesCoverAllLayers) {
+    Model model(layers_, activations_, loss_);
+    PipelineModel pipeline(model, 3, 4);
+    ASSERT_EQ(pipeline.stages_.size(), 3);
+    ASSERT_EQ(pipeline.stages_.front().first, 0);
+    ASSERT_EQ(pipeline.stages_.back().second, layers_.size());
+    for (size_t s = 0; s < pipeline.stages_.size(); s++) {
+        ASSERT_LT(pipeline.stages_[s].first, pipeline.stages_[s].second);
+        if (s > 0) {
+            ASSERT_EQ(pipeline.stages_[s].first, pipeline.stages_[s - 1].second);
+        }
+    }
+}
+
+TEST_F(PipelineTest, ForwardMatchesModel) {
+    Model model(layers_, activations_, loss_);
+    Eigen::MatrixXd expected = model.forward(X_);
+    PipelineModel pipeline(model, 4, 5);
+    ASSERT_TRUE(pipeline.forward(X_).isApprox(expected, 1e-12));
+    ASSERT_TRUE(pipeline.forward(X_).isApprox(expected, 1e-12));
+}
+
+TEST_F(PipelineTest, GPipeGradientsMatchModel) {
+    check_train_step(PipelineSchedule::GPipe, 3, 4);
+}
+
+TEST_F(PipelineTest, OneFOneBGradientsMatchModel) {
+    check_train_step(PipelineSchedule::OneFOneB, 4, 6);
+}
+
+TEST_F(PipelineTest, MoreMicroBatchesThanRows) {
+    check_train_step(PipelineSchedule::OneFOneB, 2, 64);
+}
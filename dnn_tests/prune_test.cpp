@@ -0,0 +1,109 @@
+#include <gtest/gtest.h>
+#include <Eigen/Dense>
+#include "../include/nn/model.h"
+#include "../include/nn/prune.h"
+#include <memory>
+#include <vector>
+
+TEST(SparseLinearTest, MatchesDenseLinear) {
+    Linear linear(6, 4);
+    linear.W_ << 0.0, 1.0, 0.0, 0.0, -2.0, 0.0,
+                 0.0, 0.0, 0.0, 0.0,  0.0, 0.0,
+                 3.0, 0.0, 0.0, 4.0,  0.0, 0.5,
+                 0.0, 0.0, 7.0, 0.0,  0.0, 0.0;
+    SparseLinear sparse(linear);
+
+    ASSERT_EQ(sparse.nnz(), 6);
+    ASSERT_EQ(sparse.W_.size(), 0);
+    ASSERT_TRUE(sparse.dense().isApprox(linear.W_, 1e-12));
+
+    Eigen::MatrixXd A = Eigen::MatrixXd::Random(5, 6);
+    ASSERT_TRUE(sparse.forward(A).isApprox(linear.forward(A), 1e-12));
+
+    Eigen::MatrixXd dLdZ = Eigen::MatrixXd::Random(5, 4);
+    ASSERT_TRUE(sparse.backward(dLdZ).isApprox(linear.backward(dLdZ), 1e-12));
+}
+
+TEST(PruneTest, PerLayerSparsity) {
+    std::vector<std::unique_ptr<Layer>> layers;
+    std::vector<std::unique_ptr<ActivationFunction>> activations;
+    std::unique_ptr<LossFunction> loss = std::make_unique<MeanSquaredError>();
+    layers.emplace_back(std::make_unique<Linear>(10, 20));
+    layers.emplace_back(std::make_unique<Linear>(20, 5));
+    Model model(layers, activations, loss);
+
+    size_t pruned = magnitude_prune(model, {0, 1}, 0.8, PruneScope::PerLayer);
+
+    ASSERT_EQ(pruned, 160 + 80);
+    SparseLinear* first = dynamic_cast<SparseLinear*>(layers[0].get());
+    SparseLinear* second = dynamic_cast<SparseLinear*>(layers[1].get());
+    ASSERT_NE(first, nullptr);
+    ASSERT_NE(second, nullptr);
+    ASSERT_NEAR(first->sparsity(), 0.8, 1e-12);
+    ASSERT_NEAR(second->sparsity(), 0.8, 1e-12);
+}
+
+TEST(PruneTest, GlobalThresholdKeepsLargestWeights) {
+    std::vector<std::unique_ptr<Layer>> layers;
+    std::vector<std::unique_ptr<ActivationFunction>> activations;
+    std::unique_ptr<LossFunction> loss = std::make_unique<MeanSquaredError>();
+    layers.emplace_back(std::make_unique<Linear>(2, 2));
+    layers.emplace_back(std::make_unique<Linear>(2, 2));
+    layers[0]->W_ << 0.1, 0.2,
+                     0.3, 0.4;
+    layers[1]->W_ << 5.0, -6.0,
+                     7.0, -0.05;
+    Model model(layers, activations, loss);
+
+    magnitude_prune(model, {0, 1}, 0.5, PruneScope::Global, false);
+
+    Eigen::MatrixXd expected0 = Eigen::MatrixXd::Zero(2, 2);
+    expected0(1, 1) = 0.4;
+    Eigen::MatrixXd expected1(2, 2);
+    expected1 << 5.0, -6.0,
+                 7.0, 0.0;
+    ASSERT_NE(dynamic_cast<Linear*>(layers[0].get()), nullptr);
+    ASSERT_TRUE(layers[0]->W_.isApprox(expected0, 1e-12));
+    ASSERT_TRUE(layers[1]->W_.isApprox(expected1, 1e-12));
+}
+
+TEST(PruneTest, ModelForwardUsesSparseLayers) {
+    std::vector<std::unique_ptr<Layer>> layers;
+    std::vector<std::unique_ptr<ActivationFunction>> activations;
+    std::unique_ptr<LossFunction> loss = std::make_unique<SoftmaxCrossEntropy>();
+    layers.emplace_back(std::make_unique<Linear>(8, 16));
+    layers.emplace_back(std::make_unique<Linear>(16, 3));
+    activations.emplace_back(std::make_unique<ReLU>());
+    activations.emplace_back(std::make_unique<Sigmoid>());
+    Model model(layers, activations, loss);
+
+    // Prune without converting to get the dense reference output
+    magnitude_prune(model, {0}, 0.9, PruneScope::Global, false);
+    Eigen::MatrixXd X = Eigen::MatrixXd::Random(7, 8);
+    Eigen::MatrixXd expected = model.forward(X);
+
+    magnitude_prune(model, {0}, 0.9, PruneScope::Global, true);
+    ASSERT_NE(dynamic_cast<SparseLinear*>(layers[0].get()), nullptr);
+    ASSERT_NE(dynamic_cast<Linear*>(layers[1].get()), nullptr);
+    ASSERT_TRUE(model.forward(X).isApprox(expected, 1e-12));
+}
+
+TEST(PruneTest, RepeatedIndicesAndTies) {
+    std::vector<std::unique_ptr<Layer>> layers;
+    std::vector<std::unique_ptr<ActivationFunction>> activations;
+    std::unique_ptr<LossFunction> loss = std::make_unique<MeanSquaredError>();
+    layers.emplace_back(std::make_unique<Linear>(2, 2));
+    layers[0]->W_ << 1.0, -1.0,
+                     1.0, 2.0;
+    Model model(layers, activations, loss);
+
+    // The layer is counted once, and of the three tied weights the first two
+    // (in storage order) are removed
+    ASSERT_EQ(magnitude_prune(model, {0, 0}, 0.5, PruneScope::Global, true), 2u);
+    SparseLinear* sparse = dynamic_cast<SparseLinear*>(layers[0].get());
+    ASSERT_NE(sparse, nullptr);
+    Eigen::MatrixXd expected(2, 2);
+    expected << 0.0, -1.0,
+                0.0, 2.0;
+    ASSERT_TRUE(sparse->dense().isApprox(expected, 1e-12));
+}
@@ -0,0 +1,98 @@
+#include <gtest/gtest.h>
+#include <Eigen/Dense>
+#include "../include/nn/layer.h"
+#include "../include/optim/sgd.h"
+#include <memory>
+#include <vector>
+
+TEST(SGDTest, LinearStep) {
+    std::vector<std::unique_ptr<Layer>> layers;
+    layers.emplace_back(std::make_unique<Linear>(2, 3));
+    Eigen::MatrixXd W = layers[0]->W_;
+    Eigen::MatrixXd b = layers[0]->b_;
+
+    Eigen::MatrixXd A(2, 2);
+    A << 1.0, 2.0,
+         3.0, 4.0;
+    layers[0]->forward(A);
+    layers[0]->backward(Eigen::MatrixXd::Ones(2, 3));
+
+    SGD sgd(layers, 0.1);
+    sgd.step();
+
+    ASSERT_TRUE(layers[0]->W_.isApprox(W - 0.1 * layers[0]->dLdW_, 1e-12));
+    ASSERT_TRUE(layers[0]->b_.isApprox(b - 0.1 * layers[0]->dLdb_, 1e-12));
+}
+
+TEST(SGDTest, EmbeddingStepTouchesOnlyLookedUpEntries) {
+    std::vector<std::unique_ptr<Layer>> layers;
+    layers.emplace_back(std::make_unique<Embedding>(5, 3));
+    Eigen::MatrixXd W = layers[0]->W_;
+
+    Eigen::MatrixXd A(3, 1);
+    A << 4,
+         1,
+         4;
+    layers[0]->forward(A);
+    layers[0]->backward(Eigen::MatrixXd::Ones(3, 3));
+
+    SGD sgd(layers, 0.5);
+    sgd.step();
+
+    Eigen::MatrixXd expected = W;
+    expected.col(1).array() -= 0.5;
+    expected.col(4).array() -= 1.0;
+    ASSERT_TRUE(layers[0]->W_.isApprox(expected, 1e-12));
+}
+
+TEST(SGDTest, LargeEmbeddingParallelStep) {
+    const size_t num_embeddings = 200000;
+    const size_t dim = 4;
+    const size_t N = 50000;
+    std::vector<std::unique_ptr<Layer>> layers;
+    layers.emplace_back(std::make_unique<Embedding>(num_embeddings, dim));
+    Eigen::MatrixXd W = layers[0]->W_;
+
+    Eigen::MatrixXd A(N, 2);
+    for (size_t n = 0; n < N; n++) {
+        A(n, 0) = (n * 104729) % num_embeddings;
+        A(n, 1) = (n * 31) % num_embeddings;
+    }
+    layers[0]->forward(A);
+    layers[0]->backward(Eigen::MatrixXd::Ones(N, 2 * dim));
+
+    SGD sgd(layers, 0.01);
+    sgd.step();
+
+    // Each entry moves by lr times the number of times it was looked up
+    Eigen::VectorXd counts = Eigen::VectorXd::Zero(num_embeddings);
+    for (size_t n = 0; n < N; n++) {
+        counts((n * 104729) % num_embeddings) += 1;
+        counts((n * 31) % num_embeddings) += 1;
+    }
+    Eigen::MatrixXd expected = W;
+    expected.rowwise() -= 0.01 * counts.transpose();
+    ASSERT_TRUE(layers[0]->W_.isApprox(expected, 1e-12));
+}
+
+TEST(SGDTest, HalfLinearStep) {
+    Linear linear(3, 2);
+    linear.W_ << 1.0, 2.0, 3.0,
+                 4.0, 5.0, 6.0;
+    std::vector<std::unique_ptr<Layer>> layers;
+    layers.emplace_back(std::make_unique<HalfLinear>(linear, HalfFormat::BFloat16));
+    Eigen::MatrixXd b = layers[0]->b_;
+
+    layers[0]->forward(Eigen::MatrixXd::Ones(1, 3));
+    layers[0]->backward(Eigen::MatrixXd::Ones(1, 2));
+
+    SGD sgd(layers, 0.5);
+    sgd.step();
+
+    Eigen::MatrixXd expected(2, 3);
+    expected << 0.5, 1.5, 2.5,
+                3.5, 4.5, 5.5;
+    HalfLinear* half = dynamic_cast<HalfLinear*>(layers[0].get());
+    ASSERT_TRUE(half->dense().isApprox(expected, 1e-12));
+    ASSERT_TRUE(half->b_.isApprox((b.array() - 0.5).matrix(), 1e-12));
+}
@@ -0,0 +1,109 @@
+#include <gtest/gtest.h>
+#include <Eigen/Dense>
+#include "../include/nn/model.h"
+#include "../include/optim/sgd.h"
+#include <memory>
+#include <vector>
+
+TEST(StackedTest, ForwardMatchesSeparateLayers) {
+    StackedLinear stacked(3, 5, 4);
+    Eigen::MatrixXd X = Eigen::MatrixXd::Random(7, 5);
+    Eigen::MatrixXd Xs = Eigen::MatrixXd::Random(7, 15);
+
+    Eigen::MatrixXd Z = stacked.forward(X);
+    Eigen::MatrixXd Zs = stacked.forward(Xs);
+
+    ASSERT_EQ(Z.cols(), 12);
+    for (size_t k = 0; k < 3; k++) {
+        std::unique_ptr<Linear> linear = stacked.unstack(k);
+        ASSERT_TRUE(Z.middleCols(k * 4, 4).isApprox(linear->forward(X), 1e-12));
+        ASSERT_TRUE(Zs.middleCols(k * 4, 4).isApprox(linear->forward(Xs.middleCols(k * 5, 5)), 1e-12));
+    }
+}
+
+TEST(StackedTest, BackwardMatchesSeparateLayers) {
+    StackedLinear stacked(2, 3, 4);
+    Eigen::MatrixXd Xs = Eigen::MatrixXd::Random(6, 6);
+    Eigen::MatrixXd dLdZ = Eigen::MatrixXd::Random(6, 8);
+
+    stacked.forward(Xs);
+    Eigen::MatrixXd dLdA = stacked.backward(dLdZ);
+
+    for (size_t k = 0; k < 2; k++) {
+        std::unique_ptr<Linear> linear = stacked.unstack(k);
+        linear->forward(Xs.middleCols(k * 3, 3));
+        Eigen::MatrixXd expected = linear->backward(dLdZ.middleCols(k * 4, 4));
+        ASSERT_TRUE(dLdA.middleCols(k * 3, 3).isApprox(expected, 1e-12));
+        ASSERT_TRUE(stacked.dLdW_.middleRows(k * 4, 4).isApprox(linear->dLdW_, 1e-12));
+        ASSERT_TRUE(stacked.dLdb_.middleRows(k * 4, 4).isApprox(linear->dLdb_, 1e-12));
+    }
+}
+
+TEST(StackedTest, TrainsLikeSeparateModels) {
+    const size_t K = 3;
+    const std::vector<double> lrs = {0.1, 0.01, 0.05};
+    Eigen::MatrixXd X = Eigen::MatrixXd::Random(16, 4);
+    Eigen::MatrixXd Y = Eigen::MatrixXd::Random(16, 2);
+
+    std::vector<std::unique_ptr<Layer>> layers;
+    std::vector<std::unique_ptr<ActivationFunction>> activations;
+    std::unique_ptr<LossFunction> loss = std::make_unique<StackedLoss>(
+        K, []() { return std::make_unique<MeanSquaredError>(); });
+    layers.emplace_back(std::make_unique<StackedLinear>(K, 4, 8));
+    layers.emplace_back(std::make_unique<StackedLinear>(K, 8, 2));
+    activations.emplace_back(std::make_unique<Tanh>());
+    activations.emplace_back(std::make_unique<Identity>());
+    Model model(layers, activations, loss);
+    SGD sgd(layers, lrs);
+
+    // The same K models, trained one by one
+    std::vector<std::vector<std::unique_ptr<Layer>>> single_layers(K);
+    std::vector<std::vector<std::unique_ptr<ActivationFunction>>> single_activations(K);
+    std::vector<std::unique_ptr<LossFunction>> single_losses(K);
+    std::vector<std::unique_ptr<Model>> singles;
+    std::vector<std::unique_ptr<SGD>> single_sgds;
+    for (size_t k = 0; k < K; k++) {
+        for (std::unique_ptr<Layer>& layer : layers) {
+            single_layers[k].push_back(static_cast<StackedLinear&>(*layer).unstack(k));
+        }
+        single_activations[k].emplace_back(std::make_unique<Tanh>());
+        single_activations[k].emplace_back(std::make_unique<Identity>());
+        single_losses[k] = std::make_unique<MeanSquaredError>();
+        singles.push_back(std::make_unique<Model>(single_layers[k], single_activations[k], single_losses[k]));
+        single_sgds.push_back(std::make_unique<SGD>(single_layers[k], lrs[k]));
+    }
+
+    StackedLoss& stacked_loss = static_cast<StackedLoss&>(*loss);
+    for (int step = 0; step < 5; step++) {
+        loss->forward(model.forward(X), Y);
+        model.backward();
+        sgd.step();
+        for (size_t k = 0; k < K; k++) {
+            double single_loss = single_losses[k]->forward(singles[k]->forward(X), Y);
+            singles[k]->backward();
+            single_sgds[k]->step();
+            ASSERT_NEAR(stacked_loss.losses_[k], single_loss, 1e-12);
+        }
+    }
+
+    for (size_t k = 0; k < K; k++) {
+        for (size_t l = 0; l < layers.size(); l++) {
+            std::unique_ptr<Linear> trained = static_cast<StackedLinear&>(*layers[l]).unstack(k);
+            ASSERT_TRUE(trained->W_.isApprox(single_layers[k][l]->W_, 1e-12));
+            ASSERT_TRUE(trained->b_.isApprox(single_layers[k][l]->b_, 1e-12));
+        }
+    }
+}
+
+TEST(StackedTest, StackReplacesOneModel) {
+    StackedLinear stacked(4, 3, 2);
+    Linear linear(3, 2);
+    Eigen::MatrixXd before = stacked.W_;
+
+    stacked.stack(2, linear);
+
+    ASSERT_TRUE(stacked.W_.middleRows(4, 2).isApprox(linear.W_));
+    ASSERT_TRUE(stacked.W_.topRows(4).isApprox(before.topRows(4)));
+    ASSERT_TRUE(stacked.W_.bottomRows(2).isApprox(before.bottomRows(2)));
+    ASSERT_TRUE(stacked.unstack(2)->b_.isApprox(linear.b_));
+}
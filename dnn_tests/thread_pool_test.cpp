@@ -0,0 +1,122 @@
+#include <gtest/gtest.h>
+#include <Eigen/Dense>
+#include "../include/nn/activation.h"
+#include "../include/nn/layer.h"
+#include "../include/nn/loss.h"
+#include "../include/utils/gemm.h"
+#include "../include/utils/parallel.h"
+#include "../include/utils/thread_pool.h"
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+TEST(ThreadPoolTest, RunsEveryTaskOnce) {
+    ThreadPool pool(4);
+    ASSERT_EQ(pool.num_threads(), 4);
+    std::vector<std::atomic<int>> counts(1000);
+    pool.run(counts.size(), [&](size_t i) { counts[i]++; });
+    for (const std::atomic<int>& count : counts) {
+        ASSERT_EQ(count.load(), 1);
+    }
+}
+
+TEST(ThreadPoolTest, NestedParallelFor) {
+    ThreadPool::configure(4);
+    std::atomic<size_t> sum(0);
+    parallel_for(0, 64, 1, [&](size_t lo, size_t hi) {
+        for (size_t i = lo; i < hi; i++) {
+            parallel_for(0, 100, 1, [&](size_t lo2, size_t hi2) {
+                for (size_t j = lo2; j < hi2; j++) {
+                    sum += i * 100 + j;
+                }
+            });
+        }
+    });
+    ASSERT_EQ(sum.load(), 6400 * 6399 / 2);
+    ThreadPool::configure(0);
+}
+
+TEST(ThreadPoolTest, SerialScopeRunsOnCallingThread) {
+    ThreadPool::configure(4);
+    std::thread::id self = std::this_thread::get_id();
+    {
+        SerialScope serial;
+        size_t calls = 0;
+        parallel_for(0, 1000, 1, [&](size_t lo, size_t hi) {
+            ASSERT_EQ(std::this_thread::get_id(), self);
+            ASSERT_EQ(lo, 0);
+            ASSERT_EQ(hi, 1000);
+            calls++;
+        });
+        ASSERT_EQ(calls, 1);
+    }
+    std::atomic<size_t> calls(0);
+    parallel_for(0, 1000, 1, [&](size_t, size_t) { calls++; });
+    ASSERT_GT(calls.load(), 1);
+    ThreadPool::configure(0);
+}
+
+TEST(ThreadPoolTest, RethrowsTaskException) {
+    ThreadPool pool(3);
+    std::atomic<int> ran(0);
+    ASSERT_THROW(pool.run(50, [&](size_t i) {
+        ran++;
+        if (i == 7) {
+            throw std::runtime_error("task failed");
+        }
+    }), std::runtime_error);
+    ASSERT_EQ(ran.load(), 50);
+}
+
+TEST(ThreadPoolTest, PinsWorkersToAllowedCores) {
+    for (ThreadAffinity affinity : {ThreadAffinity::Compact, ThreadAffinity::Scatter}) {
+        ThreadPool pool(3, affinity);
+        for (size_t i = 0; i + 1 < pool.num_threads(); i++) {
+            ASSERT_GE(pool.worker_cpu(i), 0);
+        }
+        std::atomic<int> ran(0);
+        pool.run(10, [&](size_t) { ran++; });
+        ASSERT_EQ(ran.load(), 10);
+    }
+}
+
+TEST(ThreadPoolTest, KernelsMatchSingleThread) {
+    Eigen::MatrixXd Z = Eigen::MatrixXd::Random(300, 257) * 4;
+    Eigen::MatrixXd dLdA = Eigen::MatrixXd::Random(300, 257);
+    Eigen::MatrixXd X = Eigen::MatrixXd::Random(300, 129);
+    Linear linear(129, 257);
+    ReLU relu;
+    Sigmoid sigmoid;
+    Tanh tanh;
+    SoftmaxCrossEntropy ce;
+
+    auto run_all = [&]() {
+        std::vector<Eigen::MatrixXd> out;
+        for (ActivationFunction* f : std::vector<ActivationFunction*>{&relu, &sigmoid, &tanh}) {
+            out.push_back(f->forward(Z));
+            out.push_back(f->backward(dLdA));
+        }
+        out.push_back(ce.softmax(Z));
+        for (GemmBackend backend : {GemmBackend::Eigen, GemmBackend::Packed}) {
+            set_gemm_backend(backend);
+            out.push_back(linear.forward(X));
+            out.push_back(linear.backward(dLdA));
+            out.push_back(linear.dLdW_);
+            out.push_back(linear.dLdb_);
+        }
+        set_gemm_backend(GemmBackend::Eigen);
+        return out;
+    };
+
+    ThreadPool::configure(1);
+    std::vector<Eigen::MatrixXd> serial = run_all();
+    ThreadPool::configure(4, ThreadAffinity::Compact);
+    std::vector<Eigen::MatrixXd> parallel = run_all();
+    ThreadPool::configure(0);
+
+    ASSERT_EQ(serial.size(), parallel.size());
+    for (size_t k = 0; k < serial.size(); k++) {
+        ASSERT_TRUE(parallel[k].isApprox(serial[k], 1e-12)) << k;
+    }
+}
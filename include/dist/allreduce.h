@@ -0,0 +1,101 @@
+/**
+ * @file allreduce.h
+ * @author Krish Suraparaju (csurapar@andrew.cmu.edu)
+ * @brief Collective operations between processes on the same host, through
+ * POSIX shared memory.
+ *
+ * Every participating process (rank) opens the same named shared memory
+ * segment, which holds one input slot per rank, a result area, and a barrier.
+ * An all-reduce of a buffer then runs in three phases:
+ * 1. Every rank copies its buffer into its own slot.
+ * 2. Reduce-scatter: the buffer is split into one chunk per rank, and rank r
+ *    sums chunk r over all the slots into the result area.
+ * 3. All-gather: every rank copies the whole result area back.
+ * Each rank reads and writes 1/world_size of the reduction, the same traffic a
+ * ring all-reduce has, but every phase is a single step since all the slots
+ * are directly addressable. Buffers larger than a slot are reduced in pieces.
+ *
+ * No network is involved, so this only scales within one machine (e.g. across
+ * NUMA nodes, where separate processes keep their memory local).
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef ALLREDUCE_H
+#define ALLREDUCE_H
+
+#include <cstddef>
+#include <string>
+
+class ShmAllReduce {
+public:
+    size_t rank_;        // Index of this process, in [0, world_size)
+    size_t world_size_;  // Number of participating processes
+    size_t capacity_;    // Number of doubles per slot
+
+    /**
+     * @brief Rank 0 creates the shared segment, replacing any segment left
+     * under the same name by an earlier run; the other ranks wait for it and
+     * attach. Then waits until all ranks have attached. Throws
+     * std::runtime_error if the segment cannot be created, opened or mapped.
+     *
+     * @param name The name of the segment, must be the same for every rank
+     * @param rank The index of this process
+     * @param world_size The number of participating processes
+     * @param capacity The number of doubles reduced per piece
+     */
+    ShmAllReduce(const std::string& name, size_t rank, size_t world_size,
+                 size_t capacity = 1 << 18);
+
+    /**
+     * @brief Unmaps the segment.
+     */
+    ~ShmAllReduce();
+
+    ShmAllReduce(const ShmAllReduce&) = delete;
+    ShmAllReduce& operator=(const ShmAllReduce&) = delete;
+
+    /**
+     * @brief Replaces data with the sum over all ranks. Must be called by every
+     * rank with the same count.
+     *
+     * @param data The buffer to reduce in place
+     * @param count The number of doubles in the buffer
+     */
+    void allreduce_sum(double* data, size_t count);
+
+    /**
+     * @brief Replaces data with the mean over all ranks.
+     *
+     * @param data The buffer to reduce in place
+     * @param count The number of doubles in the buffer
+     */
+    void allreduce_mean(double* data, size_t count);
+
+    /**
+     * @brief Replaces data on every rank with the data of the root rank.
+     *
+     * @param data The buffer to broadcast into
+     * @param count The number of doubles in the buffer
+     * @param root The rank whose data is kept
+     */
+    void broadcast(double* data, size_t count, size_t root = 0);
+
+    /**
+     * @brief Blocks until every rank has called barrier.
+     */
+    void barrier();
+
+private:
+    struct Header;
+    Header* header_;
+    double* slots_;   // world_size slots of capacity doubles
+    double* result_;  // capacity doubles
+    size_t bytes_;
+};
+
+#endif // ALLREDUCE_H
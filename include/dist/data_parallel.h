@@ -0,0 +1,70 @@
+/**
+ * @file data_parallel.h
+ * @author Krish Suraparaju (csurapar@andrew.cmu.edu)
+ * @brief Data-parallel training with one Model replica per process.
+ *
+ * Every process trains its own replica of the model on its own shard of the
+ * mini-batch. After the backward pass, the gradients (dLdW_ and dLdb_ of every
+ * layer) are averaged over all processes with a shared memory all-reduce, so
+ * every replica takes the same optimizer step and the replicas stay identical.
+ *
+ * To hide the cost of the reduction, gradients are grouped into buckets in the
+ * order backward produces them (last layer first). As soon as a bucket is full
+ * it is reduced on a communication thread, while the main thread continues the
+ * backward pass through the earlier layers.
+ *
+ * Only dense gradients are reduced; Embedding layers are not supported.
+ *
+ * The ranks are usually forked from one process. fork only copies the calling
+ * thread, so a worker of the global thread pool holding a lock at that moment
+ * would leave it locked forever in the child. Fork the ranks before the first
+ * parallel_for (or call ThreadPool::configure(1) first); each rank can then
+ * configure its own pool.
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef DATA_PARALLEL_H
+#define DATA_PARALLEL_H
+
+#include <Eigen/Dense>
+#include <vector>
+#include "allreduce.h"
+#include "../nn/model.h"
+
+class DataParallel {
+public:
+    Model& model_;
+    ShmAllReduce& comm_;
+    size_t bucket_size_;  // Minimum number of doubles per bucket
+
+    /**
+     * @brief Construct a new DataParallel object. Does not communicate, call
+     * broadcast_parameters to make the replicas start out identical.
+     *
+     * @param model This process' replica
+     * @param comm The communicator shared by all the processes
+     * @param bucket_size The number of doubles after which a bucket is reduced
+     */
+    DataParallel(Model& model, ShmAllReduce& comm, size_t bucket_size = 1 << 16)
+        : model_(model), comm_(comm), bucket_size_(bucket_size) {}
+
+    /**
+     * @brief Copies the weights and biases of rank 0 into every replica, in
+     * whatever form each layer stores them (see Layer::weights).
+     */
+    void broadcast_parameters();
+
+    /**
+     * @brief Runs Model::backward on this replica and averages the gradients
+     * of every layer over all the processes, overlapping the two. Must be
+     * called by every process, after the loss forward pass.
+     */
+    void backward();
+};
+
+#endif // DATA_PARALLEL_H
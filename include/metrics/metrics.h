@@ -0,0 +1,212 @@
+/**
+ * @file metrics.h
+ * @author Krish Suraparaju (csurapar@andrew.cmu.edu)
+ * @brief Evaluation metrics that are accumulated batch by batch.
+ *
+ * A metric only keeps running counts or sums, never the predictions, so
+ * evaluating a data set of any size takes constant memory:
+ * 1. update(P, Y) adds one batch of predictions P and targets Y.
+ * 2. merge(other) adds the counts of another metric of the same kind, so
+ *    every thread can accumulate its own partial result.
+ * 3. result() returns the metric over everything seen so far.
+ *
+ * Classification metrics take one row of scores per sample (the class with
+ * the largest score is predicted; with a single column, the sample is
+ * predicted to be class 1 when its score is at least 0.5). Targets are either
+ * one-hot rows, or a single column holding the class index.
+ *
+ * evaluate() runs a model over a stream of batches on the thread pool, using
+ * the inference-only Model::predict, and merges the partial results.
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <Eigen/Dense>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "../nn/model.h"
+
+// Base Metric class
+class Metric {
+public:
+    virtual ~Metric() {}
+
+    /**
+     * @brief Adds a batch of predictions and their targets.
+     *
+     * @param P The predictions, one row per sample
+     * @param Y The targets, one row per sample
+     */
+    virtual void update(const Eigen::MatrixXd& P, const Eigen::MatrixXd& Y) = 0;
+
+    /**
+     * @brief Adds the partial result of another metric of the same type and
+     * configuration, e.g. one accumulated by another thread.
+     *
+     * @param other The metric to merge in
+     */
+    virtual void merge(const Metric& other) = 0;
+
+    /**
+     * @brief The value of the metric over everything seen so far.
+     */
+    virtual double result() const = 0;
+
+    /**
+     * @brief Forgets everything seen so far.
+     */
+    virtual void reset() = 0;
+
+    /**
+     * @brief A new, empty metric of the same type and configuration, to
+     * accumulate a partial result in.
+     */
+    virtual std::unique_ptr<Metric> fresh() const = 0;
+};
+
+// Fraction of samples whose target class is among the k highest scores
+class TopKAccuracy : public Metric {
+public:
+    size_t k_;
+    size_t correct_ = 0;
+    size_t total_ = 0;
+
+    explicit TopKAccuracy(size_t k) : k_(k) {}
+
+    void update(const Eigen::MatrixXd& P, const Eigen::MatrixXd& Y) override;
+    void merge(const Metric& other) override;
+    double result() const override;
+    void reset() override;
+    std::unique_ptr<Metric> fresh() const override;
+};
+
+// Fraction of samples whose predicted class is the target class
+class Accuracy : public TopKAccuracy {
+public:
+    Accuracy() : TopKAccuracy(1) {}
+    std::unique_ptr<Metric> fresh() const override;
+};
+
+/**
+ * @brief Counts of (target class, predicted class) pairs. Precision, recall
+ * and F1 are all derived from it. result() is the accuracy.
+ */
+class ConfusionMatrix : public Metric {
+public:
+    size_t num_classes_;
+    std::vector<size_t> counts_;  // counts_[target * num_classes_ + predicted]
+
+    explicit ConfusionMatrix(size_t num_classes)
+        : num_classes_(num_classes), counts_(num_classes * num_classes, 0) {}
+
+    /**
+     * @brief Number of samples of class target predicted as class predicted.
+     */
+    size_t count(size_t target, size_t predicted) const {
+        return this->counts_[target * this->num_classes_ + predicted];
+    }
+
+    /**
+     * @brief Of the samples predicted as class c, the fraction that are of class c.
+     * 0 if no sample was predicted as c.
+     */
+    double precision(size_t c) const;
+
+    /**
+     * @brief Of the samples of class c, the fraction predicted as class c.
+     * 0 if there was no sample of class c.
+     */
+    double recall(size_t c) const;
+
+    /**
+     * @brief Harmonic mean of the precision and recall of class c.
+     */
+    double f1(size_t c) const;
+
+    // Unweighted means over all classes
+    double macro_precision() const;
+    double macro_recall() const;
+    double macro_f1() const;
+
+    void update(const Eigen::MatrixXd& P, const Eigen::MatrixXd& Y) override;
+    void merge(const Metric& other) override;
+    double result() const override;
+    void reset() override;
+    std::unique_ptr<Metric> fresh() const override;
+};
+
+// Macro-averaged precision
+class Precision : public ConfusionMatrix {
+public:
+    explicit Precision(size_t num_classes) : ConfusionMatrix(num_classes) {}
+    double result() const override { return this->macro_precision(); }
+    std::unique_ptr<Metric> fresh() const override;
+};
+
+// Macro-averaged recall
+class Recall : public ConfusionMatrix {
+public:
+    explicit Recall(size_t num_classes) : ConfusionMatrix(num_classes) {}
+    double result() const override { return this->macro_recall(); }
+    std::unique_ptr<Metric> fresh() const override;
+};
+
+// Macro-averaged F1 score
+class F1Score : public ConfusionMatrix {
+public:
+    explicit F1Score(size_t num_classes) : ConfusionMatrix(num_classes) {}
+    double result() const override { return this->macro_f1(); }
+    std::unique_ptr<Metric> fresh() const override;
+};
+
+// Mean of the squared differences, over all entries of all samples
+class MeanSquaredErrorMetric : public Metric {
+public:
+    double sum_ = 0.0;
+    size_t count_ = 0;
+
+    void update(const Eigen::MatrixXd& P, const Eigen::MatrixXd& Y) override;
+    void merge(const Metric& other) override;
+    double result() const override;
+    void reset() override;
+    std::unique_ptr<Metric> fresh() const override;
+};
+
+// Mean of the absolute differences, over all entries of all samples
+class MeanAbsoluteErrorMetric : public MeanSquaredErrorMetric {
+public:
+    void update(const Eigen::MatrixXd& P, const Eigen::MatrixXd& Y) override;
+    std::unique_ptr<Metric> fresh() const override;
+};
+
+/**
+ * @brief Fills X and Y with the next batch and returns true, or returns false
+ * once the data set is exhausted. evaluate() calls it from one thread at a
+ * time, under a lock, so it must not itself wait on the thread pool.
+ */
+typedef std::function<bool(Eigen::MatrixXd& X, Eigen::MatrixXd& Y)> BatchSource;
+
+/**
+ * @brief Evaluates the model on every batch of the source. Batches are pulled
+ * by several threads; each runs Model::predict and updates its own copies of
+ * the metrics, which are merged into the given metrics at the end.
+ *
+ * @param model The model to evaluate
+ * @param next_batch The source of (input, target) batches
+ * @param metrics The metrics to accumulate into
+ * @param num_workers The number of batches evaluated at once, 0 for one per
+ *                    thread of the pool
+ */
+void evaluate(const Model& model, const BatchSource& next_batch,
+              const std::vector<Metric*>& metrics, size_t num_workers = 0);
+
+#endif // METRICS_H
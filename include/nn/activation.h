@@ -31,6 +31,8 @@
 #define ACTIVATION_H
 
 #include <Eigen/Dense>
+#include <memory>
+#include <utility>
 
 // Base ActivationFunction class
 class ActivationFunction {
@@ -41,6 +43,21 @@ public:
      *
      */
     Eigen::MatrixXd A_;
+    const double* A_view_ = nullptr;  // Output kept by forward_view instead of A_, owned by the caller
+    Eigen::Index A_view_rows_ = 0;
+    Eigen::Index A_view_cols_ = 0;
+
+    /**
+     * @brief The forward state parked by swap_cache: the cached output, or the
+     * view of it kept by forward_view.
+     */
+    struct Cache {
+        Eigen::MatrixXd A;
+        const double* A_view = nullptr;
+        Eigen::Index A_view_rows = 0;
+        Eigen::Index A_view_cols = 0;
+    };
+
     /**
      * @brief Construct a new Activation Function object
      *
@@ -53,6 +70,40 @@ public:
      */
     virtual ~ActivationFunction() {}
 
+    /**
+     * @brief A copy of the activation function and its configuration, e.g. to
+     * publish a snapshot of a model that keeps training (see Layer::clone).
+     * The default throws std::runtime_error.
+     *
+     * @return std::unique_ptr<ActivationFunction> The copy
+     */
+    virtual std::unique_ptr<ActivationFunction> clone() const;
+
+    /**
+     * @brief Exchanges the cached output with the given cache, so that a
+     * forward pass can be parked while other forward passes run (see
+     * Layer::swap_cache).
+     *
+     * @param cache The cache to swap with
+     */
+    virtual void swap_cache(Cache& cache) {
+        this->A_.swap(cache.A);
+        std::swap(this->A_view_, cache.A_view);
+        std::swap(this->A_view_rows_, cache.A_view_rows);
+        std::swap(this->A_view_cols_, cache.A_view_cols);
+    }
+
+    /**
+     * @brief The output cached by the last forward pass: a view of A_, or of
+     * the caller's buffer after forward_view.
+     */
+    Eigen::Map<const Eigen::MatrixXd> cached_output() const {
+        if (this->A_view_ != nullptr) {
+            return Eigen::Map<const Eigen::MatrixXd>(this->A_view_, this->A_view_rows_, this->A_view_cols_);
+        }
+        return Eigen::Map<const Eigen::MatrixXd>(this->A_.data(), this->A_.rows(), this->A_.cols());
+    }
+
     /**
      * @brief Applies the activation function to the input Z
      *
@@ -61,6 +112,36 @@ public:
      */
     virtual Eigen::MatrixXd forward(const Eigen::MatrixXd& Z) = 0;
 
+    /**
+     * @brief Inference-only forward pass: same output as forward, without
+     *        caching A_, so it can run on several threads at once. The
+     *        default runs forward and then restores the cache, one call at a
+     *        time; activations override it to run concurrently.
+     *
+     * @param Z The input from the previous layer (before-activation)
+     * @return Eigen::MatrixXd The activated output
+     */
+    virtual Eigen::MatrixXd predict(const Eigen::MatrixXd& Z) const;
+
+    /**
+     * @brief Same as forward, but reads Z in place, writes the output into A
+     *        (a buffer of the caller with the shape of Z) and, if keeps_view(),
+     *        keeps a view of A for backward instead of a copy in A_. The caller
+     *        must then leave A unchanged until the matching backward (see
+     *        Graph). By default Z is copied and passed to forward.
+     *
+     * @param Z The input from the previous layer (before-activation)
+     * @param A Where to write the activated output
+     */
+    virtual void forward_view(Eigen::Map<const Eigen::MatrixXd> Z, Eigen::Map<Eigen::MatrixXd> A) {
+        A = this->forward(Eigen::MatrixXd(Z));
+    }
+
+    /**
+     * @brief Whether forward_view keeps a view of its output for backward.
+     */
+    virtual bool keeps_view() const { return false; }
+
     /**
      * @brief Computes the derivative of the activation function,
      *        dL/dZ, where L is the loss and Z is the input. Note that
@@ -76,21 +157,56 @@ public:
 // Concrete class for the ReLU activation function
 class ReLU : public ActivationFunction {
 public:
+    std::unique_ptr<ActivationFunction> clone() const override { return std::make_unique<ReLU>(*this); }
     Eigen::MatrixXd forward(const Eigen::MatrixXd& Z) override;
+    Eigen::MatrixXd predict(const Eigen::MatrixXd& Z) const override;
+    void forward_view(Eigen::Map<const Eigen::MatrixXd> Z, Eigen::Map<Eigen::MatrixXd> A) override;
+    bool keeps_view() const override { return true; }
     Eigen::MatrixXd backward(const Eigen::MatrixXd& dLdA) override;
 };
 
 // Concrete class for the Sigmoid activation function
 class Sigmoid : public ActivationFunction {
 public:
+    std::unique_ptr<ActivationFunction> clone() const override { return std::make_unique<Sigmoid>(*this); }
     Eigen::MatrixXd forward(const Eigen::MatrixXd& Z) override;
+    Eigen::MatrixXd predict(const Eigen::MatrixXd& Z) const override;
+    void forward_view(Eigen::Map<const Eigen::MatrixXd> Z, Eigen::Map<Eigen::MatrixXd> A) override;
+    bool keeps_view() const override { return true; }
     Eigen::MatrixXd backward(const Eigen::MatrixXd& dLdA) override;
 };
 
 // Concrete class for the Tanh activation function
 class Tanh : public ActivationFunction {
 public:
+    std::unique_ptr<ActivationFunction> clone() const override { return std::make_unique<Tanh>(*this); }
+    Eigen::MatrixXd forward(const Eigen::MatrixXd& Z) override;
+    Eigen::MatrixXd predict(const Eigen::MatrixXd& Z) const override;
+    void forward_view(Eigen::Map<const Eigen::MatrixXd> Z, Eigen::Map<Eigen::MatrixXd> A) override;
+    bool keeps_view() const override { return true; }
+    Eigen::MatrixXd backward(const Eigen::MatrixXd& dLdA) override;
+};
+
+// Concrete class for the Identity activation function. Used as a placeholder
+// for a layer that is not followed by a nonlinearity.
+class Identity : public ActivationFunction {
+public:
+    std::unique_ptr<ActivationFunction> clone() const override { return std::make_unique<Identity>(*this); }
+    Eigen::MatrixXd forward(const Eigen::MatrixXd& Z) override;
+    Eigen::MatrixXd predict(const Eigen::MatrixXd& Z) const override;
+    void forward_view(Eigen::Map<const Eigen::MatrixXd> Z, Eigen::Map<Eigen::MatrixXd> A) override;
+    Eigen::MatrixXd backward(const Eigen::MatrixXd& dLdA) override;
+};
+
+// Concrete class for multiplying by a constant, A = s * Z
+class Scale : public ActivationFunction {
+public:
+    double scale_;
+    explicit Scale(double scale) : scale_(scale) {}
+    std::unique_ptr<ActivationFunction> clone() const override { return std::make_unique<Scale>(*this); }
     Eigen::MatrixXd forward(const Eigen::MatrixXd& Z) override;
+    Eigen::MatrixXd predict(const Eigen::MatrixXd& Z) const override;
+    void forward_view(Eigen::Map<const Eigen::MatrixXd> Z, Eigen::Map<Eigen::MatrixXd> A) override;
     Eigen::MatrixXd backward(const Eigen::MatrixXd& dLdA) override;
 };
 
@@ -0,0 +1,98 @@
+/**
+ * @file attention.h
+ * @author Krish Suraparaju (csurapar@andrew.cmu.edu)
+ * @brief Multi-head self-attention, the core of a transformer encoder.
+ *
+ * The input holds B sequences of T tokens each, one token per row, so it is a
+ * (B * T) x d_model matrix whose rows b*T .. b*T + T - 1 are sequence b. Three
+ * Linear layers project it to queries Q, keys K and values V, whose columns
+ * are split into H heads of d_model / H columns. Every head of every sequence
+ * computes O = softmax(Q K^T / sqrt(d_head)) V, the heads are concatenated
+ * again, and a fourth Linear layer projects the result to the output.
+ *
+ * The T x T attention matrix is never materialized. As in FlashAttention,
+ * Q is processed in blocks of rows, K and V in blocks of rows, and the softmax
+ * is computed online: for every query row we keep the running maximum m and
+ * the running sum l of exp(s - m), and rescale the partial output whenever m
+ * grows. Backward recomputes the scores block by block from Q, K and the
+ * per-row log-sum-exp m + log(l) saved by forward. The blocks are sized so
+ * that a block of Q, K, V and the scores between them stay in L1/L2, and the
+ * (sequence, head) pairs are independent, so they run on the thread pool.
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef ATTENTION_H
+#define ATTENTION_H
+
+#include <Eigen/Dense>
+#include <memory>
+#include <vector>
+#include "layer.h"
+
+class MultiHeadAttention : public Layer {
+public:
+    size_t seq_len_;    // T, the number of tokens per sequence
+    size_t num_heads_;  // H
+    size_t head_dim_;   // d_model / H
+
+    Linear query_;   // d_model -> d_model
+    Linear key_;     // d_model -> d_model
+    Linear value_;   // d_model -> d_model
+    Linear output_;  // d_model -> d_model
+
+    /**
+     * @brief Forward state: the projections, the concatenated heads before
+     * the output projection, and the log-sum-exp of every query row of every
+     * head ((B * T) x H).
+     */
+    Eigen::MatrixXd Q_, K_, V_, O_, LSE_;
+
+    /**
+     * @brief Construct a new MultiHeadAttention object. Its own W_ and b_ are
+     * empty, the parameters live in the four projections.
+     *
+     * @param d_model The size of every token
+     * @param num_heads The number of heads, must divide d_model
+     * @param seq_len The number of tokens per sequence
+     */
+    MultiHeadAttention(size_t d_model, size_t num_heads, size_t seq_len);
+
+    /**
+     * @brief Applies self-attention to every sequence of the input.
+     *
+     * @param A The (B * T) x d_model input
+     * @return Eigen::MatrixXd The (B * T) x d_model output
+     */
+    Eigen::MatrixXd forward(const Eigen::MatrixXd& A) override;
+    Eigen::MatrixXd predict(const Eigen::MatrixXd& A) const override;
+    std::unique_ptr<Layer> clone() const override { return std::make_unique<MultiHeadAttention>(*this); }
+
+    /**
+     * @brief Computes the gradients of the four projections and returns the
+     * gradient with respect to the input.
+     *
+     * @param dLdZ The gradient of the loss with respect to the output
+     * @return Eigen::MatrixXd The gradient of the loss with respect to the input A
+     */
+    Eigen::MatrixXd backward(const Eigen::MatrixXd& dLdZ) override;
+
+    std::vector<Layer*> children() override { return {&query_, &key_, &value_, &output_}; }
+
+    void swap_cache(Cache& cache) override;
+
+    /**
+     * @brief Bytes held for the backward pass (the cached inputs of the
+     * projections and the attention state). Grows linearly with T.
+     */
+    size_t cache_bytes() const override;
+
+private:
+    std::vector<Eigen::MatrixXd*> cached();
+};
+
+#endif // ATTENTION_H
@@ -0,0 +1,117 @@
+/**
+ * @file autotune.h
+ * @author Krish Suraparaju (csurapar@andrew.cmu.edu)
+ * @brief Picks the batch size, thread count and GEMM backend (and micro-kernel)
+ * that run a given model fastest on the current machine.
+ *
+ * The best settings depend on the widths of the layers and on the caches and
+ * cores of the host, so instead of guessing, autotune times the model itself:
+ * for every combination of GEMM backend, size of the global thread pool and
+ * batch size, it runs a training step (forward, loss and backward) or an
+ * inference pass (predict) on batches built from sample data, and measures
+ * the latency of one batch and the throughput in samples per second. It then
+ * picks the fastest setting, either by throughput or by latency, among those
+ * that meet the given constraints. The packed backend counts as one backend
+ * per micro-kernel the CPU supports (portable, AVX2, AVX-512), since which
+ * kernel wins depends on the layer shapes as much as on the hardware.
+ *
+ * The result is a TuneProfile, which can be saved to a small text file and
+ * loaded by the trainer or the inference code at startup, e.g.
+ *
+ *     TuneProfile profile = load_profile("model.tune");
+ *     apply_profile(profile);  // Sets the thread pool, GEMM backend and kernel
+ *     ... train with batches of profile.batch_size ...
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef AUTOTUNE_H
+#define AUTOTUNE_H
+
+#include <Eigen/Dense>
+#include <string>
+#include <vector>
+#include "model.h"
+#include "../utils/gemm.h"
+
+enum class TuneObjective {
+    Throughput,  // Most samples per second
+    Latency      // Least time per batch
+};
+
+// One setting and how fast the model ran with it
+struct TuneProfile {
+    size_t batch_size = 0;
+    size_t num_threads = 0;
+    GemmBackend backend = GemmBackend::Eigen;
+    GemmKernel kernel = GemmKernel::Portable;  // Only meaningful for the packed backend
+    bool training = true;  // Timed a training step, or an inference pass
+    double latency_ms = 0.0;  // Time per batch
+    double samples_per_sec = 0.0;
+};
+
+struct TuneOptions {
+    std::vector<size_t> batch_sizes = {1, 8, 32, 64, 128, 256};
+    std::vector<size_t> thread_counts;  // Empty for 1, 2, 4, ... up to the number of cores
+    std::vector<GemmBackend> backends;  // Empty for every available backend
+    std::vector<GemmKernel> kernels;  // Packed kernels to try, empty for every supported one
+    bool training = true;  // Time forward + loss + backward, or only predict
+    TuneObjective objective = TuneObjective::Throughput;
+    double max_latency_ms = 0.0;   // Only consider settings at most this slow per batch (0 for any)
+    double min_samples_per_sec = 0.0;  // Only consider settings at least this fast (0 for any)
+    double min_time_ms = 20.0;  // Time every setting for at least this long
+};
+
+struct TuneResult {
+    TuneProfile best;
+    std::vector<TuneProfile> measurements;  // Every setting that was timed
+};
+
+/**
+ * @brief Times the model with every combination of the options and returns
+ * the best setting. The global thread pool, GEMM backend and packed kernel are
+ * changed while tuning and restored afterwards (the pool keeps its size but is no longer
+ * pinned). The parameters of the model are not changed, as no optimizer step
+ * is taken. Throws std::runtime_error if no setting meets the constraints.
+ *
+ * @param model The model to tune
+ * @param X Sample inputs, one per row; batches repeat them as needed
+ * @param Y The targets of the samples (only used when training)
+ * @param options What to try and how to choose
+ * @return TuneResult The best setting and all the measurements
+ */
+TuneResult autotune(Model& model, const Eigen::MatrixXd& X, const Eigen::MatrixXd& Y,
+                    const TuneOptions& options = TuneOptions());
+
+/**
+ * @brief Configures the global thread pool and GEMM backend as in the profile,
+ * and the packed micro-kernel if the backend is packed. A kernel the CPU does
+ * not support (e.g. a profile tuned on another machine) falls back to the
+ * fastest supported one. The batch size is up to the caller.
+ *
+ * @param profile The settings to use
+ */
+void apply_profile(const TuneProfile& profile);
+
+/**
+ * @brief Writes the profile to a text file of key=value lines.
+ *
+ * @param path The file to write
+ * @param profile The profile to save
+ */
+void save_profile(const std::string& path, const TuneProfile& profile);
+
+/**
+ * @brief Reads a profile written by save_profile. Throws std::runtime_error
+ * if the file cannot be read or is malformed.
+ *
+ * @param path The file to read
+ * @return TuneProfile The profile
+ */
+TuneProfile load_profile(const std::string& path);
+
+#endif // AUTOTUNE_H
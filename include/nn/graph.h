@@ -0,0 +1,179 @@
+/**
+ * @file graph.h
+ * @author Krish Suraparaju (csurapar@andrew.cmu.edu)
+ * @brief A small tape-based autograd engine for models that are not a plain
+ * chain of layers.
+ *
+ * Model only supports layer i followed by activation i. A Graph records the
+ * operations of a network on a tape instead, in the order they are added, so
+ * any directed acyclic graph can be expressed: skip connections (add), branches
+ * that are merged again (concat), and layers that are used more than once
+ * (shared weights). The operations reuse the existing Layer and
+ * ActivationFunction kernels. Forward replays the tape, backward replays it in
+ * reverse and accumulates the gradients of shared layers.
+ *
+ * Before the first run with a given batch size, a static memory planning pass
+ * computes for every value (the inputs, which are copied in, and every
+ * intermediate) and every gradient the range of tape steps during which it is
+ * alive, and assigns it an offset in one shared arena so that buffers whose
+ * lifetimes do not overlap share memory. The state saved for backward is part
+ * of the plan: layers and activations run through forward_view, so they read
+ * their input in place and only keep a view into the arena (a layer of its
+ * input, an activation of its output) instead of a copy. A value is alive
+ * until its last consumer has run or, if one of them keeps a view of it, until
+ * that consumer's backward step; a gradient is alive from its first
+ * contribution until the operation that produced the value has propagated it.
+ * Layers that cannot work from a view (e.g. MultiHeadAttention) still copy
+ * their state, which cache_bytes() reports.
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef GRAPH_H
+#define GRAPH_H
+
+#include <Eigen/Dense>
+#include <vector>
+#include "activation.h"
+#include "layer.h"
+#include "loss.h"
+
+class Graph {
+public:
+    typedef size_t Value;  // Handle to the output of an operation on the tape
+
+    /**
+     * @brief Adds an input to the graph. Inputs are fed to forward in the
+     * order they were added.
+     *
+     * @param cols The number of columns of the input
+     * @return Value The input value
+     */
+    Value input(size_t cols);
+
+    /**
+     * @brief Applies a layer. The graph does not own the layer, and the same
+     * layer can be applied several times; its gradients are then summed (for
+     * an Embedding, the sparse rows of all uses are merged).
+     *
+     * @param layer The layer to apply
+     * @param x The input of the layer
+     * @return Value The output of the layer
+     */
+    Value layer(Layer& layer, Value x);
+
+    /**
+     * @brief Applies an activation function. Like layers, activation objects
+     * can be applied several times.
+     *
+     * @param activation The activation function to apply
+     * @param x The input of the activation
+     * @return Value The activated output
+     */
+    Value activation(ActivationFunction& activation, Value x);
+
+    /**
+     * @brief Elementwise sum of two values of the same shape, e.g. a residual
+     * connection.
+     */
+    Value add(Value a, Value b);
+
+    /**
+     * @brief Concatenates the columns of two values, e.g. to merge branches.
+     */
+    Value concat(Value a, Value b);
+
+    /**
+     * @brief Marks the value returned by forward and seeded by backward.
+     * Defaults to the last value added.
+     */
+    void set_output(Value output);
+
+    /**
+     * @brief Runs the tape forward.
+     *
+     * @param inputs One matrix per input, all with the same number of rows.
+     *               They are copied into the arena.
+     * @return Eigen::MatrixXd The output value
+     */
+    Eigen::MatrixXd forward(const std::vector<Eigen::MatrixXd>& inputs);
+
+    /**
+     * @brief Runs the tape backward from the gradient of the loss w.r.t. the
+     * output. Afterwards every layer on the tape holds its gradients.
+     *
+     * @param dLdY The gradient of the loss with respect to the output
+     */
+    void backward(const Eigen::MatrixXd& dLdY);
+
+    /**
+     * @brief Runs the tape backward from the last loss computed by loss.
+     */
+    void backward(LossFunction& loss);
+
+    /**
+     * @brief Size of the arena chosen by the memory planner for the last
+     * batch size, in bytes.
+     */
+    size_t planned_bytes() const { return arena_.size() * sizeof(double); }
+
+    /**
+     * @brief Bytes the same values and gradients would take if each had its
+     * own buffer, as they do when every value is kept until the end of the
+     * backward pass.
+     */
+    size_t unplanned_bytes() const { return unplanned_bytes_; }
+
+    /**
+     * @brief Bytes of forward state held outside the arena between forward
+     * and backward, by layers and activations that do not keep views. Zero
+     * for graphs of Linear layers and elementwise activations.
+     */
+    size_t cache_bytes() const;
+
+private:
+    enum class OpType { Input, Layer, Activation, Add, Concat };
+
+    struct Node {
+        OpType op;
+        std::vector<Value> inputs;
+        size_t cols = 0;
+        size_t input_index = 0;  // Position in the inputs passed to forward
+        ::Layer* layer = nullptr;
+        ActivationFunction* activation = nullptr;
+        ::Layer::Cache layer_cache;  // Forward state of this use of the layer
+        ActivationFunction::Cache activation_cache;  // Forward state of this use of the activation
+    };
+
+    // A buffer in the arena, alive from tape step first to step last inclusive.
+    // Steps 0 .. T-1 are the forward pass, steps T .. 2T-1 the backward pass.
+    struct Buffer {
+        size_t first = 0;
+        size_t last = 0;
+        size_t size = 0;
+        size_t offset = 0;
+    };
+
+    std::vector<Node> nodes_;
+    Value output_ = 0;
+    bool has_output_ = false;
+    size_t planned_rows_ = 0;
+    size_t unplanned_bytes_ = 0;
+    std::vector<double> arena_;
+    std::vector<Buffer> values_;     // Forward value of every node
+    std::vector<Buffer> gradients_;  // Gradient w.r.t. every node's value
+    size_t num_inputs_ = 0;
+
+    Value push(Node node);
+    void plan(size_t rows);
+    void accumulate(Value v, const Eigen::MatrixXd& gradient, std::vector<bool>& ready);
+    Eigen::Map<Eigen::MatrixXd> value(Value v);
+    Eigen::Map<Eigen::MatrixXd> gradient(Value v);
+    Eigen::Map<const Eigen::MatrixXd> view(Value v) const;
+};
+
+#endif // GRAPH_H
@@ -0,0 +1,83 @@
+/**
+ * @file half.h
+ * @author Krish Suraparaju (csurapar@andrew.cmu.edu)
+ * @brief 16-bit floating point storage for weights and activations.
+ *
+ * Two 16-bit formats are supported:
+ * 1. bfloat16 - The upper half of an IEEE float: 8 exponent bits and 7
+ *               mantissa bits. Same range as float, about 3 significant digits.
+ * 2. float16  - IEEE half precision: 5 exponent bits and 10 mantissa bits.
+ *               About 4 significant digits, but values above 65504 overflow.
+ *
+ * Storing weights in 16 bits halves the memory traffic of a matrix-vector
+ * product, which is what bounds a batch-1 forward pass. The values are only
+ * ever widened to float inside the kernel, and all sums are accumulated in
+ * float. The kernel is picked at runtime: AVX-512, AVX2 with F16C and FMA, or
+ * a portable scalar fallback.
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef HALF_H
+#define HALF_H
+
+#include <cstddef>
+#include <cstdint>
+
+enum class HalfFormat {
+    BFloat16,
+    Float16
+};
+
+enum class HalfIsa {
+    Portable,  // Scalar conversion, works everywhere
+    AVX2,      // AVX2 + FMA + F16C, 8 floats per instruction
+    AVX512     // AVX-512F, 16 floats per instruction
+};
+
+/**
+ * @brief Rounds a float to the nearest 16-bit value (ties to even).
+ *
+ * @param x The value to convert
+ * @param format The 16-bit format to convert to
+ * @return uint16_t The bit pattern of the 16-bit value
+ */
+uint16_t float_to_half(float x, HalfFormat format);
+
+/**
+ * @brief Widens a 16-bit value to float. This conversion is exact.
+ *
+ * @param h The bit pattern of the 16-bit value
+ * @param format The 16-bit format of h
+ * @return float The widened value
+ */
+float half_to_float(uint16_t h, HalfFormat format);
+
+/**
+ * @brief The fastest kernel the current CPU supports.
+ */
+HalfIsa detect_half_isa();
+
+/**
+ * @brief Computes Z = A * W^T + ι_N * b^T, where W is stored in a 16-bit format
+ * and everything else is float. All matrices are row-major.
+ *
+ * @param A The N x K input
+ * @param W The M x K weights in the given 16-bit format
+ * @param b The M biases, or nullptr for none
+ * @param Z The N x M output
+ * @param N The number of samples
+ * @param K The input size
+ * @param M The output size
+ * @param format The 16-bit format of W
+ * @param isa The kernel to use, must be supported by the CPU
+ */
+void half_gemm(const float* A, const uint16_t* W, const float* b, float* Z,
+               size_t N, size_t K, size_t M, HalfFormat format,
+               HalfIsa isa = detect_half_isa());
+
+#endif // HALF_H
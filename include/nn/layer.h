@@ -12,6 +12,16 @@
  * Currently, the following layers are implemented:
  * 1. Linear Layer - Applies a linear transformation to the incoming data.
  *                   The output is computed as Z = A * W^T + ι_N * b.
+ * 2. Embedding Layer - Looks up a learned vector for every categorical index
+ *                      in the input. Equivalent to a bias-free Linear layer
+ *                      applied to one-hot inputs, without building them.
+ * 3. SparseLinear Layer - An inference representation of a pruned Linear
+ *                         layer, storing only the non-zero weights in CSR.
+ * 4. HalfLinear Layer - A Linear layer whose weights are stored in bfloat16 or
+ *                       float16, and widened to float inside the GEMM kernel.
+ * 5. StackedLinear Layer - K same-shaped Linear layers of K independent models
+ *                          (an ensemble or a hyperparameter sweep), stored in
+ *                          one matrix and run as batched GEMMs.
  *
  * @version 0.1
  * @date 2024-05-01
@@ -21,6 +31,11 @@
  */
 
 #include <Eigen/Dense>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+#include "half.h"
 
 #ifndef LAYER_H
 #define LAYER_H
@@ -29,6 +44,8 @@ public:
     Eigen::MatrixXd W_;  // Weights
     Eigen::MatrixXd b_;  // Biases
     Eigen::MatrixXd A_;  // Activated output from previous layer
+    const double* A_view_ = nullptr;  // Input kept by forward_view instead of A_, owned by the caller
+    Eigen::Index A_view_cols_ = 0;  // Columns of A_view_ (its rows are N_)
     Eigen::MatrixXd dLdW_; // Gradient of loss w.r.t. weights
     Eigen::MatrixXd dLdb_; // Gradient of loss w.r.t. biases
     size_t N_;  // Number of samples
@@ -55,6 +72,88 @@ public:
      */
     virtual ~Layer() {}
 
+    /**
+     * @brief The state a forward pass leaves behind for the matching backward
+     * pass. Schedules that run several forward passes through a layer before
+     * the backward passes (pipelining, graphs with shared layers) park it here
+     * between the two, and swapping with an empty Cache releases it.
+     */
+    struct Cache {
+        Eigen::MatrixXd A;
+        size_t N = 0;
+        std::vector<uint16_t> A_half;  // Only used by HalfLinear
+        std::vector<Eigen::MatrixXd> state;  // Any other state, e.g. of MultiHeadAttention
+        const double* A_view = nullptr;  // Set instead of A after forward_view
+        Eigen::Index A_view_cols = 0;
+    };
+
+    /**
+     * @brief Exchanges the forward state of the layer with the given cache.
+     *
+     * @param cache The cache to swap with
+     */
+    virtual void swap_cache(Cache& cache) {
+        this->A_.swap(cache.A);
+        std::swap(this->N_, cache.N);
+        std::swap(this->A_view_, cache.A_view);
+        std::swap(this->A_view_cols_, cache.A_view_cols);
+    }
+
+    /**
+     * @brief The input cached by the last forward pass: a view of A_, or of
+     * the caller's buffer after forward_view.
+     *
+     * @return Eigen::Map<const Eigen::MatrixXd> The cached input
+     */
+    Eigen::Map<const Eigen::MatrixXd> cached_input() const {
+        if (this->A_view_ != nullptr) {
+            return Eigen::Map<const Eigen::MatrixXd>(this->A_view_, this->N_, this->A_view_cols_);
+        }
+        return Eigen::Map<const Eigen::MatrixXd>(this->A_.data(), this->A_.rows(), this->A_.cols());
+    }
+
+    /**
+     * @brief Bytes held for the backward pass. Only owned memory counts, not
+     * the view kept by forward_view.
+     *
+     * @return size_t The number of bytes
+     */
+    virtual size_t cache_bytes() const { return this->A_.size() * sizeof(double); }
+
+    /**
+     * @brief The out_size x in_size weights as a dense matrix, converted from
+     * the layer's own storage for layers that do not keep them in W_
+     * (HalfLinear, SparseLinear).
+     *
+     * @return Eigen::MatrixXd The weights
+     */
+    virtual Eigen::MatrixXd weights() const { return this->W_; }
+
+    /**
+     * @brief Replaces the weights, converting them to the layer's own storage.
+     *
+     * @param W The out_size x in_size weights
+     */
+    virtual void set_weights(const Eigen::MatrixXd& W) { this->W_ = W; }
+
+    /**
+     * @brief Layers built out of other layers (e.g. the projections of
+     * MultiHeadAttention) return them here, so that optimizers and gradient
+     * reductions reach their parameters.
+     *
+     * @return std::vector<Layer*> The sublayers, empty for plain layers
+     */
+    virtual std::vector<Layer*> children() { return {}; }
+
+    /**
+     * @brief A copy of the layer, parameters and all, e.g. to publish a
+     * snapshot of a model that keeps training. Only needed for snapshots
+     * (ModelSnapshot, OnlineTrainer): the default throws std::runtime_error.
+     *
+     * @return std::unique_ptr<Layer> The copy
+     */
+    virtual std::unique_ptr<Layer> clone() const;
+
     /**
      * @brief Fowrard pass through the layer, specific to each layer type
      *
@@ -63,6 +162,37 @@ public:
      */
     virtual Eigen::MatrixXd forward(const Eigen::MatrixXd& A) = 0;
 
+    /**
+     * @brief Inference-only forward pass: same output as forward, but nothing
+     * is cached for backward and the layer is not modified, so several threads
+     * can run predict on the same layer at once. The default runs forward and
+     * then restores the cache (see swap_cache), one call at a time; layers
+     * override it to run concurrently without touching their state.
+     *
+     * @param A The input to the layer
+     * @return Eigen::MatrixXd The output of the layer
+     */
+    virtual Eigen::MatrixXd predict(const Eigen::MatrixXd& A) const;
+
+    /**
+     * @brief Same as forward, but reads A in place and, if keeps_view(), only
+     * keeps a view of it for backward instead of copying it into A_. The
+     * caller must then leave A unchanged until the matching backward; Graph
+     * does so to keep the saved inputs in its planned arena. By default the
+     * input is copied and passed to forward.
+     *
+     * @param A The input to the layer
+     * @return Eigen::MatrixXd The output of the layer
+     */
+    virtual Eigen::MatrixXd forward_view(Eigen::Map<const Eigen::MatrixXd> A) {
+        return this->forward(Eigen::MatrixXd(A));
+    }
+
+    /**
+     * @brief Whether forward_view keeps a view of its input for backward.
+     */
+    virtual bool keeps_view() const { return false; }
+
     /**
      * @brief Backward pass through the layer, specific to each layer type
      *
@@ -86,6 +216,10 @@ public:
      * @return Eigen::MatrixXd The output of the layer
     */
     Eigen::MatrixXd forward(const Eigen::MatrixXd& A) override;
+    Eigen::MatrixXd predict(const Eigen::MatrixXd& A) const override;
+    Eigen::MatrixXd forward_view(Eigen::Map<const Eigen::MatrixXd> A) override;
+    bool keeps_view() const override { return true; }
+    std::unique_ptr<Layer> clone() const override { return std::make_unique<Linear>(*this); }
 
     /**
      * @brief During backward propagation, we compute the gradients of the loss with
@@ -101,4 +235,266 @@ public:
     Eigen::MatrixXd backward(const Eigen::MatrixXd& dLdZ) override;
 };
 
+class Embedding : public Layer {
+public:
+    /**
+     * @brief The gradient of an Embedding layer only touches the entries that
+     * were looked up in the last forward pass, so instead of a dense dLdW_ the
+     * size of the whole table, backward produces a sparse gradient:
+     * sparse_indices_[s] is a table index and sparse_values_.col(s) is the
+     * gradient of the loss w.r.t. that entry. Indices are unique and sorted;
+     * repeated lookups of the same index are summed together.
+     */
+    std::vector<Eigen::Index> sparse_indices_;
+    Eigen::MatrixXd sparse_values_;
+
+    /**
+     * @brief Construct a new Embedding object. The table is stored in W_ with
+     * the same shape as the equivalent Linear layer (embedding_dim x num_embeddings),
+     * so that the vector of entry i is the column W_.col(i), which is contiguous
+     * in Eigen's column-major storage. Embeddings have no bias.
+     *
+     * @param num_embeddings The number of entries in the table
+     * @param embedding_dim The size of each embedding vector
+     */
+    Embedding(size_t num_embeddings, size_t embedding_dim)
+        : Layer(num_embeddings, embedding_dim) {
+        this->b_ = Eigen::MatrixXd(0, 0);
+    }
+
+    /**
+     * @brief During forward propagation, every entry of A is interpreted as an
+     * index into the table. For an input of N samples with F categorical fields
+     * each (N x F), the output is the N x (F * embedding_dim) matrix formed by
+     * concatenating the F looked up vectors of each sample. The indices are
+     * cached in A_ for the backward pass. Throws std::out_of_range if an index
+     * is negative, NaN or not below num_embeddings (forward, forward_view and
+     * predict alike).
+     *
+     * @param A The N x F matrix of indices
+     * @return Eigen::MatrixXd The N x (F * embedding_dim) embedded output
+     */
+    Eigen::MatrixXd forward(const Eigen::MatrixXd& A) override;
+    Eigen::MatrixXd predict(const Eigen::MatrixXd& A) const override;
+    Eigen::MatrixXd forward_view(Eigen::Map<const Eigen::MatrixXd> A) override;
+    bool keeps_view() const override { return true; }
+    std::unique_ptr<Layer> clone() const override { return std::make_unique<Embedding>(*this); }
+
+    /**
+     * @brief During backward propagation, the rows of ∂L/∂Z belonging to the
+     * same index are summed into sparse_indices_ / sparse_values_. The indices
+     * themselves are not differentiable, so the returned ∂L/∂A is zero.
+     *
+     * @param dLdZ The N x (F * embedding_dim) gradient of the loss w.r.t. the output
+     * @return Eigen::MatrixXd A N x F matrix of zeros
+     */
+    Eigen::MatrixXd backward(const Eigen::MatrixXd& dLdZ) override;
+};
+
+class SparseLinear : public Layer {
+public:
+    /**
+     * @brief The weights in compressed sparse row (CSR) format. The non-zero
+     * weights of output row o are values_[k] at input column col_idx_[k], for
+     * k in [row_ptr_[o], row_ptr_[o + 1]). The dense W_ is released once the
+     * CSR copy is built.
+     */
+    std::vector<Eigen::Index> row_ptr_;
+    std::vector<Eigen::Index> col_idx_;
+    std::vector<double> values_;
+
+    /**
+     * @brief Construct a new SparseLinear object from a (pruned) Linear layer.
+     * Only the non-zero entries of linear.W_ are kept. The weights are frozen:
+     * backward propagates ∂L/∂A but does not compute ∂L/∂W or ∂L/∂b.
+     *
+     * @param linear The layer to compress
+     */
+    explicit SparseLinear(const Linear& linear);
+
+    /**
+     * @brief Computes Z = A * W^T + ι_N * b with the sparse weights. Every
+     * non-zero W(o, k) adds W(o, k) * A.col(k) to Z.col(o), which is a
+     * contiguous axpy over the batch in Eigen's column-major storage.
+     *
+     * @param A The input to the layer
+     * @return Eigen::MatrixXd The output of the layer
+     */
+    Eigen::MatrixXd forward(const Eigen::MatrixXd& A) override;
+    Eigen::MatrixXd predict(const Eigen::MatrixXd& A) const override;
+    Eigen::MatrixXd forward_view(Eigen::Map<const Eigen::MatrixXd> A) override;  // Keeps nothing
+    std::unique_ptr<Layer> clone() const override { return std::make_unique<SparseLinear>(*this); }
+
+    /**
+     * @brief Computes ∂L/∂A = ∂L/∂Z * W with the sparse weights.
+     *
+     * @param dLdZ The gradient of the loss with respect to the output
+     * @return Eigen::MatrixXd The gradient of the loss with respect to the input A
+     */
+    Eigen::MatrixXd backward(const Eigen::MatrixXd& dLdZ) override;
+
+    /**
+     * @brief Number of stored (non-zero) weights.
+     */
+    size_t nnz() const { return values_.size(); }
+
+    /**
+     * @brief Fraction of the weights that are zero.
+     */
+    double sparsity() const {
+        return 1.0 - static_cast<double>(nnz()) / static_cast<double>(in_size_ * out_size_);
+    }
+
+    /**
+     * @brief Rebuilds the dense weight matrix, mostly useful for testing.
+     *
+     * @return Eigen::MatrixXd The out_size x in_size dense weights
+     */
+    Eigen::MatrixXd dense() const;
+
+    Eigen::MatrixXd weights() const override { return this->dense(); }
+
+    /**
+     * @brief Rebuilds the CSR arrays from the non-zero entries of W.
+     *
+     * @param W The out_size x in_size weights
+     */
+    void set_weights(const Eigen::MatrixXd& W) override;
+};
+
+class HalfLinear : public Layer {
+public:
+    /**
+     * @brief The out_size x in_size weights, row-major, in a 16-bit format.
+     * The dense double W_ is released once they are built. The bias is small
+     * and stays in b_.
+     */
+    std::vector<uint16_t> W_half_;
+    HalfFormat format_;
+    bool half_activations_;  // If true, the input cached for backward is 16-bit too
+    std::vector<uint16_t> A_half_;  // Row-major 16-bit copy of the cached input
+
+    /**
+     * @brief Construct a new HalfLinear object from a trained Linear layer.
+     *
+     * @param linear The layer whose weights should be converted
+     * @param format The 16-bit format to store the weights in
+     * @param half_activations Whether to also cache the input in 16 bits
+     */
+    HalfLinear(const Linear& linear, HalfFormat format = HalfFormat::BFloat16,
+               bool half_activations = false);
+
+    /**
+     * @brief Computes Z = A * W^T + ι_N * b with the 16-bit weights. The input
+     * is rounded to float, and every dot product is accumulated in float.
+     *
+     * @param A The input to the layer
+     * @return Eigen::MatrixXd The output of the layer
+     */
+    Eigen::MatrixXd forward(const Eigen::MatrixXd& A) override;
+    Eigen::MatrixXd predict(const Eigen::MatrixXd& A) const override;
+    Eigen::MatrixXd forward_view(Eigen::Map<const Eigen::MatrixXd> A) override;
+    bool keeps_view() const override { return !this->half_activations_; }
+    std::unique_ptr<Layer> clone() const override { return std::make_unique<HalfLinear>(*this); }
+
+    /**
+     * @brief Same gradients as Linear::backward, computed from the widened
+     * weights and the (possibly 16-bit) cached input.
+     *
+     * @param dLdZ The gradient of the loss with respect to the output
+     * @return Eigen::MatrixXd The gradient of the loss with respect to the input A
+     */
+    Eigen::MatrixXd backward(const Eigen::MatrixXd& dLdZ) override;
+
+    /**
+     * @brief Widens the weights back to a double matrix.
+     *
+     * @return Eigen::MatrixXd The out_size x in_size weights
+     */
+    Eigen::MatrixXd dense() const;
+
+    Eigen::MatrixXd weights() const override { return this->dense(); }
+
+    /**
+     * @brief Rounds the given weights into the 16-bit storage.
+     *
+     * @param W The out_size x in_size weights
+     */
+    void set_weights(const Eigen::MatrixXd& W) override;
+
+    void swap_cache(Cache& cache) override {
+        Layer::swap_cache(cache);
+        this->A_half_.swap(cache.A_half);
+    }
+
+    size_t cache_bytes() const override {
+        return Layer::cache_bytes() + this->A_half_.size() * sizeof(uint16_t);
+    }
+};
+
+class StackedLinear : public Layer {
+public:
+    size_t num_models_;  // K
+
+    /**
+     * @brief Construct a new StackedLinear object holding K Linear layers of
+     * the same shape. The weights of model k are the rows
+     * k * output_size .. (k + 1) * output_size - 1 of W_ (K * output_size x
+     * input_size), and its bias the same rows of b_, so the layer of one model
+     * is a block of W_ and stacking needs no extra copies.
+     *
+     * @param num_models The number of models K
+     * @param input_size The input size of every model
+     * @param output_size The output size of every model
+     */
+    StackedLinear(size_t num_models, size_t input_size, size_t output_size)
+        : Layer(input_size, output_size), num_models_(num_models) {
+        this->W_ = Eigen::MatrixXd::Random(num_models * output_size, input_size);
+        this->b_ = Eigen::MatrixXd::Random(num_models * output_size, 1);
+    }
+
+    /**
+     * @brief Applies the Linear layer of every model to its input. The input is
+     * either N x in, shared by all models (e.g. the first layer of a sweep over
+     * the same data), or N x (K * in) with the columns of model k in block k.
+     * The output is always N x (K * out), block k holding Z_k = A_k * W_k^T + b_k.
+     * A shared input is one GEMM against all of W_; otherwise the K GEMMs run
+     * in parallel on the thread pool.
+     *
+     * @param A The N x in or N x (K * in) input
+     * @return Eigen::MatrixXd The N x (K * out) output
+     */
+    Eigen::MatrixXd forward(const Eigen::MatrixXd& A) override;
+    Eigen::MatrixXd predict(const Eigen::MatrixXd& A) const override;
+    Eigen::MatrixXd forward_view(Eigen::Map<const Eigen::MatrixXd> A) override;
+    bool keeps_view() const override { return true; }
+    std::unique_ptr<Layer> clone() const override { return std::make_unique<StackedLinear>(*this); }
+
+    /**
+     * @brief Computes the gradients of every model, stacked like W_ and b_.
+     * For a shared input, the returned ∂L/∂A is the sum over the models.
+     *
+     * @param dLdZ The N x (K * out) gradient of the loss with respect to the output
+     * @return Eigen::MatrixXd The gradient of the loss with respect to the input A
+     */
+    Eigen::MatrixXd backward(const Eigen::MatrixXd& dLdZ) override;
+
+    /**
+     * @brief Copies the layer of model k out into a standalone Linear layer,
+     * e.g. to keep the best model of a sweep.
+     *
+     * @param k The model
+     * @return std::unique_ptr<Linear> Its layer
+     */
+    std::unique_ptr<Linear> unstack(size_t k) const;
+
+    /**
+     * @brief Overwrites the layer of model k with the given Linear layer.
+     *
+     * @param k The model
+     * @param linear A layer of the same shape
+     */
+    void stack(size_t k, const Linear& linear);
+};
+
 #endif // LAYER_H
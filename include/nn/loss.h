@@ -16,6 +16,9 @@
 #define LOSS_H
 
 #include <Eigen/Dense>
+#include <functional>
+#include <memory>
+#include <vector>
 
 // Base LossFunction class
 class LossFunction {
@@ -83,17 +86,44 @@ public:
      * @param A
      * @return Eigen::MatrixXd
      */
-    Eigen::MatrixXd softmax(const Eigen::MatrixXd& A) {
-        Eigen::MatrixXd softmax = Eigen::MatrixXd::Zero(A.rows(), A.cols());
-        for (int i = 0; i < A.rows(); i++) {
-            double max = A.row(i).maxCoeff();
-            Eigen::VectorXd exps = (A.row(i).array() - max).exp();
-            softmax.row(i) = exps / exps.sum();
-        }
-        return softmax;
-    };
+    Eigen::MatrixXd softmax(const Eigen::MatrixXd& A);
     double forward(const Eigen::MatrixXd& A, const Eigen::MatrixXd& Y) override;
     Eigen::MatrixXd backward() override;
 };
 
+/**
+ * @brief The losses of K stacked models (see StackedLinear). Every model has its
+ * own loss object, applied to its block of the N x (K * C) prediction, and its
+ * own loss value in losses_.
+ */
+class StackedLoss : public LossFunction {
+public:
+    std::vector<std::unique_ptr<LossFunction>> loss_fns_;  // One per model
+    std::vector<double> losses_;  // Loss of every model in the last forward pass
+
+    /**
+     * @brief Construct a new StackedLoss object.
+     *
+     * @param num_models The number of models K
+     * @param make_loss Creates the loss function of one model
+     */
+    StackedLoss(size_t num_models, const std::function<std::unique_ptr<LossFunction>()>& make_loss);
+
+    /**
+     * @brief Computes the loss of every model into losses_.
+     *
+     * @param A The N x (K * C) predictions, block k belonging to model k
+     * @param Y The N x C targets shared by all models, or N x (K * C) stacked like A
+     * @return double The mean of the losses of the models
+     */
+    double forward(const Eigen::MatrixXd& A, const Eigen::MatrixXd& Y) override;
+
+    /**
+     * @brief The derivative of every model's loss with respect to its own
+     * block of predictions, stacked like A. The models do not interact, so
+     * this is not scaled by 1 / K.
+     */
+    Eigen::MatrixXd backward() override;
+};
+
 #endif  // LOSS_H
\ No newline at end of file
@@ -25,6 +25,8 @@
 #define MODEL_H
 
 #include <Eigen/Dense>
+#include <functional>
+#include <memory>
 #include <utility>
 #include <vector>
 #include "layer.h"
@@ -52,6 +54,23 @@ public:
     std::vector<std::unique_ptr<ActivationFunction>>& activations_;
     std::unique_ptr<LossFunction>& loss_;
 
+    /**
+     * @brief Gradient checkpointing. Normally every layer and activation keeps
+     *        its input (A_) from forward until backward, so memory grows with
+     *        depth. With checkpoints, the layers are split into segments and
+     *        only the input of each segment is kept; the caches inside a segment
+     *        are released after its forward pass and rebuilt by running the
+     *        segment forward again just before its backward pass. With about
+     *        sqrt(L) segments of sqrt(L) layers, the cached memory drops from
+     *        O(L) to O(sqrt(L)) activations, for one extra forward pass.
+     *
+     *        checkpoints_ holds the first layer of every segment after the
+     *        first one (the first segment always starts at layer 0).
+     */
+    std::vector<size_t> checkpoints_;
+    std::vector<Eigen::MatrixXd> segment_inputs_;  // Input of every segment but the last
+    size_t peak_cache_bytes_ = 0;  // Largest cache_bytes() seen in the last forward/backward
+
     /**
      * @brief Construct a new Model object. Take in a vector of
      *       layers, a loss function, and a vector of activation
@@ -74,6 +93,17 @@ public:
      */
     Eigen::MatrixXd forward(const Eigen::MatrixXd& X);
 
+    /**
+     * @brief Inference-only forward pass. Returns the same output as forward,
+     *        but no layer or activation caches anything for backward, so
+     *        memory does not grow with depth and several threads can call
+     *        predict on the same model at once (e.g. during evaluation).
+     *
+     * @param X The input data
+     * @return Eigen::MatrixXd The output of the model
+     */
+    Eigen::MatrixXd predict(const Eigen::MatrixXd& X) const;
+
     /**
      * @brief During backward propagation, we compute the gradients of the loss with
      *        respect to the parameters of the neural network. Given the gradients
@@ -88,11 +118,50 @@ public:
      */
     void backward();
 
+    /**
+     * @brief Same as backward(), but calls after_layer(i) as soon as the
+     *        gradients of layer i are ready, while the remaining layers are
+     *        still running backward. Used to overlap gradient communication
+     *        with the backward pass.
+     *
+     * @param after_layer Called once per layer, from the last layer to the first
+     */
+    void backward(const std::function<void(size_t)>& after_layer);
+
+    /**
+     * @brief Splits the layers into segments starting at the given layers.
+     *        An empty vector turns checkpointing off.
+     *
+     * @param checkpoints The first layer of every segment after the first
+     */
+    void set_checkpoints(const std::vector<size_t>& checkpoints);
+
+    /**
+     * @brief Splits the layers into about sqrt(L) segments of equal size.
+     */
+    void set_sqrt_checkpoints();
+
+    /**
+     * @brief Bytes currently held for the backward pass: the caches of every
+     *        layer (Layer::cache_bytes, e.g. the 16-bit inputs of HalfLinear)
+     *        and activation, plus the saved segment inputs.
+     *
+     * @return size_t The number of bytes
+     */
+    size_t cache_bytes() const;
+
 
     /**
      * @brief Destroy the Model object
      *
      */
     virtual ~Model() {}
+
+private:
+    Eigen::MatrixXd forward_segment(Eigen::MatrixXd A, size_t first, size_t last);
+    Eigen::MatrixXd backward_segment(Eigen::MatrixXd dLdA, size_t first, size_t last,
+                                     const std::function<void(size_t)>& after_layer);
+    void release_segment(size_t first, size_t last);
+    void update_peak();
 };
 #endif
\ No newline at end of file
@@ -0,0 +1,52 @@
+/**
+ * @file optimize.h
+ * @author Krish Suraparaju (csurapar@andrew.cmu.edu)
+ * @brief Rewrites a trained Model into a leaner model with the same outputs,
+ * for inference.
+ *
+ * The following rewrites are applied until none of them applies anymore:
+ * 1. Constant folding - A Scale activation after a Linear layer is folded into
+ *    its weights and bias: s * (A * W^T + b) = A * (sW)^T + sb.
+ * 2. Identity removal - Identity activations are dropped, and so are Linear
+ *    layers whose weights are the identity matrix and whose bias is zero.
+ * 3. Linear fusion - Two Linear layers with nothing in between compute
+ *    (A * W1^T + b1) * W2^T + b2 = A * (W2 W1)^T + (W2 b1 + b2), so they are
+ *    merged into one layer with W = W2 W1 and b = W2 b1 + b2, when that takes
+ *    fewer FLOPs than applying them one after the other (in * out2 versus
+ *    in * mid + mid * out2 multiply-adds per sample).
+ *
+ * Since activations_[i] always follows layers_[i], a layer that is left
+ * without an activation in the middle of the model gets an Identity
+ * placeholder when the model is rebuilt.
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef OPTIMIZE_H
+#define OPTIMIZE_H
+
+#include <cstddef>
+#include "model.h"
+
+struct OptimizeStats {
+    size_t folded_scales = 0;
+    size_t removed_identities = 0;
+    size_t fused_linears = 0;
+};
+
+/**
+ * @brief Rewrites the layers and activations of the model in place. The
+ * outputs of Model::forward are unchanged, up to floating point rounding.
+ * The rewritten model is meant for inference: fused layers no longer have
+ * the gradients of the original ones.
+ *
+ * @param model The model to optimize
+ * @return OptimizeStats The number of rewrites of every kind
+ */
+OptimizeStats optimize_for_inference(Model& model);
+
+#endif // OPTIMIZE_H
@@ -0,0 +1,150 @@
+/**
+ * @file pipeline.h
+ * @author Krish Suraparaju (csurapar@andrew.cmu.edu)
+ * @brief Pipeline-parallel execution of a Model across several cores.
+ *
+ * The layers of the model are split into contiguous stages of roughly equal
+ * parameter count, and every stage is run by its own thread, pinned to its own
+ * core, so that each core keeps only its own weights in cache. The cores are
+ * taken from the ones the process may run on (its affinity mask), avoiding
+ * those the workers of the global thread pool are pinned to, and a pinned
+ * stage runs its kernels on its own thread instead of through parallel_for
+ * (see SerialScope). Without pinning, the stages share the global pool. The mini-batch
+ * is split into micro-batches that flow from stage to stage through lock-free
+ * single-producer single-consumer queues: while stage s works on micro-batch
+ * m, stage s - 1 can already work on micro-batch m + 1.
+ *
+ * Two schedules are supported for training:
+ * 1. GPipe - Every stage runs the forward passes of all micro-batches, then
+ *            all the backward passes. Simple, but every stage holds the cached
+ *            activations of all micro-batches at once.
+ * 2. 1F1B  - After a short warm-up, every stage alternates one forward and one
+ *            backward pass, so stage s holds at most (stages - s) micro-batches
+ *            worth of activations.
+ *
+ * The gradients of the micro-batches are summed in every layer, so after
+ * train_step the dLdW_ and dLdb_ of each layer equal the ones Model::backward
+ * computes for the whole mini-batch. Layers with sparse gradients (Embedding)
+ * are not supported, since their gradient is not accumulated.
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <Eigen/Dense>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "model.h"
+#include "../utils/spsc_queue.h"
+
+enum class PipelineSchedule {
+    GPipe,
+    OneFOneB
+};
+
+class PipelineModel {
+public:
+    Model& model_;
+    size_t num_micro_batches_;
+    PipelineSchedule schedule_;
+    std::vector<std::pair<size_t, size_t>> stages_;  // [first, last) layer of every stage
+
+    /**
+     * @brief Construct a new PipelineModel object and start one thread per stage.
+     *
+     * @param model The model to run. Must outlive the pipeline.
+     * @param num_stages The number of stages (capped at the number of layers)
+     * @param num_micro_batches The number of micro-batches a mini-batch is split into
+     * @param schedule The schedule for the backward passes
+     * @param pin_threads Whether to pin every stage to its own core and run its
+     *                    kernels on that core alone
+     */
+    PipelineModel(Model& model, size_t num_stages, size_t num_micro_batches,
+                  PipelineSchedule schedule = PipelineSchedule::OneFOneB,
+                  bool pin_threads = true);
+
+    /**
+     * @brief Stops and joins the stage threads.
+     */
+    ~PipelineModel();
+
+    PipelineModel(const PipelineModel&) = delete;
+    PipelineModel& operator=(const PipelineModel&) = delete;
+
+    /**
+     * @brief Pipelined equivalent of Model::forward.
+     *
+     * @param X The input data
+     * @return Eigen::MatrixXd The output of the model
+     */
+    Eigen::MatrixXd forward(const Eigen::MatrixXd& X);
+
+    /**
+     * @brief Runs the forward pass, the loss and the backward pass of one
+     * mini-batch. Afterwards every layer holds the gradients of the whole
+     * mini-batch, ready for an optimizer step.
+     *
+     * @param X The input data
+     * @param Y The expected output
+     * @return double The loss of the mini-batch
+     */
+    double train_step(const Eigen::MatrixXd& X, const Eigen::MatrixXd& Y);
+
+private:
+    struct Message {
+        size_t micro_batch = 0;
+        Eigen::MatrixXd data;
+    };
+
+    // Forward and backward passes of the micro-batches, in the order a stage runs them
+    struct Op {
+        bool forward;
+        size_t micro_batch;
+    };
+
+    struct Stage {
+        std::thread thread;
+        std::unique_ptr<SpscQueue<Message>> activations_in;  // From the previous stage
+        std::unique_ptr<SpscQueue<Message>> gradients_in;    // From the next stage
+        std::vector<std::vector<Layer::Cache>> layer_stash;   // [micro-batch][layer]
+        std::vector<std::vector<ActivationFunction::Cache>> activation_stash;
+        std::vector<Eigen::MatrixXd> dLdW;  // Gradients summed over the micro-batches
+        std::vector<Eigen::MatrixXd> dLdb;
+    };
+
+    std::vector<Stage> workers_;
+
+    // The job shared with the stage threads
+    std::mutex mutex_;
+    std::condition_variable start_cv_;
+    std::condition_variable done_cv_;
+    size_t generation_ = 0;
+    size_t finished_ = 0;
+    bool stop_ = false;
+    bool training_ = false;
+    const Eigen::MatrixXd* X_ = nullptr;
+    const Eigen::MatrixXd* Y_ = nullptr;
+    std::vector<size_t> offsets_;  // First row of every micro-batch, plus the end
+    Eigen::MatrixXd output_;
+    std::vector<double> losses_;
+    std::vector<Eigen::MatrixXd> loss_gradients_;
+
+    void run(bool training, const Eigen::MatrixXd& X, const Eigen::MatrixXd* Y);
+    void worker(size_t s, int cpu);
+    void run_stage(size_t s);
+    void stage_forward(size_t s, size_t m);
+    void stage_backward(size_t s, size_t m, bool first);
+    std::vector<Op> schedule(size_t s) const;
+};
+
+#endif // PIPELINE_H
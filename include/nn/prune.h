@@ -0,0 +1,48 @@
+/**
+ * @file prune.h
+ * @author Krish Suraparaju (csurapar@andrew.cmu.edu)
+ * @brief Magnitude pruning for the Linear layers of a trained model.
+ *
+ * Many trained networks keep most of their accuracy when the weights with the
+ * smallest absolute value are set to zero. Pruning removes a target fraction
+ * (the sparsity) of the weights, either with one threshold shared by all the
+ * selected layers (global) or with a separate threshold per layer. The pruned
+ * layers are then replaced by SparseLinear layers, which store only the
+ * remaining weights and are picked up transparently by Model::forward.
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef PRUNE_H
+#define PRUNE_H
+
+#include <vector>
+#include "model.h"
+
+enum class PruneScope {
+    Global,    // One magnitude threshold across all selected layers
+    PerLayer   // Every selected layer reaches the target sparsity on its own
+};
+
+/**
+ * @brief Zeroes the weights with the smallest magnitude in the selected Linear
+ * layers of the model, and optionally converts them into SparseLinear layers.
+ * Layers that are not Linear are skipped. Biases are never pruned.
+ *
+ * @param model The model to prune
+ * @param layer_indices Indices into model.layers_ of the layers to prune;
+ * repeated indices are ignored
+ * @param sparsity The fraction of weights to remove, in [0, 1]
+ * @param scope Whether the threshold is shared by all layers or per layer
+ * @param to_sparse If true, the pruned layers are replaced by SparseLinear
+ * @return size_t The number of weights that were pruned
+ */
+size_t magnitude_prune(Model& model, const std::vector<size_t>& layer_indices,
+                       double sparsity, PruneScope scope = PruneScope::Global,
+                       bool to_sparse = true);
+
+#endif // PRUNE_H
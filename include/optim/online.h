@@ -0,0 +1,173 @@
+/**
+ * @file online.h
+ * @author Krish Suraparaju (csurapar@andrew.cmu.edu)
+ * @brief Online training from a stream of samples, in bounded memory.
+ *
+ * Producers push samples as they arrive. They are stored in a ring buffer of
+ * fixed capacity, allocated once, and a dedicated training thread takes them
+ * out in FIFO order, batch_size at a time, into fixed batch matrices and runs
+ * forward, loss, backward and an SGD step on them. When the ring is full,
+ * producers either wait for the trainer (no sample is lost) or overwrite the
+ * oldest samples (the trainer always sees the most recent data).
+ *
+ * Every publish_every steps the trainer copies the layers into an immutable
+ * ModelSnapshot and publishes it by swapping an atomic shared_ptr. Readers
+ * load the pointer and predict on the snapshot they got, without ever waiting
+ * for a training step; a snapshot is freed once the last reader drops it, so
+ * old versions stay valid for as long as someone is using them (as in RCU).
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef ONLINE_H
+#define ONLINE_H
+
+#include <Eigen/Dense>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "../nn/model.h"
+#include "sgd.h"
+
+/**
+ * @brief The layers and activation functions of a model at one point of
+ * training. The snapshot owns copies of both, so it stays valid after the
+ * model is changed or destroyed.
+ */
+class ModelSnapshot {
+public:
+    std::vector<std::unique_ptr<Layer>> layers_;
+    std::vector<std::unique_ptr<ActivationFunction>> activations_;
+    size_t step_;  // Number of training steps taken before the snapshot
+
+    /**
+     * @brief Copies every layer and activation function of the model. The
+     * caches and gradients of the copies are released. Throws
+     * std::runtime_error if a layer or activation does not implement clone.
+     *
+     * @param model The model to copy
+     * @param step The current training step
+     */
+    ModelSnapshot(const Model& model, size_t step);
+
+    /**
+     * @brief Same as Model::predict, with the parameters of the snapshot. Any
+     * number of threads can call it at once.
+     *
+     * @param X The input data
+     * @return Eigen::MatrixXd The output of the model
+     */
+    Eigen::MatrixXd predict(const Eigen::MatrixXd& X) const;
+};
+
+class OnlineTrainer {
+public:
+    Model& model_;
+    SGD& sgd_;
+    size_t batch_size_;
+    size_t publish_every_;  // Training steps between two snapshots
+    bool drop_oldest_;      // When full: overwrite the oldest samples instead of waiting
+
+    /**
+     * @brief Construct a new OnlineTrainer object and allocate its buffers.
+     * Does not start training, call start.
+     *
+     * @param model The model to train
+     * @param sgd The optimizer over the layers of the model
+     * @param input_size The number of columns of an input sample
+     * @param target_size The number of columns of a target sample
+     * @param capacity The number of samples the ring buffer holds (at least batch_size)
+     * @param batch_size The number of samples per training step
+     * @param publish_every The number of training steps between two snapshots
+     * @param drop_oldest Whether producers overwrite the oldest samples when the
+     *                    ring is full, instead of waiting for room
+     */
+    OnlineTrainer(Model& model, SGD& sgd, size_t input_size, size_t target_size,
+                  size_t capacity, size_t batch_size, size_t publish_every = 1,
+                  bool drop_oldest = false);
+
+    /**
+     * @brief Stops the training thread if it is still running.
+     */
+    ~OnlineTrainer();
+
+    OnlineTrainer(const OnlineTrainer&) = delete;
+    OnlineTrainer& operator=(const OnlineTrainer&) = delete;
+
+    /**
+     * @brief Publishes a first snapshot and starts the training thread. The
+     * model must not be used by anyone else until stop returns.
+     */
+    void start();
+
+    /**
+     * @brief Rejects further samples, trains on the full batches still in
+     * the ring, publishes a last snapshot and joins the training thread. If a
+     * training step threw, the exception is rethrown here.
+     */
+    void stop();
+
+    /**
+     * @brief Adds samples, one per row, in order. Any number of producer
+     * threads can push at once.
+     *
+     * @param X The input samples
+     * @param Y Their targets, one row per sample
+     * @return true If the samples were queued, false if the trainer is stopping
+     */
+    bool push(const Eigen::MatrixXd& X, const Eigen::MatrixXd& Y);
+
+    /**
+     * @brief The last published snapshot, never null once start was called.
+     * Does not wait for training.
+     */
+    std::shared_ptr<const ModelSnapshot> snapshot() const;
+
+    /**
+     * @brief Number of training steps taken so far.
+     */
+    size_t steps() const { return steps_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Number of samples overwritten before they were trained on.
+     */
+    size_t dropped() const;
+
+    /**
+     * @brief The loss of the last training step.
+     */
+    double last_loss() const { return last_loss_.load(std::memory_order_relaxed); }
+
+private:
+    // The ring buffer: samples head_ .. head_ + size_ - 1 (mod capacity)
+    Eigen::MatrixXd X_ring_, Y_ring_;
+    size_t head_ = 0;
+    size_t size_ = 0;
+    size_t dropped_ = 0;
+    bool stopping_ = false;
+    mutable std::mutex mutex_;
+    std::condition_variable not_empty_;  // A full batch is available, or stopping
+    std::condition_variable not_full_;   // There is room in the ring, or stopping
+
+    // The batch trained on, filled from the ring without allocating
+    Eigen::MatrixXd X_batch_, Y_batch_;
+
+    std::shared_ptr<const ModelSnapshot> snapshot_;  // Only accessed atomically
+    std::atomic<size_t> steps_{0};
+    std::atomic<double> last_loss_{0.0};
+    std::thread thread_;
+    std::exception_ptr error_;
+
+    void train_loop();
+    void publish();
+};
+
+#endif // ONLINE_H
@@ -1,10 +1,97 @@
 /**
  * @file sgd.h
  * @author Krish Suraparaju
- * @brief TODO: Implement the SGD optimizer
+ * @brief Stochastic Gradient Descent (SGD) updates the parameters of every
+ * layer in the direction opposite to the gradient of the loss:
+ * W = W - lr * ∂L/∂W and b = b - lr * ∂L/∂b, where lr is the learning rate.
+ * The gradients are the ones computed by the last call to Model::backward.
+ *
+ * Layers that produce sparse gradients (Embedding) are updated in place on
+ * the touched entries only, so the cost of a step is proportional to the
+ * number of distinct indices in the batch rather than the size of the table.
+ * Layers with 16-bit weights (HalfLinear) are updated through float and
+ * rounded back to their storage format.
+ * Stacked layers (StackedLinear) hold K independent models, and every model
+ * can be given its own learning rate.
+ *
  * @version 0.1
  * @date 2024-05-12
  *
  * @copyright Copyright (c) 2024
  *
  */
+
+#ifndef SGD_H
+#define SGD_H
+
+#include <memory>
+#include <vector>
+#include "../nn/layer.h"
+
+class SGD {
+public:
+    std::vector<std::unique_ptr<Layer>>& layers_;
+    double lr_;  // Learning rate
+    std::vector<double> model_lrs_;  // Learning rate of every stacked model, empty for lr_
+
+    /**
+     * @brief Construct a new SGD optimizer over the given layers.
+     *
+     * @param layers The layers whose parameters should be updated
+     * @param lr The learning rate
+     */
+    SGD(std::vector<std::unique_ptr<Layer>>& layers, double lr)
+        : layers_(layers), lr_(lr) {}
+
+    /**
+     * @brief Construct a new SGD optimizer with one learning rate per stacked
+     * model: the blocks of model k of every StackedLinear layer are updated
+     * with lrs[k]. Other layers use lrs[0].
+     *
+     * @param layers The layers whose parameters should be updated
+     * @param lrs The learning rate of every model
+     */
+    SGD(std::vector<std::unique_ptr<Layer>>& layers, const std::vector<double>& lrs)
+        : layers_(layers), lr_(lrs.at(0)), model_lrs_(lrs) {}
+
+    /**
+     * @brief Apply one gradient descent update to every layer. Layers without
+     * gradients (e.g. not yet run through backward) are left untouched.
+     */
+    void step();
+
+    /**
+     * @brief Apply one gradient descent update to a single layer and to its
+     * sublayers, if it has any (see Layer::children).
+     *
+     * @param layer The layer to update
+     */
+    void step(Layer& layer);
+
+    /**
+     * @brief Apply the sparse gradient of an Embedding layer to the looked up
+     * entries only. The indices are unique, so entries are updated in parallel.
+     *
+     * @param embedding The layer to update
+     */
+    void step(Embedding& embedding);
+
+    /**
+     * @brief Apply the gradient to the 16-bit weights of a HalfLinear layer.
+     * The weights are widened, updated and rounded back, so updates much
+     * smaller than the weight itself can be lost to rounding.
+     *
+     * @param half The layer to update
+     */
+    void step(HalfLinear& half);
+
+    /**
+     * @brief Apply the gradient of every model of a StackedLinear layer with
+     * that model's learning rate. The models are updated in parallel.
+     *
+     * @param stacked The layer to update
+     */
+    void step(StackedLinear& stacked);
+};
+
+#endif // SGD_H
@@ -0,0 +1,116 @@
+/**
+ * @file gemm.h
+ * @author Krish Suraparaju (csurapar@andrew.cmu.edu)
+ * @brief The matrix multiplications of Linear go through this small GEMM
+ * interface, so the implementation can be swapped at runtime:
+ *
+ * - Eigen: Eigen's own GEMM (the default).
+ * - Cblas: an external BLAS (OpenBLAS, MKL, ...) through cblas_dgemm. Only
+ *   available when the library is configured with -DDNN_USE_CBLAS=ON.
+ * - Packed: an in-tree GEMM in the style of GotoBLAS/BLIS. Panels of op(A)
+ *   and op(B) are packed into contiguous buffers sized for the caches (KC x MC
+ *   for L2, KC x NC for L3), and an MR x NR register-blocked micro-kernel
+ *   computes each tile of C. The micro-kernel defaults to the fastest one the
+ *   CPU supports (AVX-512, AVX2 + FMA, or portable C++) and can be overridden
+ *   with set_gemm_kernel, e.g. to test every kernel or to tune across them.
+ *
+ * All matrices are column-major doubles, as in Eigen::MatrixXd.
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef GEMM_H
+#define GEMM_H
+
+#include <cstddef>
+
+enum class GemmBackend {
+    Eigen,
+    Cblas,
+    Packed
+};
+
+// The micro-kernels of the packed backend
+enum class GemmKernel {
+    Portable,  // 4 x 4 tile in plain C++, works everywhere
+    AVX2,      // 8 x 6 tile, AVX2 + FMA
+    AVX512     // 16 x 12 tile, AVX-512F
+};
+
+/**
+ * @brief The fastest micro-kernel the current CPU supports.
+ */
+GemmKernel detect_gemm_kernel();
+
+/**
+ * @brief Whether the micro-kernel was compiled in and the CPU supports it.
+ */
+bool gemm_kernel_supported(GemmKernel kernel);
+
+/**
+ * @brief Selects the micro-kernel used by the packed backend from now on, for
+ * all threads. Selecting a kernel the CPU does not support is an error.
+ */
+void set_gemm_kernel(GemmKernel kernel);
+
+/**
+ * @brief The micro-kernel currently used by the packed backend.
+ */
+GemmKernel gemm_kernel();
+
+/**
+ * @brief Human readable name of the micro-kernel, e.g. "packed-avx2".
+ */
+const char* gemm_kernel_name(GemmKernel kernel);
+
+/**
+ * @brief Selects the backend used by gemm from now on, for all threads.
+ * Selecting a backend that is not available is an error.
+ */
+void set_gemm_backend(GemmBackend backend);
+
+/**
+ * @brief The backend currently used by gemm.
+ */
+GemmBackend gemm_backend();
+
+/**
+ * @brief Whether the backend was compiled in.
+ */
+bool gemm_backend_available(GemmBackend backend);
+
+/**
+ * @brief Human readable name of the backend, e.g. "packed-avx512" for the
+ * packed backend with its current micro-kernel.
+ */
+const char* gemm_backend_name(GemmBackend backend);
+
+/**
+ * @brief Computes C = alpha * op(A) * op(B) + beta * C, where op(X) is X or
+ * X^T. op(A) is M x K, op(B) is K x N and C is M x N. When beta is 0, C does
+ * not need to be initialized.
+ *
+ * @param trans_a Whether op(A) = A^T
+ * @param trans_b Whether op(B) = B^T
+ * @param M The number of rows of C
+ * @param N The number of columns of C
+ * @param K The inner dimension
+ * @param alpha Scale of the product
+ * @param A The matrix A, with leading dimension lda
+ * @param lda The distance between two columns of A
+ * @param B The matrix B, with leading dimension ldb
+ * @param ldb The distance between two columns of B
+ * @param beta Scale of the previous contents of C
+ * @param C The output, with leading dimension ldc
+ * @param ldc The distance between two columns of C
+ * @param backend The implementation to use
+ */
+void gemm(bool trans_a, bool trans_b, size_t M, size_t N, size_t K,
+          double alpha, const double* A, size_t lda, const double* B, size_t ldb,
+          double beta, double* C, size_t ldc, GemmBackend backend = gemm_backend());
+
+#endif // GEMM_H
@@ -0,0 +1,174 @@
+/**
+ * @file npy.h
+ * @author Krish Suraparaju (csurapar@andrew.cmu.edu)
+ * @brief Reading and writing NumPy .npy and .npz files, so that weights and
+ * data can move between Python and this library without text dumps.
+ *
+ * A .npy file is a short text header (dtype, memory order and shape) padded
+ * to 64 bytes, followed by the raw array. Arrays of float32 ('<f4') or float64
+ * ('<f8') with one or two dimensions are supported, in C (row-major) or
+ * Fortran (column-major) order; a 1-D array of n values is read as an n x 1
+ * matrix. A .npz file is a zip archive of .npy files, one per named array, as
+ * written by np.savez. Only stored (uncompressed) archives are supported, not
+ * the deflated ones of np.savez_compressed.
+ *
+ * NpyMap memory-maps a .npy file and exposes the data as an Eigen::Map, so
+ * opening a file costs the same whatever its size and pages are only read
+ * from disk when they are touched. Eigen matrices are column-major doubles,
+ * so a Fortran-order float64 array maps directly onto a MatrixXd; any other
+ * array maps onto the matching Eigen type (e.g. a row-major float matrix) or
+ * is converted with a single copy by to_matrix. save_npy writes Fortran order
+ * for the same reason, so that the file can be mapped back without a copy.
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef NPY_H
+#define NPY_H
+
+#include <Eigen/Dense>
+#include <cstddef>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "../nn/model.h"
+
+enum class NpyType {
+    Float32,  // '<f4'
+    Float64   // '<f8'
+};
+
+// What the header of a .npy array describes
+struct NpyHeader {
+    NpyType dtype = NpyType::Float64;
+    bool fortran_order = false;
+    size_t rows = 0;
+    size_t cols = 0;
+    size_t data_offset = 0;  // Bytes from the start of the .npy data to the array
+
+    size_t element_size() const { return dtype == NpyType::Float32 ? 4 : 8; }
+};
+
+class NpyMap {
+public:
+    /**
+     * @brief Memory-maps a .npy file read-only. Throws std::runtime_error if
+     * the file cannot be mapped or is not a supported array.
+     *
+     * @param path The file to map
+     */
+    explicit NpyMap(const std::string& path);
+
+    ~NpyMap();
+
+    NpyMap(const NpyMap&) = delete;
+    NpyMap& operator=(const NpyMap&) = delete;
+
+    const NpyHeader& header() const { return header_; }
+    size_t rows() const { return header_.rows; }
+    size_t cols() const { return header_.cols; }
+
+    /**
+     * @brief A view of the array without copying. Scalar must be the dtype of
+     * the file (float or double) and Order its memory order (Eigen::ColMajor
+     * for Fortran order, Eigen::RowMajor for C order); throws
+     * std::runtime_error otherwise. The view is valid while the NpyMap lives.
+     */
+    template <typename Scalar, int Order = Eigen::ColMajor>
+    Eigen::Map<const Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic, Order>> view() const {
+        static_assert(std::is_same<Scalar, float>::value || std::is_same<Scalar, double>::value,
+                      "npy arrays are float or double");
+        bool is_double = std::is_same<Scalar, double>::value;
+        if (is_double != (header_.dtype == NpyType::Float64)
+            || (Order == Eigen::ColMajor) != header_.fortran_order) {
+            throw std::runtime_error("NpyMap: the array does not have the requested type or order");
+        }
+        const Scalar* data = reinterpret_cast<const Scalar*>(base_ + header_.data_offset);
+        return Eigen::Map<const Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic, Order>>(
+            data, header_.rows, header_.cols);
+    }
+
+    /**
+     * @brief The array as a MatrixXd view, for Fortran-order float64 files.
+     */
+    Eigen::Map<const Eigen::MatrixXd> matrix() const { return view<double>(); }
+
+    /**
+     * @brief The array copied into a MatrixXd, converting type and order as needed.
+     */
+    Eigen::MatrixXd to_matrix() const;
+
+private:
+    const char* base_;
+    size_t bytes_;
+    NpyHeader header_;
+};
+
+/**
+ * @brief Reads a .npy file into a matrix. Throws std::runtime_error if the
+ * file cannot be read or is not a supported array.
+ *
+ * @param path The file to read
+ * @return Eigen::MatrixXd The array
+ */
+Eigen::MatrixXd load_npy(const std::string& path);
+
+/**
+ * @brief Writes a matrix to a .npy file, as a 2-D Fortran-order array.
+ *
+ * @param path The file to write
+ * @param M The matrix
+ * @param dtype The type to store the values as
+ */
+void save_npy(const std::string& path, const Eigen::MatrixXd& M, NpyType dtype = NpyType::Float64);
+
+/**
+ * @brief Reads every array of a stored .npz archive, keyed by name (without
+ * the .npy suffix).
+ *
+ * @param path The archive to read
+ * @return std::map<std::string, Eigen::MatrixXd> The arrays
+ */
+std::map<std::string, Eigen::MatrixXd> load_npz(const std::string& path);
+
+/**
+ * @brief Writes the matrices to a stored .npz archive, readable by np.load.
+ *
+ * @param path The archive to write
+ * @param arrays The matrices, keyed by name
+ * @param dtype The type to store the values as
+ */
+void save_npz(const std::string& path, const std::map<std::string, Eigen::MatrixXd>& arrays,
+              NpyType dtype = NpyType::Float64);
+
+/**
+ * @brief Writes the weights and biases of every layer of the model (and of
+ * their sublayers) to a .npz archive, as "layer<i>.weight" (out x in, as in
+ * PyTorch) and "layer<i>.bias", and "layer<i>.<j>.weight" for sublayer j.
+ * The weights of HalfLinear and SparseLinear layers are widened to dense
+ * doubles, so every layer type is saved the same way.
+ *
+ * @param path The archive to write
+ * @param model The model to save
+ */
+void save_parameters(const std::string& path, Model& model);
+
+/**
+ * @brief Loads the weights and biases written by save_parameters (or by a
+ * Python script using the same names) into the layers of the model. Throws
+ * std::runtime_error if an array is missing or has the wrong shape. A bias
+ * may be stored as a 1-D array. HalfLinear layers round the weights to their
+ * 16-bit format, and SparseLinear layers keep the non-zero weights.
+ *
+ * @param path The archive to read
+ * @param model The model to load into
+ */
+void load_parameters(const std::string& path, Model& model);
+
+#endif // NPY_H
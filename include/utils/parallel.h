@@ -0,0 +1,66 @@
+/**
+ * @file parallel.h
+ * @author Krish Suraparaju (csurapar@andrew.cmu.edu)
+ * @brief Small helpers for splitting a loop across the cores of the machine.
+ *
+ * Most loops in this library (GEMM blocks, elementwise activations, gathers,
+ * scatters, row-wise reductions) can be split into independent [begin, end)
+ * ranges and run on separate threads. parallel_for only does so when the
+ * range is large enough for the threading overhead to pay off. The chunks run
+ * on the global ThreadPool (include/utils/thread_pool.h), which also decides
+ * how many threads there are and where they run.
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <cstddef>
+#include <functional>
+
+/**
+ * @brief Runs fn over [begin, end), split into contiguous chunks of at least
+ *        grain iterations. Each chunk is handed to fn as (chunk_begin, chunk_end).
+ *        If the range holds fewer than two chunks, fn is called once on the
+ *        calling thread. Chunks must be independent of each other. fn may
+ *        itself call parallel_for.
+ *
+ * @param begin First index of the range
+ * @param end One past the last index of the range
+ * @param grain Minimum number of iterations per chunk
+ * @param fn The work to run on each chunk
+ */
+void parallel_for(size_t begin, size_t end, size_t grain,
+                  const std::function<void(size_t, size_t)>& fn);
+
+/**
+ * @brief Number of threads parallel_for will use at most.
+ *
+ * @return size_t The number of worker threads (at least 1)
+ */
+size_t num_threads();
+
+/**
+ * @brief While alive, every parallel_for called by the creating thread runs
+ *        on that thread alone instead of on the global pool, e.g. for a thread
+ *        pinned to its own core that should keep its data in that core's
+ *        caches. Scopes can be nested.
+ */
+class SerialScope {
+public:
+    SerialScope();
+    ~SerialScope();
+
+    SerialScope(const SerialScope&) = delete;
+    SerialScope& operator=(const SerialScope&) = delete;
+
+private:
+    bool previous_;
+};
+
+#endif // PARALLEL_H
@@ -0,0 +1,97 @@
+/**
+ * @file spsc_queue.h
+ * @author Krish Suraparaju (csurapar@andrew.cmu.edu)
+ * @brief A bounded lock-free queue for exactly one producer thread and one
+ * consumer thread.
+ *
+ * The queue is a ring buffer with one index owned by each side. The producer
+ * only writes tail_ and the consumer only writes head_, so the two sides never
+ * contend on a lock; they only publish their index with release/acquire
+ * ordering. The indices live on separate cache lines to avoid false sharing.
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <utility>
+#include <vector>
+
+template <typename T>
+class SpscQueue {
+public:
+    /**
+     * @brief Construct a new queue that can hold up to capacity elements.
+     *
+     * @param capacity The maximum number of queued elements
+     */
+    explicit SpscQueue(size_t capacity) : buffer_(capacity + 1) {}
+
+    /**
+     * @brief Adds an element if there is room. Producer thread only.
+     *
+     * @param value The element to add, moved from only on success
+     * @return true If the element was added
+     */
+    bool try_push(T& value) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        size_t next = tail + 1 == buffer_.size() ? 0 : tail + 1;
+        if (next == head_.load(std::memory_order_acquire)) {
+            return false;
+        }
+        buffer_[tail] = std::move(value);
+        tail_.store(next, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Removes the oldest element if there is one. Consumer thread only.
+     *
+     * @param value Receives the element on success
+     * @return true If an element was removed
+     */
+    bool try_pop(T& value) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tail_.load(std::memory_order_acquire)) {
+            return false;
+        }
+        value = std::move(buffer_[head]);
+        head_.store(head + 1 == buffer_.size() ? 0 : head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Adds an element, spinning while the queue is full.
+     */
+    void push(T value) {
+        while (!try_push(value)) {
+            std::this_thread::yield();
+        }
+    }
+
+    /**
+     * @brief Removes the oldest element, spinning while the queue is empty.
+     */
+    T pop() {
+        T value;
+        while (!try_pop(value)) {
+            std::this_thread::yield();
+        }
+        return value;
+    }
+
+private:
+    std::vector<T> buffer_;
+    alignas(64) std::atomic<size_t> head_{0};  // Next slot to read, owned by the consumer
+    alignas(64) std::atomic<size_t> tail_{0};  // Next slot to write, owned by the producer
+};
+
+#endif // SPSC_QUEUE_H
@@ -0,0 +1,136 @@
+/**
+ * @file thread_pool.h
+ * @author Krish Suraparaju (csurapar@andrew.cmu.edu)
+ * @brief The library-wide work-stealing thread pool behind parallel_for.
+ *
+ * Every worker owns a deque of tasks. A thread that submits work pushes it
+ * onto deques (its own if it is a worker, spread over all workers otherwise)
+ * and then helps: it runs tasks itself until everything it submitted is done.
+ * Workers take tasks from the back of their own deque and, when it is empty,
+ * steal from the front of the others. Because waiting threads keep running
+ * tasks, parallel_for can be nested without deadlocking or creating threads.
+ *
+ * There is one global pool, so the elementwise kernels, the reductions and
+ * the GEMMs all share the same threads instead of oversubscribing the cores.
+ * Its size defaults to the DNN_NUM_THREADS environment variable, or else to
+ * the number of cores. Workers can be pinned to cores, ordered by NUMA node:
+ * Compact fills one node before moving to the next (threads share caches and
+ * memory), Scatter deals the workers out over the nodes in turn (more memory
+ * bandwidth). Nodes are read from /sys/devices/system/node on Linux.
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+enum class ThreadAffinity {
+    None,     // Let the OS schedule the workers
+    Compact,  // Pin workers to consecutive cores, one NUMA node after the other
+    Scatter   // Pin workers round-robin over the NUMA nodes
+};
+
+class ThreadPool {
+public:
+    /**
+     * @brief Starts num_threads - 1 workers; the thread that submits work
+     * is the last one.
+     *
+     * @param num_threads The total number of threads running tasks (at least 1)
+     * @param affinity How the workers are pinned to cores
+     */
+    explicit ThreadPool(size_t num_threads, ThreadAffinity affinity = ThreadAffinity::None);
+
+    /**
+     * @brief Waits for the queued tasks to finish, then stops the workers.
+     */
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * @brief Runs task(0), ..., task(num_tasks - 1) on the pool and returns
+     * once all of them have finished. The calling thread runs tasks too. If a
+     * task throws, the first exception is rethrown here after the others
+     * finished.
+     *
+     * @param num_tasks The number of tasks
+     * @param task The work, called with the index of the task
+     */
+    void run(size_t num_tasks, const std::function<void(size_t)>& task);
+
+    /**
+     * @brief The number of threads running tasks, including the caller.
+     */
+    size_t num_threads() const { return workers_.size() + 1; }
+
+    /**
+     * @brief The core worker i is pinned to, or -1 if it is not pinned.
+     */
+    int worker_cpu(size_t i) const { return workers_[i]->cpu; }
+
+    /**
+     * @brief The global pool used by parallel_for, created on first use.
+     */
+    static ThreadPool& global();
+
+    /**
+     * @brief Replaces the global pool. Must not be called while parallel work
+     * is running.
+     *
+     * @param num_threads The total number of threads, 0 for the default
+     * @param affinity How the workers are pinned to cores
+     */
+    static void configure(size_t num_threads, ThreadAffinity affinity = ThreadAffinity::None);
+
+private:
+    // The tasks of one call to run
+    struct Group {
+        const std::function<void(size_t)>* task;
+        std::atomic<size_t> remaining;
+        std::exception_ptr error;
+        std::mutex mutex;
+        std::condition_variable done;
+    };
+
+    struct Task {
+        Group* group;
+        size_t index;
+    };
+
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+        std::thread thread;
+        int cpu = -1;
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::atomic<long> queued_{0};  // Tasks pushed but not taken yet
+    std::atomic<size_t> next_victim_{0};
+    std::mutex sleep_mutex_;
+    std::condition_variable wake_;
+    bool stop_ = false;
+
+    void worker_loop(size_t i);
+    bool try_take(Task& task);
+    void execute(const Task& task);
+};
+
+#endif // THREAD_POOL_H
@@ -0,0 +1,179 @@
+/**
+ * @file allreduce.cpp
+ * @author Krish Suraparaju (csurapar@andrew.cmu.edu)
+ * @brief Provides the implementation of the shared memory collectives
+ *        defined in include/dist/allreduce.h header.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include "../../include/dist/allreduce.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free,
+              "process-shared atomics must be lock-free");
+
+// Written last by rank 0 once the segment is set up
+static const uint64_t SHM_READY = 0x646e6e5f73686d31;  // "dnn_shm1"
+
+/**
+ * @brief Lives at the start of the segment. Rank 0 always creates a new
+ * segment, which is zero-filled: a valid initial state for all the counters.
+ */
+struct ShmAllReduce::Header {
+    alignas(64) std::atomic<uint64_t> arrived;     // Ranks waiting at the barrier
+    alignas(64) std::atomic<uint64_t> generation;  // Number of completed barriers
+    alignas(64) std::atomic<uint64_t> ready;       // SHM_READY once rank 0 is done
+    std::atomic<int64_t> owner;                    // Process id of rank 0
+};
+
+ShmAllReduce::ShmAllReduce(const std::string& name, size_t rank, size_t world_size,
+                           size_t capacity)
+    : rank_(rank), world_size_(world_size), capacity_(std::max<size_t>(capacity, 1)) {
+    std::string path = name.empty() || name[0] != '/' ? "/" + name : name;
+    size_t header_bytes = (sizeof(Header) + 63) / 64 * 64;
+    this->bytes_ = header_bytes + (world_size + 1) * this->capacity_ * sizeof(double);
+
+    void* base = nullptr;
+    if (rank == 0) {
+        // A run that died before its first barrier leaves its segment behind,
+        // with counters in the middle of a barrier: never reuse it
+        shm_unlink(path.c_str());
+        int fd = shm_open(path.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+        if (fd < 0) {
+            throw std::runtime_error("ShmAllReduce: shm_open failed for " + path);
+        }
+        if (ftruncate(fd, this->bytes_) != 0) {
+            close(fd);
+            shm_unlink(path.c_str());
+            throw std::runtime_error("ShmAllReduce: ftruncate failed for " + path);
+        }
+        base = mmap(nullptr, this->bytes_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (base == MAP_FAILED) {
+            shm_unlink(path.c_str());
+            throw std::runtime_error("ShmAllReduce: mmap failed for " + path);
+        }
+        Header* header = static_cast<Header*>(base);
+        header->owner.store(getpid(), std::memory_order_relaxed);
+        header->ready.store(SHM_READY, std::memory_order_release);
+    } else {
+        // Wait for rank 0 to create the segment. One whose creator is gone is
+        // left over from an earlier run, and rank 0 will replace it
+        while (true) {
+            int fd = shm_open(path.c_str(), O_RDWR, 0600);
+            if (fd < 0 && errno != ENOENT) {
+                throw std::runtime_error("ShmAllReduce: shm_open failed for " + path);
+            }
+            struct stat st;
+            if (fd >= 0 && fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) >= this->bytes_) {
+                base = mmap(nullptr, this->bytes_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+                close(fd);
+                if (base == MAP_FAILED) {
+                    throw std::runtime_error("ShmAllReduce: mmap failed for " + path);
+                }
+                Header* header = static_cast<Header*>(base);
+                if (header->ready.load(std::memory_order_acquire) == SHM_READY
+                    && kill(static_cast<pid_t>(header->owner.load(std::memory_order_relaxed)), 0) == 0) {
+                    break;
+                }
+                munmap(base, this->bytes_);
+            } else if (fd >= 0) {
+                close(fd);
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    char* bytes = static_cast<char*>(base);
+    this->header_ = reinterpret_cast<Header*>(bytes);
+    this->slots_ = reinterpret_cast<double*>(bytes + header_bytes);
+    this->result_ = this->slots_ + world_size * this->capacity_;
+
+    // Once everyone is attached the name is no longer needed, and unlinking it
+    // right away means the segment cannot leak if a process dies later on
+    this->barrier();
+    if (rank == 0) {
+        shm_unlink(path.c_str());
+    }
+}
+
+ShmAllReduce::~ShmAllReduce() {
+    munmap(this->header_, this->bytes_);
+}
+
+void ShmAllReduce::barrier() {
+    uint64_t generation = this->header_->generation.load(std::memory_order_acquire);
+    if (this->header_->arrived.fetch_add(1, std::memory_order_acq_rel) + 1 == this->world_size_) {
+        this->header_->arrived.store(0, std::memory_order_relaxed);
+        this->header_->generation.fetch_add(1, std::memory_order_release);
+        return;
+    }
+    while (this->header_->generation.load(std::memory_order_acquire) == generation) {
+        std::this_thread::yield();
+    }
+}
+
+void ShmAllReduce::allreduce_sum(double* data, size_t count) {
+    size_t W = this->world_size_;
+    for (size_t offset = 0; offset < count; offset += this->capacity_) {
+        size_t n = std::min(this->capacity_, count - offset);
+        double* slot = this->slots_ + this->rank_ * this->capacity_;
+        std::memcpy(slot, data + offset, n * sizeof(double));
+        this->barrier();
+
+        // Reduce-scatter: this rank sums its own chunk over every slot
+        size_t lo = n * this->rank_ / W;
+        size_t hi = n * (this->rank_ + 1) / W;
+        std::copy(this->slots_ + lo, this->slots_ + hi, this->result_ + lo);
+        for (size_t r = 1; r < W; r++) {
+            const double* other = this->slots_ + r * this->capacity_;
+            for (size_t k = lo; k < hi; k++) {
+                this->result_[k] += other[k];
+            }
+        }
+        this->barrier();
+
+        // All-gather, then wait before the slots and the result are reused
+        std::memcpy(data + offset, this->result_, n * sizeof(double));
+        this->barrier();
+    }
+}
+
+void ShmAllReduce::allreduce_mean(double* data, size_t count) {
+    this->allreduce_sum(data, count);
+    double scale = 1.0 / this->world_size_;
+    for (size_t k = 0; k < count; k++) {
+        data[k] *= scale;
+    }
+}
+
+void ShmAllReduce::broadcast(double* data, size_t count, size_t root) {
+    for (size_t offset = 0; offset < count; offset += this->capacity_) {
+        size_t n = std::min(this->capacity_, count - offset);
+        if (this->rank_ == root) {
+            std::memcpy(this->result_, data + offset, n * sizeof(double));
+        }
+        this->barrier();
+        if (this->rank_ != root) {
+            std::memcpy(data + offset, this->result_, n * sizeof(double));
+        }
+        this->barrier();
+    }
+}
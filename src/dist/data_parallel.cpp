@@ -0,0 +1,108 @@
+/**
+ * @file data_parallel.cpp
+ * @author Krish Suraparaju (csurapar@andrew.cmu.edu)
+ * @brief Provides the implementation of the data-parallel training
+ *        defined in include/dist/data_parallel.h header.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include "../../include/dist/data_parallel.h"
+#include "../../include/utils/spsc_queue.h"
+#include <algorithm>
+#include <memory>
+#include <thread>
+
+/**
+ * @brief A group of gradient matrices that are reduced together. The
+ * gradients are copied into one contiguous buffer, reduced, and copied back.
+ */
+struct Bucket {
+    std::vector<Eigen::MatrixXd*> gradients;
+    std::vector<double> data;
+};
+
+static void reduce_bucket(ShmAllReduce& comm, Bucket& bucket) {
+    size_t offset = 0;
+    for (Eigen::MatrixXd* gradient : bucket.gradients) {
+        std::copy(gradient->data(), gradient->data() + gradient->size(), bucket.data.data() + offset);
+        offset += gradient->size();
+    }
+    comm.allreduce_mean(bucket.data.data(), bucket.data.size());
+    offset = 0;
+    for (Eigen::MatrixXd* gradient : bucket.gradients) {
+        std::copy(bucket.data.data() + offset, bucket.data.data() + offset + gradient->size(), gradient->data());
+        offset += gradient->size();
+    }
+}
+
+/**
+ * @brief The layer followed by its sublayers, recursively.
+ */
+static std::vector<Layer*> with_children(Layer& layer) {
+    std::vector<Layer*> layers = {&layer};
+    for (Layer* child : layer.children()) {
+        std::vector<Layer*> nested = with_children(*child);
+        layers.insert(layers.end(), nested.begin(), nested.end());
+    }
+    return layers;
+}
+
+void DataParallel::broadcast_parameters() {
+    for (std::unique_ptr<Layer>& layer : this->model_.layers_) {
+        for (Layer* part : with_children(*layer)) {
+            // Layers such as HalfLinear and SparseLinear keep their weights
+            // outside W_; they are sent densely and converted back
+            Eigen::MatrixXd W = part->weights();
+            this->comm_.broadcast(W.data(), W.size());
+            if (W.size() > 0) {
+                part->set_weights(W);
+            }
+            this->comm_.broadcast(part->b_.data(), part->b_.size());
+        }
+    }
+}
+
+void DataParallel::backward() {
+    // Buckets are filled by the backward pass and drained by the
+    // communication thread. A null bucket marks the end of the pass.
+    std::vector<std::unique_ptr<Bucket>> buckets;
+    SpscQueue<Bucket*> ready(this->model_.layers_.size() + 1);
+    std::thread communicator([&]() {
+        for (Bucket* bucket = ready.pop(); bucket != nullptr; bucket = ready.pop()) {
+            reduce_bucket(this->comm_, *bucket);
+        }
+    });
+
+    std::unique_ptr<Bucket> current = std::make_unique<Bucket>();
+    size_t filled = 0;
+    auto flush = [&]() {
+        current->data.resize(filled);
+        ready.push(current.get());
+        buckets.push_back(std::move(current));
+        current = std::make_unique<Bucket>();
+        filled = 0;
+    };
+
+    this->model_.backward([&](size_t i) {
+        for (Layer* layer : with_children(*this->model_.layers_[i])) {
+            for (Eigen::MatrixXd* gradient : {&layer->dLdW_, &layer->dLdb_}) {
+                if (gradient->size() > 0) {
+                    current->gradients.push_back(gradient);
+                    filled += gradient->size();
+                }
+            }
+        }
+        if (filled >= this->bucket_size_) {
+            flush();
+        }
+    });
+    if (filled > 0) {
+        flush();
+    }
+    ready.push(nullptr);
+    communicator.join();
+}
@@ -0,0 +1,239 @@
+/**
+ * @file metrics.cpp
+ * @author Krish Suraparaju (csurapar@andrew.cmu.edu)
+ * @brief Provides the implementation of the streaming metrics defined in
+ *        include/metrics/metrics.h header.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include "../../include/metrics/metrics.h"
+#include "../../include/utils/parallel.h"
+#include "../../include/utils/thread_pool.h"
+#include <cassert>
+#include <mutex>
+
+/**
+ * @brief The class of sample n: the index of the largest entry of a one-hot
+ * row, or the value of a single column.
+ */
+static size_t target_class(const Eigen::MatrixXd& Y, Eigen::Index n) {
+    if (Y.cols() == 1) {
+        return static_cast<size_t>(Y(n, 0));
+    }
+    Eigen::Index c;
+    Y.row(n).maxCoeff(&c);
+    return static_cast<size_t>(c);
+}
+
+/**
+ * @brief The predicted class of sample n: the largest score, or for a single
+ * score (binary classification), whether it is at least 0.5.
+ */
+static size_t predicted_class(const Eigen::MatrixXd& P, Eigen::Index n) {
+    if (P.cols() == 1) {
+        return P(n, 0) >= 0.5 ? 1 : 0;
+    }
+    Eigen::Index c;
+    P.row(n).maxCoeff(&c);
+    return static_cast<size_t>(c);
+}
+
+void TopKAccuracy::update(const Eigen::MatrixXd& P, const Eigen::MatrixXd& Y) {
+    assert(P.rows() == Y.rows());
+    for (Eigen::Index n = 0; n < P.rows(); n++) {
+        size_t t = target_class(Y, n);
+        if (P.cols() == 1) {
+            this->correct_ += predicted_class(P, n) == t ? 1 : 0;
+            continue;
+        }
+        // The target is in the top k if fewer than k scores beat it
+        size_t better = (P.row(n).array() > P(n, t)).count();
+        this->correct_ += better < this->k_ ? 1 : 0;
+    }
+    this->total_ += P.rows();
+}
+
+void TopKAccuracy::merge(const Metric& other) {
+    const TopKAccuracy& o = dynamic_cast<const TopKAccuracy&>(other);
+    assert(o.k_ == this->k_);
+    this->correct_ += o.correct_;
+    this->total_ += o.total_;
+}
+
+double TopKAccuracy::result() const {
+    return this->total_ == 0 ? 0.0 : static_cast<double>(this->correct_) / this->total_;
+}
+
+void TopKAccuracy::reset() {
+    this->correct_ = 0;
+    this->total_ = 0;
+}
+
+std::unique_ptr<Metric> TopKAccuracy::fresh() const {
+    return std::make_unique<TopKAccuracy>(this->k_);
+}
+
+std::unique_ptr<Metric> Accuracy::fresh() const {
+    return std::make_unique<Accuracy>();
+}
+
+double ConfusionMatrix::precision(size_t c) const {
+    size_t predicted = 0;
+    for (size_t t = 0; t < this->num_classes_; t++) {
+        predicted += this->count(t, c);
+    }
+    return predicted == 0 ? 0.0 : static_cast<double>(this->count(c, c)) / predicted;
+}
+
+double ConfusionMatrix::recall(size_t c) const {
+    size_t actual = 0;
+    for (size_t p = 0; p < this->num_classes_; p++) {
+        actual += this->count(c, p);
+    }
+    return actual == 0 ? 0.0 : static_cast<double>(this->count(c, c)) / actual;
+}
+
+double ConfusionMatrix::f1(size_t c) const {
+    double p = this->precision(c), r = this->recall(c);
+    return p + r == 0.0 ? 0.0 : 2 * p * r / (p + r);
+}
+
+double ConfusionMatrix::macro_precision() const {
+    double sum = 0.0;
+    for (size_t c = 0; c < this->num_classes_; c++) {
+        sum += this->precision(c);
+    }
+    return sum / this->num_classes_;
+}
+
+double ConfusionMatrix::macro_recall() const {
+    double sum = 0.0;
+    for (size_t c = 0; c < this->num_classes_; c++) {
+        sum += this->recall(c);
+    }
+    return sum / this->num_classes_;
+}
+
+double ConfusionMatrix::macro_f1() const {
+    double sum = 0.0;
+    for (size_t c = 0; c < this->num_classes_; c++) {
+        sum += this->f1(c);
+    }
+    return sum / this->num_classes_;
+}
+
+void ConfusionMatrix::update(const Eigen::MatrixXd& P, const Eigen::MatrixXd& Y) {
+    assert(P.rows() == Y.rows());
+    for (Eigen::Index n = 0; n < P.rows(); n++) {
+        size_t t = target_class(Y, n), p = predicted_class(P, n);
+        assert(t < this->num_classes_ && p < this->num_classes_);
+        this->counts_[t * this->num_classes_ + p]++;
+    }
+}
+
+void ConfusionMatrix::merge(const Metric& other) {
+    const ConfusionMatrix& o = dynamic_cast<const ConfusionMatrix&>(other);
+    assert(o.num_classes_ == this->num_classes_);
+    for (size_t i = 0; i < this->counts_.size(); i++) {
+        this->counts_[i] += o.counts_[i];
+    }
+}
+
+double ConfusionMatrix::result() const {
+    size_t correct = 0, total = 0;
+    for (size_t t = 0; t < this->num_classes_; t++) {
+        for (size_t p = 0; p < this->num_classes_; p++) {
+            total += this->count(t, p);
+        }
+        correct += this->count(t, t);
+    }
+    return total == 0 ? 0.0 : static_cast<double>(correct) / total;
+}
+
+void ConfusionMatrix::reset() {
+    std::fill(this->counts_.begin(), this->counts_.end(), 0);
+}
+
+std::unique_ptr<Metric> ConfusionMatrix::fresh() const {
+    return std::make_unique<ConfusionMatrix>(this->num_classes_);
+}
+
+std::unique_ptr<Metric> Precision::fresh() const {
+    return std::make_unique<Precision>(this->num_classes_);
+}
+
+std::unique_ptr<Metric> Recall::fresh() const {
+    return std::make_unique<Recall>(this->num_classes_);
+}
+
+std::unique_ptr<Metric> F1Score::fresh() const {
+    return std::make_unique<F1Score>(this->num_classes_);
+}
+
+void MeanSquaredErrorMetric::update(const Eigen::MatrixXd& P, const Eigen::MatrixXd& Y) {
+    this->sum_ += (P - Y).array().square().sum();
+    this->count_ += P.size();
+}
+
+void MeanSquaredErrorMetric::merge(const Metric& other) {
+    const MeanSquaredErrorMetric& o = dynamic_cast<const MeanSquaredErrorMetric&>(other);
+    this->sum_ += o.sum_;
+    this->count_ += o.count_;
+}
+
+double MeanSquaredErrorMetric::result() const {
+    return this->count_ == 0 ? 0.0 : this->sum_ / this->count_;
+}
+
+void MeanSquaredErrorMetric::reset() {
+    this->sum_ = 0.0;
+    this->count_ = 0;
+}
+
+std::unique_ptr<Metric> MeanSquaredErrorMetric::fresh() const {
+    return std::make_unique<MeanSquaredErrorMetric>();
+}
+
+void MeanAbsoluteErrorMetric::update(const Eigen::MatrixXd& P, const Eigen::MatrixXd& Y) {
+    this->sum_ += (P - Y).array().abs().sum();
+    this->count_ += P.size();
+}
+
+std::unique_ptr<Metric> MeanAbsoluteErrorMetric::fresh() const {
+    return std::make_unique<MeanAbsoluteErrorMetric>();
+}
+
+void evaluate(const Model& model, const BatchSource& next_batch,
+              const std::vector<Metric*>& metrics, size_t num_workers) {
+    if (num_workers == 0) {
+        num_workers = num_threads();
+    }
+    std::mutex source_mutex, merge_mutex;
+    ThreadPool::global().run(num_workers, [&](size_t) {
+        std::vector<std::unique_ptr<Metric>> partial;
+        for (Metric* metric : metrics) {
+            partial.push_back(metric->fresh());
+        }
+        Eigen::MatrixXd X, Y;
+        while (true) {
+            {
+                std::lock_guard<std::mutex> lock(source_mutex);
+                if (!next_batch(X, Y)) {
+                    break;
+                }
+            }
+            Eigen::MatrixXd P = model.predict(X);
+            for (std::unique_ptr<Metric>& metric : partial) {
+                metric->update(P, Y);
+            }
+        }
+        std::lock_guard<std::mutex> lock(merge_mutex);
+        for (size_t i = 0; i < metrics.size(); i++) {
+            metrics[i]->merge(*partial[i]);
+        }
+    });
+}
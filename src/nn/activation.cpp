@@ -11,6 +11,104 @@
  */
 
 #include "../../include/nn/activation.h"
+#include "../../include/utils/parallel.h"
+#include <mutex>
+#include <stdexcept>
+
+// Below this many elements, activations run on a single thread
+static const size_t ELEMENTWISE_PARALLEL_GRAIN = 1 << 15;
+
+typedef Eigen::Map<const Eigen::MatrixXd> ConstMap;
+
+std::unique_ptr<ActivationFunction> ActivationFunction::clone() const {
+    throw std::runtime_error("ActivationFunction::clone: this activation type does not support snapshots");
+}
+
+// Serializes the default ActivationFunction::predict, which borrows forward
+static std::mutex default_predict_mutex;
+
+Eigen::MatrixXd ActivationFunction::predict(const Eigen::MatrixXd& Z) const {
+    std::lock_guard<std::mutex> lock(default_predict_mutex);
+    ActivationFunction& activation = const_cast<ActivationFunction&>(*this);
+    Cache saved;
+    activation.swap_cache(saved);
+    Eigen::MatrixXd A;
+    try {
+        A = activation.forward(Z);
+    } catch (...) {
+        activation.swap_cache(saved);
+        throw;
+    }
+    activation.swap_cache(saved);
+    return A;
+}
+
+/**
+ * @brief Applies fn to matching [lo, hi) ranges of the size coefficients of
+ * the inputs (Y may be null) and of out. Ranges are run in parallel when there
+ * are enough coefficients.
+ */
+template <typename F>
+static void elementwise_into(const double* X, const double* Y, double* out, size_t size, F fn) {
+    parallel_for(0, size, ELEMENTWISE_PARALLEL_GRAIN, [&](size_t lo, size_t hi) {
+        Eigen::Index n = hi - lo;
+        Eigen::Map<const Eigen::ArrayXd> x(X + lo, n);
+        Eigen::Map<const Eigen::ArrayXd> y(Y == nullptr ? nullptr : Y + lo, Y == nullptr ? 0 : n);
+        Eigen::Map<Eigen::ArrayXd> o(out + lo, n);
+        fn(x, y, o);
+    });
+}
+
+template <typename F>
+static void elementwise_into(const double* X, double* out, size_t size, F fn) {
+    elementwise_into(X, nullptr, out, size, [&](const Eigen::Map<const Eigen::ArrayXd>& x,
+                                               const Eigen::Map<const Eigen::ArrayXd>&,
+                                               Eigen::Map<Eigen::ArrayXd>& o) { fn(x, o); });
+}
+
+/**
+ * @brief Same as elementwise_into, returning a new matrix with the shape of X.
+ */
+template <typename F>
+static Eigen::MatrixXd elementwise(const Eigen::MatrixXd& X, ConstMap Y, F fn) {
+    Eigen::MatrixXd out(X.rows(), X.cols());
+    elementwise_into(X.data(), Y.data(), out.data(), X.size(), fn);
+    return out;
+}
+
+template <typename F>
+static Eigen::MatrixXd elementwise(const Eigen::MatrixXd& X, F fn) {
+    Eigen::MatrixXd out(X.rows(), X.cols());
+    elementwise_into(X.data(), out.data(), X.size(), fn);
+    return out;
+}
+
+/**
+ * @brief Caches a copy of the output for backward.
+ */
+static void keep_copy(ActivationFunction& activation, const Eigen::MatrixXd& A) {
+    activation.A_ = A;
+    activation.A_view_ = nullptr;
+}
+
+/**
+ * @brief Keeps a view of the output in place of a cached copy (see
+ * ActivationFunction::forward_view).
+ */
+static void keep_view(ActivationFunction& activation, Eigen::Map<Eigen::MatrixXd> A) {
+    activation.A_.resize(0, 0);
+    activation.A_view_ = A.data();
+    activation.A_view_rows_ = A.rows();
+    activation.A_view_cols_ = A.cols();
+}
+
+// The activations applied to a range of coefficients
+static const auto relu_fn = [](const auto& z, auto& a) { a = z.cwiseMax(0); };
+static const auto sigmoid_fn = [](const auto& z, auto& a) { a = 1 / (1 + (-z).exp()); };
+static const auto tanh_fn = [](const auto& z, auto& a) {
+    Eigen::ArrayXd e = z.exp(), e_neg = (-z).exp();
+    a = (e - e_neg) / (e + e_neg);
+};
 
 
 /**
@@ -21,11 +119,20 @@
  * @return Eigen::MatrixXd The activated output
  */
 Eigen::MatrixXd ReLU::forward(const Eigen::MatrixXd& Z) {
-    Eigen::MatrixXd A = Z.cwiseMax(0);
-    this->A_ = A;
+    Eigen::MatrixXd A = this->predict(Z);
+    keep_copy(*this, A);
     return A;
 }
 
+Eigen::MatrixXd ReLU::predict(const Eigen::MatrixXd& Z) const {
+    return elementwise(Z, relu_fn);
+}
+
+void ReLU::forward_view(ConstMap Z, Eigen::Map<Eigen::MatrixXd> A) {
+    elementwise_into(Z.data(), A.data(), Z.size(), relu_fn);
+    keep_view(*this, A);
+}
+
 /**
  * @brief Computes the derivative of the ReLU activation function,
  *       dL/dZ, where L is the loss and Z is the input.
@@ -34,9 +141,9 @@ Eigen::MatrixXd ReLU::forward(const Eigen::MatrixXd& Z) {
  * @return Eigen::MatrixXd The derivative of the loss with respect to the input Z
  */
 Eigen::MatrixXd ReLU::backward(const Eigen::MatrixXd& dLdA) {
-    Eigen::MatrixXd curr_A = this->A_;
-    Eigen::MatrixXd dAdZ = (curr_A.array() > 0).cast<double>();
-    return dLdA.cwiseProduct(dAdZ);
+    return elementwise(dLdA, this->cached_output(), [](const auto& g, const auto& a, auto& out) {
+        out = g * (a > 0).template cast<double>();
+    });
 }
 
 /**
@@ -47,12 +154,20 @@ Eigen::MatrixXd ReLU::backward(const Eigen::MatrixXd& dLdA) {
  * @return Eigen::MatrixXd The activated output (A)
  */
 Eigen::MatrixXd Sigmoid::forward(const Eigen::MatrixXd& Z) {
-    Eigen::MatrixXd one = Eigen::MatrixXd::Ones(Z.rows(), Z.cols());
-    Eigen::MatrixXd A = 1 / (1 + (-Z.array()).exp());
-    this->A_ = A;
+    Eigen::MatrixXd A = this->predict(Z);
+    keep_copy(*this, A);
     return A;
 }
 
+Eigen::MatrixXd Sigmoid::predict(const Eigen::MatrixXd& Z) const {
+    return elementwise(Z, sigmoid_fn);
+}
+
+void Sigmoid::forward_view(ConstMap Z, Eigen::Map<Eigen::MatrixXd> A) {
+    elementwise_into(Z.data(), A.data(), Z.size(), sigmoid_fn);
+    keep_view(*this, A);
+}
+
 /**
  * @brief Computes the derivative of the Sigmoid activation function,
  *       dL/dZ, where L is the loss and Z is the input. Note that
@@ -63,10 +178,9 @@ Eigen::MatrixXd Sigmoid::forward(const Eigen::MatrixXd& Z) {
  * @return Eigen::MatrixXd The derivative of the loss with respect to the input Z
  */
 Eigen::MatrixXd Sigmoid::backward(const Eigen::MatrixXd& dLdA) {
-    Eigen::MatrixXd A = this->A_;
-    Eigen::MatrixXd one = Eigen::MatrixXd::Ones(A.rows(), A.cols());
-    Eigen::MatrixXd dAdZ = A.cwiseProduct(one - A);
-    return dLdA.cwiseProduct(dAdZ);
+    return elementwise(dLdA, this->cached_output(), [](const auto& g, const auto& a, auto& out) {
+        out = g * a * (1 - a);
+    });
 }
 
 /**
@@ -77,11 +191,20 @@ Eigen::MatrixXd Sigmoid::backward(const Eigen::MatrixXd& dLdA) {
  * @return Eigen::MatrixXd The activated output (A)
  */
 Eigen::MatrixXd Tanh::forward(const Eigen::MatrixXd& Z) {
-    Eigen::MatrixXd A = (Z.array().exp() - (-Z.array()).exp()) / (Z.array().exp() + (-Z.array()).exp());
-    this->A_ = A;
+    Eigen::MatrixXd A = this->predict(Z);
+    keep_copy(*this, A);
     return A;
 }
 
+Eigen::MatrixXd Tanh::predict(const Eigen::MatrixXd& Z) const {
+    return elementwise(Z, tanh_fn);
+}
+
+void Tanh::forward_view(ConstMap Z, Eigen::Map<Eigen::MatrixXd> A) {
+    elementwise_into(Z.data(), A.data(), Z.size(), tanh_fn);
+    keep_view(*this, A);
+}
+
 /**
  * @brief Computes the derivative of the Tanh activation function,
  *       dL/dZ, where L is the loss and Z is the input. Note that
@@ -92,9 +215,74 @@ Eigen::MatrixXd Tanh::forward(const Eigen::MatrixXd& Z) {
  * @return Eigen::MatrixXd The derivative of the loss with respect to the input Z
  */
 Eigen::MatrixXd Tanh::backward(const Eigen::MatrixXd& dLdA) {
-    Eigen::MatrixXd A = this->A_;
-    Eigen::MatrixXd one = Eigen::MatrixXd::Ones(A.rows(), A.cols());
-    Eigen::MatrixXd dAdZ = one - A.cwiseProduct(A);
-    return dLdA.cwiseProduct(dAdZ);
+    return elementwise(dLdA, this->cached_output(), [](const auto& g, const auto& a, auto& out) {
+        out = g * (1 - a * a);
+    });
+}
+
+/**
+ * @brief Returns the input unchanged, storing it in A.
+ *
+ * @param Z The input from the previous layer (before-activation)
+ * @return Eigen::MatrixXd The activated output (A = Z)
+ */
+Eigen::MatrixXd Identity::forward(const Eigen::MatrixXd& Z) {
+    keep_copy(*this, Z);
+    return Z;
+}
+
+Eigen::MatrixXd Identity::predict(const Eigen::MatrixXd& Z) const {
+    return Z;
+}
+
+/**
+ * @brief Copies Z into A. Backward needs nothing, so nothing is kept.
+ */
+void Identity::forward_view(ConstMap Z, Eigen::Map<Eigen::MatrixXd> A) {
+    A = Z;
+    keep_copy(*this, Eigen::MatrixXd());
+}
+
+/**
+ * @brief dA/dZ = 1, so the gradient passes through unchanged.
+ *
+ * @param dLdA The derivative of the loss with respect to the activated output
+ * @return Eigen::MatrixXd The derivative of the loss with respect to the input Z
+ */
+Eigen::MatrixXd Identity::backward(const Eigen::MatrixXd& dLdA) {
+    return dLdA;
 }
 
+/**
+ * @brief Multiplies the input Z by the constant scale, storing the result in A.
+ *
+ * @param Z The input from the previous layer (before-activation)
+ * @return Eigen::MatrixXd The activated output (A = s * Z)
+ */
+Eigen::MatrixXd Scale::forward(const Eigen::MatrixXd& Z) {
+    Eigen::MatrixXd A = this->predict(Z);
+    keep_copy(*this, A);
+    return A;
+}
+
+Eigen::MatrixXd Scale::predict(const Eigen::MatrixXd& Z) const {
+    return this->scale_ * Z;
+}
+
+/**
+ * @brief Writes s * Z into A. Backward only needs s, so nothing is kept.
+ */
+void Scale::forward_view(ConstMap Z, Eigen::Map<Eigen::MatrixXd> A) {
+    A = this->scale_ * Z;
+    keep_copy(*this, Eigen::MatrixXd());
+}
+
+/**
+ * @brief dA/dZ = s, the constant scale.
+ *
+ * @param dLdA The derivative of the loss with respect to the activated output
+ * @return Eigen::MatrixXd The derivative of the loss with respect to the input Z
+ */
+Eigen::MatrixXd Scale::backward(const Eigen::MatrixXd& dLdA) {
+    return this->scale_ * dLdA;
+}
@@ -0,0 +1,170 @@
+/**
+ * @file attention.cpp
+ * @author Krish Suraparaju (csurapar@andrew.cmu.edu)
+ * @brief Provides the implementation of the blocked multi-head attention
+ *        defined in include/nn/attention.h header.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include "../../include/nn/attention.h"
+#include "../../include/utils/parallel.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+// Rows of Q and of K/V per block. With 64-wide heads, a block of K and of V
+// and the 64 x 64 scores between them take 96 KiB, which fits in L2 next to
+// the output accumulator, and one row of each fits in L1.
+static const size_t ATTENTION_BLOCK_Q = 64;
+static const size_t ATTENTION_BLOCK_KV = 64;
+
+MultiHeadAttention::MultiHeadAttention(size_t d_model, size_t num_heads, size_t seq_len)
+    : Layer(d_model, d_model), seq_len_(seq_len), num_heads_(num_heads),
+      head_dim_(d_model / num_heads), query_(d_model, d_model), key_(d_model, d_model),
+      value_(d_model, d_model), output_(d_model, d_model) {
+    assert(num_heads > 0 && d_model % num_heads == 0 && seq_len > 0);
+    this->W_ = Eigen::MatrixXd(0, 0);
+    this->b_ = Eigen::MatrixXd(0, 0);
+}
+
+/**
+ * @brief Computes O = softmax(Q K^T / sqrt(dh)) V for every sequence and head,
+ * and the log-sum-exp of every query row if LSE is given.
+ */
+static void attend(const Eigen::MatrixXd& Q, const Eigen::MatrixXd& K, const Eigen::MatrixXd& V,
+                   size_t T, size_t H, Eigen::MatrixXd& O, Eigen::MatrixXd* LSE) {
+    size_t N = Q.rows(), dh = Q.cols() / H;
+    O.resize(N, Q.cols());
+    if (LSE != nullptr) {
+        LSE->resize(N, H);
+    }
+    const double scale = 1.0 / std::sqrt(static_cast<double>(dh));
+
+    parallel_for(0, (N / T) * H, 1, [&](size_t lo, size_t hi) {
+        for (size_t task = lo; task < hi; task++) {
+            size_t r0 = (task / H) * T, h = task % H, c0 = h * dh;
+            // Contiguous copies of this head; the scale is folded into q
+            Eigen::MatrixXd q = Q.block(r0, c0, T, dh) * scale;
+            Eigen::MatrixXd k = K.block(r0, c0, T, dh);
+            Eigen::MatrixXd v = V.block(r0, c0, T, dh);
+
+            for (size_t i0 = 0; i0 < T; i0 += ATTENTION_BLOCK_Q) {
+                size_t bq = std::min(ATTENTION_BLOCK_Q, T - i0);
+                Eigen::VectorXd m = Eigen::VectorXd::Constant(bq, -std::numeric_limits<double>::infinity());
+                Eigen::VectorXd l = Eigen::VectorXd::Zero(bq);
+                Eigen::MatrixXd acc = Eigen::MatrixXd::Zero(bq, dh);
+
+                for (size_t j0 = 0; j0 < T; j0 += ATTENTION_BLOCK_KV) {
+                    size_t bk = std::min(ATTENTION_BLOCK_KV, T - j0);
+                    Eigen::MatrixXd S = q.middleRows(i0, bq) * k.middleRows(j0, bk).transpose();
+                    Eigen::VectorXd m_new = m.cwiseMax(S.rowwise().maxCoeff());
+                    // P = exp(S - m_new), and the partial sums so far are
+                    // rescaled by exp(m - m_new) <= 1
+                    S = (S.array().colwise() - m_new.array()).exp();
+                    Eigen::VectorXd correction = (m - m_new).array().exp();
+                    l = correction.cwiseProduct(l) + S.rowwise().sum();
+                    acc = correction.asDiagonal() * acc;
+                    acc.noalias() += S * v.middleRows(j0, bk);
+                    m = m_new;
+                }
+                O.block(r0 + i0, c0, bq, dh) = l.cwiseInverse().asDiagonal() * acc;
+                if (LSE != nullptr) {
+                    LSE->block(r0 + i0, h, bq, 1) = m.array() + l.array().log();
+                }
+            }
+        }
+    });
+}
+
+Eigen::MatrixXd MultiHeadAttention::forward(const Eigen::MatrixXd& A) {
+    assert(A.rows() % this->seq_len_ == 0);
+    this->N_ = A.rows();
+    this->Q_ = this->query_.forward(A);
+    this->K_ = this->key_.forward(A);
+    this->V_ = this->value_.forward(A);
+    attend(this->Q_, this->K_, this->V_, this->seq_len_, this->num_heads_, this->O_, &this->LSE_);
+    return this->output_.forward(this->O_);
+}
+
+Eigen::MatrixXd MultiHeadAttention::predict(const Eigen::MatrixXd& A) const {
+    assert(A.rows() % this->seq_len_ == 0);
+    Eigen::MatrixXd O;
+    attend(this->query_.predict(A), this->key_.predict(A), this->value_.predict(A),
+           this->seq_len_, this->num_heads_, O, nullptr);
+    return this->output_.predict(O);
+}
+
+Eigen::MatrixXd MultiHeadAttention::backward(const Eigen::MatrixXd& dLdZ) {
+    size_t N = this->N_, T = this->seq_len_, H = this->num_heads_, dh = this->head_dim_;
+    Eigen::MatrixXd dO = this->output_.backward(dLdZ);
+    Eigen::MatrixXd dQ(N, this->out_size_), dK(N, this->out_size_), dV(N, this->out_size_);
+    const double scale = 1.0 / std::sqrt(static_cast<double>(dh));
+
+    parallel_for(0, (N / T) * H, 1, [&](size_t lo, size_t hi) {
+        for (size_t task = lo; task < hi; task++) {
+            size_t r0 = (task / H) * T, h = task % H, c0 = h * dh;
+            Eigen::MatrixXd q = this->Q_.block(r0, c0, T, dh) * scale;
+            Eigen::MatrixXd k = this->K_.block(r0, c0, T, dh);
+            Eigen::MatrixXd v = this->V_.block(r0, c0, T, dh);
+            Eigen::MatrixXd dout = dO.block(r0, c0, T, dh);
+            Eigen::VectorXd lse = this->LSE_.block(r0, h, T, 1);
+            // D_i = sum_j P_ij dP_ij = dO_i . O_i
+            Eigen::VectorXd D = dout.cwiseProduct(this->O_.block(r0, c0, T, dh)).rowwise().sum();
+            Eigen::MatrixXd dq = Eigen::MatrixXd::Zero(T, dh);
+            Eigen::MatrixXd dk = Eigen::MatrixXd::Zero(T, dh);
+            Eigen::MatrixXd dv = Eigen::MatrixXd::Zero(T, dh);
+
+            for (size_t j0 = 0; j0 < T; j0 += ATTENTION_BLOCK_KV) {
+                size_t bk = std::min(ATTENTION_BLOCK_KV, T - j0);
+                for (size_t i0 = 0; i0 < T; i0 += ATTENTION_BLOCK_Q) {
+                    size_t bq = std::min(ATTENTION_BLOCK_Q, T - i0);
+                    // Recompute the probabilities of this block from the log-sum-exp
+                    Eigen::MatrixXd P = q.middleRows(i0, bq) * k.middleRows(j0, bk).transpose();
+                    P = (P.array().colwise() - lse.segment(i0, bq).array()).exp();
+                    dv.middleRows(j0, bk).noalias() += P.transpose() * dout.middleRows(i0, bq);
+                    Eigen::MatrixXd dS = dout.middleRows(i0, bq) * v.middleRows(j0, bk).transpose();
+                    dS = P.array() * (dS.array().colwise() - D.segment(i0, bq).array());
+                    dq.middleRows(i0, bq).noalias() += dS * k.middleRows(j0, bk);
+                    dk.middleRows(j0, bk).noalias() += dS.transpose() * q.middleRows(i0, bq);
+                }
+            }
+            dQ.block(r0, c0, T, dh) = dq * scale;
+            dK.block(r0, c0, T, dh) = dk;
+            dV.block(r0, c0, T, dh) = dv;
+        }
+    });
+
+    Eigen::MatrixXd dLdA = this->query_.backward(dQ);
+    dLdA += this->key_.backward(dK);
+    dLdA += this->value_.backward(dV);
+    return dLdA;
+}
+
+std::vector<Eigen::MatrixXd*> MultiHeadAttention::cached() {
+    return {&this->Q_, &this->K_, &this->V_, &this->O_, &this->LSE_,
+            &this->query_.A_, &this->key_.A_, &this->value_.A_, &this->output_.A_};
+}
+
+void MultiHeadAttention::swap_cache(Cache& cache) {
+    Layer::swap_cache(cache);
+    std::vector<Eigen::MatrixXd*> mine = this->cached();
+    cache.state.resize(mine.size());
+    for (size_t i = 0; i < mine.size(); i++) {
+        mine[i]->swap(cache.state[i]);
+    }
+    for (Layer* child : this->children()) {
+        child->N_ = this->N_;
+    }
+}
+
+size_t MultiHeadAttention::cache_bytes() const {
+    size_t values = this->Q_.size() + this->K_.size() + this->V_.size() + this->O_.size()
+        + this->LSE_.size() + this->query_.A_.size() + this->key_.A_.size()
+        + this->value_.A_.size() + this->output_.A_.size();
+    return values * sizeof(double);
+}
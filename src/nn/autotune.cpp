@@ -0,0 +1,268 @@
+/**
+ * @file autotune.cpp
+ * @author Krish Suraparaju (csurapar@andrew.cmu.edu)
+ * @brief Provides the implementation of the auto-tuner defined in
+ *        include/nn/autotune.h header.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include "../../include/nn/autotune.h"
+#include "../../include/utils/parallel.h"
+#include "../../include/utils/thread_pool.h"
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <fstream>
+#include <stdexcept>
+#include <thread>
+
+// Every setting runs at least this many timed batches
+static const int TUNE_MIN_REPS = 3;
+
+/**
+ * @brief The stable name of a backend in a profile file.
+ */
+static const char* profile_backend_name(GemmBackend backend) {
+    switch (backend) {
+        case GemmBackend::Cblas: return "cblas";
+        case GemmBackend::Packed: return "packed";
+        default: return "eigen";
+    }
+}
+
+/**
+ * @brief The stable name of a packed micro-kernel in a profile file.
+ */
+static const char* profile_kernel_name(GemmKernel kernel) {
+    switch (kernel) {
+        case GemmKernel::AVX2: return "avx2";
+        case GemmKernel::AVX512: return "avx512";
+        default: return "portable";
+    }
+}
+
+/**
+ * @brief The default thread counts: the powers of two below the number of
+ * cores, and the number of cores.
+ */
+static std::vector<size_t> default_thread_counts() {
+    size_t cores = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<size_t> counts;
+    for (size_t n = 1; n < cores; n *= 2) {
+        counts.push_back(n);
+    }
+    counts.push_back(cores);
+    return counts;
+}
+
+/**
+ * @brief A batch of N rows, repeating the rows of X.
+ */
+static Eigen::MatrixXd tile_rows(const Eigen::MatrixXd& X, size_t N) {
+    Eigen::MatrixXd batch(N, X.cols());
+    for (size_t i = 0; i < N; i += X.rows()) {
+        size_t rows = std::min<size_t>(X.rows(), N - i);
+        batch.middleRows(i, rows) = X.topRows(rows);
+    }
+    return batch;
+}
+
+/**
+ * @brief Times one setting: a warm-up batch, then batches until min_time_ms
+ * have passed.
+ */
+static void measure(Model& model, const Eigen::MatrixXd& X, const Eigen::MatrixXd& Y,
+                    const TuneOptions& options, TuneProfile& profile) {
+    Eigen::MatrixXd Xb = tile_rows(X, profile.batch_size);
+    Eigen::MatrixXd Yb = options.training ? tile_rows(Y, profile.batch_size) : Eigen::MatrixXd();
+    auto run = [&]() {
+        if (options.training) {
+            model.loss_->forward(model.forward(Xb), Yb);
+            model.backward();
+        } else {
+            model.predict(Xb);
+        }
+    };
+
+    run();
+    int reps = 0;
+    double elapsed_ms = 0.0;
+    auto start = std::chrono::steady_clock::now();
+    while (reps < TUNE_MIN_REPS || elapsed_ms < options.min_time_ms) {
+        run();
+        reps++;
+        elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+    profile.latency_ms = elapsed_ms / reps;
+    profile.samples_per_sec = profile.batch_size * reps / (elapsed_ms / 1000.0);
+}
+
+TuneResult autotune(Model& model, const Eigen::MatrixXd& X, const Eigen::MatrixXd& Y,
+                    const TuneOptions& options) {
+    assert(X.rows() > 0 && (!options.training || Y.rows() == X.rows()));
+    std::vector<size_t> thread_counts = options.thread_counts.empty()
+        ? default_thread_counts() : options.thread_counts;
+    std::vector<GemmBackend> backends = options.backends;
+    if (backends.empty()) {
+        for (GemmBackend backend : {GemmBackend::Eigen, GemmBackend::Cblas, GemmBackend::Packed}) {
+            if (gemm_backend_available(backend)) {
+                backends.push_back(backend);
+            }
+        }
+    }
+
+    std::vector<GemmKernel> kernels = options.kernels;
+    if (kernels.empty()) {
+        for (GemmKernel kernel : {GemmKernel::Portable, GemmKernel::AVX2, GemmKernel::AVX512}) {
+            if (gemm_kernel_supported(kernel)) {
+                kernels.push_back(kernel);
+            }
+        }
+    }
+
+    GemmBackend previous_backend = gemm_backend();
+    GemmKernel previous_kernel = gemm_kernel();
+    size_t previous_threads = num_threads();
+    TuneResult result;
+    try {
+        for (GemmBackend backend : backends) {
+            set_gemm_backend(backend);
+            // Only the packed backend has micro-kernels to choose from
+            std::vector<GemmKernel> backend_kernels = backend == GemmBackend::Packed
+                ? kernels : std::vector<GemmKernel>{previous_kernel};
+            for (GemmKernel kernel : backend_kernels) {
+                set_gemm_kernel(kernel);
+                for (size_t threads : thread_counts) {
+                    ThreadPool::configure(threads);
+                    for (size_t batch_size : options.batch_sizes) {
+                        TuneProfile profile;
+                        profile.batch_size = batch_size;
+                        profile.num_threads = threads;
+                        profile.backend = backend;
+                        profile.kernel = kernel;
+                        profile.training = options.training;
+                        measure(model, X, Y, options, profile);
+                        result.measurements.push_back(profile);
+                    }
+                }
+            }
+        }
+    } catch (...) {
+        set_gemm_backend(previous_backend);
+        set_gemm_kernel(previous_kernel);
+        ThreadPool::configure(previous_threads);
+        throw;
+    }
+    set_gemm_backend(previous_backend);
+    set_gemm_kernel(previous_kernel);
+    ThreadPool::configure(previous_threads);
+
+    const TuneProfile* best = nullptr;
+    for (const TuneProfile& profile : result.measurements) {
+        if ((options.max_latency_ms > 0.0 && profile.latency_ms > options.max_latency_ms)
+            || profile.samples_per_sec < options.min_samples_per_sec) {
+            continue;
+        }
+        bool better = best == nullptr
+            || (options.objective == TuneObjective::Throughput
+                ? profile.samples_per_sec > best->samples_per_sec
+                : profile.latency_ms < best->latency_ms);
+        if (better) {
+            best = &profile;
+        }
+    }
+    if (best == nullptr) {
+        throw std::runtime_error("autotune: no setting meets the latency and throughput constraints");
+    }
+    result.best = *best;
+    return result;
+}
+
+void apply_profile(const TuneProfile& profile) {
+    set_gemm_backend(profile.backend);
+    if (profile.backend == GemmBackend::Packed) {
+        set_gemm_kernel(gemm_kernel_supported(profile.kernel) ? profile.kernel : detect_gemm_kernel());
+    }
+    ThreadPool::configure(profile.num_threads);
+}
+
+void save_profile(const std::string& path, const TuneProfile& profile) {
+    std::ofstream file(path);
+    if (!file) {
+        throw std::runtime_error("save_profile: cannot open " + path);
+    }
+    file << "# dnn_cpp tuning profile\n"
+         << "batch_size=" << profile.batch_size << "\n"
+         << "num_threads=" << profile.num_threads << "\n"
+         << "gemm_backend=" << profile_backend_name(profile.backend) << "\n"
+         << "gemm_kernel=" << profile_kernel_name(profile.kernel) << "\n"
+         << "training=" << (profile.training ? 1 : 0) << "\n"
+         << "latency_ms=" << profile.latency_ms << "\n"
+         << "samples_per_sec=" << profile.samples_per_sec << "\n";
+    if (!file) {
+        throw std::runtime_error("save_profile: cannot write " + path);
+    }
+}
+
+TuneProfile load_profile(const std::string& path) {
+    std::ifstream file(path);
+    if (!file) {
+        throw std::runtime_error("load_profile: cannot open " + path);
+    }
+    TuneProfile profile;
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        size_t eq = line.find('=');
+        if (eq == std::string::npos) {
+            throw std::runtime_error("load_profile: malformed line '" + line + "' in " + path);
+        }
+        std::string key = line.substr(0, eq), value = line.substr(eq + 1);
+        try {
+            if (key == "batch_size") {
+                profile.batch_size = std::stoul(value);
+            } else if (key == "num_threads") {
+                profile.num_threads = std::stoul(value);
+            } else if (key == "gemm_backend") {
+                if (value == "eigen") {
+                    profile.backend = GemmBackend::Eigen;
+                } else if (value == "cblas") {
+                    profile.backend = GemmBackend::Cblas;
+                } else if (value == "packed") {
+                    profile.backend = GemmBackend::Packed;
+                } else {
+                    throw std::invalid_argument(value);
+                }
+            } else if (key == "gemm_kernel") {
+                if (value == "portable") {
+                    profile.kernel = GemmKernel::Portable;
+                } else if (value == "avx2") {
+                    profile.kernel = GemmKernel::AVX2;
+                } else if (value == "avx512") {
+                    profile.kernel = GemmKernel::AVX512;
+                } else {
+                    throw std::invalid_argument(value);
+                }
+            } else if (key == "training") {
+                profile.training = std::stoi(value) != 0;
+            } else if (key == "latency_ms") {
+                profile.latency_ms = std::stod(value);
+            } else if (key == "samples_per_sec") {
+                profile.samples_per_sec = std::stod(value);
+            }
+            // Other keys are ignored, so that newer profiles still load
+        } catch (const std::logic_error&) {
+            throw std::runtime_error("load_profile: bad value for " + key + " in " + path);
+        }
+    }
+    if (profile.batch_size == 0 || profile.num_threads == 0) {
+        throw std::runtime_error("load_profile: " + path + " has no batch_size or num_threads");
+    }
+    return profile;
+}
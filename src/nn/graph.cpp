@@ -0,0 +1,375 @@
+/**
+ * @file graph.cpp
+ * @author Krish Suraparaju (csurapar@andrew.cmu.edu)
+ * @brief Provides the implementation of the tape-based autograd engine
+ *        defined in include/nn/graph.h header.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include "../../include/nn/graph.h"
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <map>
+#include <utility>
+
+Graph::Value Graph::push(Node node) {
+#ifndef NDEBUG
+    for (Value x : node.inputs) {
+        assert(x < this->nodes_.size());
+    }
+#endif
+    this->nodes_.push_back(std::move(node));
+    if (!this->has_output_) {
+        this->output_ = this->nodes_.size() - 1;
+    }
+    this->planned_rows_ = 0;
+    return this->nodes_.size() - 1;
+}
+
+Graph::Value Graph::input(size_t cols) {
+    Node node;
+    node.op = OpType::Input;
+    node.cols = cols;
+    node.input_index = this->num_inputs_++;
+    return this->push(std::move(node));
+}
+
+Graph::Value Graph::layer(Layer& layer, Value x) {
+    Node node;
+    node.op = OpType::Layer;
+    node.inputs = {x};
+    node.layer = &layer;
+    // An Embedding produces one vector per input column
+    bool embedding = dynamic_cast<Embedding*>(&layer) != nullptr;
+    node.cols = embedding ? this->nodes_.at(x).cols * layer.out_size_ : layer.out_size_;
+    return this->push(std::move(node));
+}
+
+Graph::Value Graph::activation(ActivationFunction& activation, Value x) {
+    Node node;
+    node.op = OpType::Activation;
+    node.inputs = {x};
+    node.activation = &activation;
+    node.cols = this->nodes_.at(x).cols;
+    return this->push(std::move(node));
+}
+
+Graph::Value Graph::add(Value a, Value b) {
+    assert(this->nodes_.at(a).cols == this->nodes_.at(b).cols);
+    Node node;
+    node.op = OpType::Add;
+    node.inputs = {a, b};
+    node.cols = this->nodes_[a].cols;
+    return this->push(std::move(node));
+}
+
+Graph::Value Graph::concat(Value a, Value b) {
+    Node node;
+    node.op = OpType::Concat;
+    node.inputs = {a, b};
+    node.cols = this->nodes_.at(a).cols + this->nodes_.at(b).cols;
+    return this->push(std::move(node));
+}
+
+void Graph::set_output(Value output) {
+    this->output_ = output;
+    this->has_output_ = true;
+    this->planned_rows_ = 0;
+}
+
+/**
+ * @brief Computes the lifetime of every value and gradient for the given
+ * batch size, and packs them into the arena. Buffers are placed largest first,
+ * each at the lowest offset that does not collide with an already placed
+ * buffer whose lifetime overlaps its own.
+ */
+void Graph::plan(size_t rows) {
+    size_t T = this->nodes_.size();
+    this->values_.assign(T, Buffer());
+    this->gradients_.assign(T, Buffer());
+
+    // Only the operations the output depends on take part in backward
+    std::vector<bool> contributes(T, false);
+    contributes[this->output_] = true;
+    for (size_t i = T; i-- > 0;) {
+        if (contributes[i]) {
+            for (Value x : this->nodes_[i].inputs) {
+                contributes[x] = true;
+            }
+        }
+    }
+
+    std::vector<Buffer*> buffers;
+    for (size_t v = 0; v < T; v++) {
+        const Node& node = this->nodes_[v];
+        size_t size = rows * node.cols;
+
+        // A value lives from its definition to its last consumer, or to the
+        // backward step (2T-1-i) of an operation that keeps a view of it: a
+        // layer keeps its input, an activation its own output
+        Buffer& value = this->values_[v];
+        value.first = v;
+        value.last = v == this->output_ ? T - 1 : v;
+        if (node.op == OpType::Activation && node.activation->keeps_view() && contributes[v]) {
+            value.last = 2 * T - 1 - v;
+        }
+        // A gradient lives from the backward step of its last contributing
+        // consumer to the backward step of its own operation
+        Buffer& gradient = this->gradients_[v];
+        size_t first_backward = v == this->output_ ? T - 1 : v;
+        for (size_t c = v + 1; c < T; c++) {
+            const Node& consumer = this->nodes_[c];
+            if (std::find(consumer.inputs.begin(), consumer.inputs.end(), v) != consumer.inputs.end()) {
+                value.last = std::max(value.last, c);
+                if (contributes[c]) {
+                    first_backward = std::max(first_backward, c);
+                    if (consumer.op == OpType::Layer && consumer.layer->keeps_view()) {
+                        value.last = std::max(value.last, 2 * T - 1 - c);
+                    }
+                }
+            }
+        }
+        value.size = size;
+        buffers.push_back(&value);
+        if (contributes[v] && node.op != OpType::Input) {
+            gradient.first = 2 * T - 1 - first_backward;
+            gradient.last = 2 * T - 1 - v;
+            gradient.size = size;
+            buffers.push_back(&gradient);
+        }
+    }
+
+    std::stable_sort(buffers.begin(), buffers.end(), [](const Buffer* a, const Buffer* b) {
+        return a->size > b->size;
+    });
+    std::vector<Buffer*> placed;
+    size_t arena_size = 0;
+    this->unplanned_bytes_ = 0;
+    for (Buffer* buffer : buffers) {
+        std::vector<std::pair<size_t, size_t>> taken;
+        for (Buffer* other : placed) {
+            if (other->first <= buffer->last && buffer->first <= other->last) {
+                taken.push_back(std::make_pair(other->offset, other->offset + other->size));
+            }
+        }
+        std::sort(taken.begin(), taken.end());
+        size_t offset = 0;
+        for (const std::pair<size_t, size_t>& range : taken) {
+            if (offset + buffer->size <= range.first) {
+                break;
+            }
+            offset = std::max(offset, range.second);
+        }
+        buffer->offset = offset;
+        placed.push_back(buffer);
+        arena_size = std::max(arena_size, offset + buffer->size);
+        this->unplanned_bytes_ += buffer->size * sizeof(double);
+    }
+
+    this->arena_.assign(arena_size, 0.0);
+    this->planned_rows_ = rows;
+}
+
+Eigen::Map<Eigen::MatrixXd> Graph::value(Value v) {
+    return Eigen::Map<Eigen::MatrixXd>(this->arena_.data() + this->values_[v].offset,
+                                       this->planned_rows_, this->nodes_[v].cols);
+}
+
+Eigen::Map<Eigen::MatrixXd> Graph::gradient(Value v) {
+    return Eigen::Map<Eigen::MatrixXd>(this->arena_.data() + this->gradients_[v].offset,
+                                       this->planned_rows_, this->nodes_[v].cols);
+}
+
+Eigen::Map<const Eigen::MatrixXd> Graph::view(Value v) const {
+    return Eigen::Map<const Eigen::MatrixXd>(this->arena_.data() + this->values_[v].offset,
+                                             this->planned_rows_, this->nodes_[v].cols);
+}
+
+size_t Graph::cache_bytes() const {
+    size_t bytes = 0;
+    for (const Node& node : this->nodes_) {
+        bytes += node.layer_cache.A.size() * sizeof(double)
+            + node.layer_cache.A_half.size() * sizeof(uint16_t)
+            + node.activation_cache.A.size() * sizeof(double);
+        for (const Eigen::MatrixXd& state : node.layer_cache.state) {
+            bytes += state.size() * sizeof(double);
+        }
+    }
+    return bytes;
+}
+
+Eigen::MatrixXd Graph::forward(const std::vector<Eigen::MatrixXd>& inputs) {
+    assert(inputs.size() == this->num_inputs_ && !inputs.empty());
+    size_t rows = inputs[0].rows();
+    if (rows != this->planned_rows_) {
+        this->plan(rows);
+    }
+
+    for (size_t i = 0; i < this->nodes_.size(); i++) {
+        Node& node = this->nodes_[i];
+        switch (node.op) {
+        case OpType::Input: {
+            const Eigen::MatrixXd& input = inputs[node.input_index];
+            assert(static_cast<size_t>(input.rows()) == rows);
+            this->value(i) = input;
+            break;
+        }
+        case OpType::Layer: {
+            // Start from an empty cache, so that no stale state is swapped in
+            node.layer_cache = Layer::Cache();
+            this->value(i) = node.layer->forward_view(this->view(node.inputs[0]));
+            node.layer->swap_cache(node.layer_cache);
+            break;
+        }
+        case OpType::Activation: {
+            node.activation_cache = ActivationFunction::Cache();
+            node.activation->forward_view(this->view(node.inputs[0]), this->value(i));
+            node.activation->swap_cache(node.activation_cache);
+            break;
+        }
+        case OpType::Add:
+            this->value(i) = this->view(node.inputs[0]) + this->view(node.inputs[1]);
+            break;
+        case OpType::Concat: {
+            size_t left = this->nodes_[node.inputs[0]].cols;
+            this->value(i).leftCols(left) = this->view(node.inputs[0]);
+            this->value(i).rightCols(node.cols - left) = this->view(node.inputs[1]);
+            break;
+        }
+        }
+    }
+    return Eigen::MatrixXd(this->view(this->output_));
+}
+
+void Graph::accumulate(Value v, const Eigen::MatrixXd& gradient, std::vector<bool>& ready) {
+    if (this->nodes_[v].op == OpType::Input) {
+        return;
+    }
+    if (ready[v]) {
+        this->gradient(v) += gradient;
+    } else {
+        this->gradient(v) = gradient;
+        ready[v] = true;
+    }
+}
+
+/**
+ * @brief Adds the sparse gradient of one use of an Embedding to the sum of the
+ * previous uses. Both index lists are sorted, and so is the merged one.
+ */
+static void merge_sparse(std::pair<std::vector<Eigen::Index>, Eigen::MatrixXd>& sum,
+                         const std::vector<Eigen::Index>& indices, const Eigen::MatrixXd& values) {
+    const std::vector<Eigen::Index>& left = sum.first;
+    const Eigen::MatrixXd& left_values = sum.second;
+    std::vector<Eigen::Index> merged;
+    Eigen::MatrixXd merged_values(values.rows(), left.size() + indices.size());
+    size_t i = 0, j = 0;
+    while (i < left.size() || j < indices.size()) {
+        size_t s = merged.size();
+        if (j == indices.size() || (i < left.size() && left[i] < indices[j])) {
+            merged.push_back(left[i]);
+            merged_values.col(s) = left_values.col(i++);
+        } else if (i == left.size() || indices[j] < left[i]) {
+            merged.push_back(indices[j]);
+            merged_values.col(s) = values.col(j++);
+        } else {
+            merged.push_back(left[i]);
+            merged_values.col(s) = left_values.col(i++) + values.col(j++);
+        }
+    }
+    sum.first = std::move(merged);
+    sum.second = merged_values.leftCols(sum.first.size());
+}
+
+void Graph::backward(const Eigen::MatrixXd& dLdY) {
+    std::vector<bool> ready(this->nodes_.size(), false);
+    this->accumulate(this->output_, dLdY, ready);
+
+    // Layers applied more than once sum the gradients of all their uses
+    std::map<Layer*, size_t> uses;
+    for (const Node& node : this->nodes_) {
+        if (node.op == OpType::Layer) {
+            uses[node.layer]++;
+        }
+    }
+    std::map<Layer*, std::pair<Eigen::MatrixXd, Eigen::MatrixXd>> sums;
+    // Embeddings keep their gradient as (index, column) pairs instead
+    std::map<Embedding*, std::pair<std::vector<Eigen::Index>, Eigen::MatrixXd>> sparse_sums;
+
+    for (size_t i = this->nodes_.size(); i-- > 0;) {
+        Node& node = this->nodes_[i];
+        if (!ready[i]) {
+            continue;
+        }
+        switch (node.op) {
+        case OpType::Input:
+            break;
+        case OpType::Layer: {
+            Layer& layer = *node.layer;
+            layer.swap_cache(node.layer_cache);
+            Eigen::MatrixXd dLdX = layer.backward(Eigen::MatrixXd(this->gradient(i)));
+            Layer::Cache released;
+            layer.swap_cache(released);
+            Embedding* embedding = dynamic_cast<Embedding*>(&layer);
+            if (uses[&layer] > 1 && embedding != nullptr) {
+                auto found = sparse_sums.find(embedding);
+                if (found == sparse_sums.end()) {
+                    sparse_sums[embedding] = std::make_pair(embedding->sparse_indices_,
+                                                            embedding->sparse_values_);
+                } else {
+                    merge_sparse(found->second, embedding->sparse_indices_, embedding->sparse_values_);
+                }
+            } else if (uses[&layer] > 1) {
+                auto found = sums.find(&layer);
+                if (found == sums.end()) {
+                    sums[&layer] = std::make_pair(layer.dLdW_, layer.dLdb_);
+                } else {
+                    found->second.first += layer.dLdW_;
+                    found->second.second += layer.dLdb_;
+                }
+            }
+            this->accumulate(node.inputs[0], dLdX, ready);
+            break;
+        }
+        case OpType::Activation: {
+            node.activation->swap_cache(node.activation_cache);
+            Eigen::MatrixXd dLdX = node.activation->backward(Eigen::MatrixXd(this->gradient(i)));
+            ActivationFunction::Cache released;
+            node.activation->swap_cache(released);
+            this->accumulate(node.inputs[0], dLdX, ready);
+            break;
+        }
+        case OpType::Add: {
+            Eigen::MatrixXd dLdX = this->gradient(i);
+            this->accumulate(node.inputs[0], dLdX, ready);
+            this->accumulate(node.inputs[1], dLdX, ready);
+            break;
+        }
+        case OpType::Concat: {
+            size_t left = this->nodes_[node.inputs[0]].cols;
+            Eigen::MatrixXd dLdX = this->gradient(i);
+            this->accumulate(node.inputs[0], dLdX.leftCols(left), ready);
+            this->accumulate(node.inputs[1], dLdX.rightCols(node.cols - left), ready);
+            break;
+        }
+        }
+    }
+
+    for (auto& sum : sums) {
+        sum.first->dLdW_ = std::move(sum.second.first);
+        sum.first->dLdb_ = std::move(sum.second.second);
+    }
+    for (auto& sum : sparse_sums) {
+        sum.first->sparse_indices_ = std::move(sum.second.first);
+        sum.first->sparse_values_ = std::move(sum.second.second);
+    }
+}
+
+void Graph::backward(LossFunction& loss) {
+    this->backward(loss.backward());
+}
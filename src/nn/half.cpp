@@ -0,0 +1,251 @@
+/**
+ * @file half.cpp
+ * @author Krish Suraparaju (csurapar@andrew.cmu.edu)
+ * @brief Provides the 16-bit conversions and the mixed precision GEMM
+ *        kernels defined in include/nn/half.h header.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include "../../include/nn/half.h"
+#include "../../include/utils/parallel.h"
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define DNN_HALF_X86 1
+#include <immintrin.h>
+#endif
+
+// Below this many multiply-adds, the kernels run on a single thread
+static const size_t HALF_GEMM_PARALLEL_GRAIN = 1 << 16;
+
+// Number of samples that share one widened chunk of a weight row
+static const size_t HALF_GEMM_SAMPLE_BLOCK = 4;
+
+static inline uint32_t float_bits(float x) {
+    uint32_t u;
+    std::memcpy(&u, &x, sizeof(u));
+    return u;
+}
+
+static inline float bits_float(uint32_t u) {
+    float x;
+    std::memcpy(&x, &u, sizeof(x));
+    return x;
+}
+
+uint16_t float_to_half(float x, HalfFormat format) {
+    uint32_t u = float_bits(x);
+    if (format == HalfFormat::BFloat16) {
+        if ((u & 0x7fffffffu) > 0x7f800000u) {
+            return static_cast<uint16_t>((u >> 16) | 0x0040u);  // Keep NaNs quiet
+        }
+        u += 0x7fffu + ((u >> 16) & 1u);
+        return static_cast<uint16_t>(u >> 16);
+    }
+
+    uint32_t sign = u & 0x80000000u;
+    u ^= sign;
+    uint32_t h;
+    if (u >= 0x47800000u) {
+        // Infinity, NaN, or too large for float16
+        h = u > 0x7f800000u ? 0x7e00u : 0x7c00u;
+    } else if (u < 0x38800000u) {
+        // Subnormal or zero: let the float adder do the rounding, by aligning
+        // the 10 mantissa bits at the bottom of a float with a magic constant
+        const uint32_t magic = 126u << 23;
+        h = float_bits(bits_float(u) + bits_float(magic)) - magic;
+    } else {
+        uint32_t mantissa_odd = (u >> 13) & 1u;
+        u += (static_cast<uint32_t>(15 - 127) << 23) + 0xfffu + mantissa_odd;
+        h = u >> 13;
+    }
+    return static_cast<uint16_t>(h | (sign >> 16));
+}
+
+float half_to_float(uint16_t h, HalfFormat format) {
+    if (format == HalfFormat::BFloat16) {
+        return bits_float(static_cast<uint32_t>(h) << 16);
+    }
+
+    uint32_t sign = static_cast<uint32_t>(h & 0x8000u) << 16;
+    uint32_t exponent = (h >> 10) & 0x1fu;
+    uint32_t mantissa = h & 0x3ffu;
+    if (exponent == 0) {
+        // Zero or subnormal: mantissa * 2^-24
+        float value = static_cast<float>(mantissa) * 5.9604644775390625e-8f;
+        return bits_float(float_bits(value) | sign);
+    }
+    if (exponent == 31) {
+        return bits_float(sign | 0x7f800000u | (mantissa << 13));
+    }
+    return bits_float(sign | ((exponent + 112) << 23) | (mantissa << 13));
+}
+
+HalfIsa detect_half_isa() {
+#ifdef DNN_HALF_X86
+    static const HalfIsa isa = []() {
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f")) {
+            return HalfIsa::AVX512;
+        }
+        if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")
+            && __builtin_cpu_supports("f16c")) {
+            return HalfIsa::AVX2;
+        }
+        return HalfIsa::Portable;
+    }();
+    return isa;
+#else
+    return HalfIsa::Portable;
+#endif
+}
+
+/**
+ * @brief Portable kernel: widens each weight row once, then takes plain
+ * float dot products with every sample.
+ */
+static void half_gemm_portable(const float* A, const uint16_t* W, const float* b, float* Z,
+                               size_t N, size_t K, size_t lo, size_t hi, size_t M,
+                               HalfFormat format) {
+    std::vector<float> w(K);
+    for (size_t o = lo; o < hi; o++) {
+        for (size_t k = 0; k < K; k++) {
+            w[k] = half_to_float(W[o * K + k], format);
+        }
+        float bias = b != nullptr ? b[o] : 0.0f;
+        for (size_t n = 0; n < N; n++) {
+            const float* a = A + n * K;
+            float acc = 0.0f;
+            for (size_t k = 0; k < K; k++) {
+                acc += w[k] * a[k];
+            }
+            Z[n * M + o] = acc + bias;
+        }
+    }
+}
+
+#ifdef DNN_HALF_X86
+
+__attribute__((target("avx2,fma,f16c")))
+static inline __m256 widen8(const uint16_t* w, HalfFormat format) {
+    __m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i*>(w));
+    if (format == HalfFormat::BFloat16) {
+        return _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_cvtepu16_epi32(h), 16));
+    }
+    return _mm256_cvtph_ps(h);
+}
+
+__attribute__((target("avx2,fma,f16c")))
+static inline float hsum8(__m256 v) {
+    __m128 sum = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    __m128 shuf = _mm_movehdup_ps(sum);
+    sum = _mm_add_ps(sum, shuf);
+    shuf = _mm_movehl_ps(shuf, sum);
+    return _mm_cvtss_f32(_mm_add_ss(sum, shuf));
+}
+
+/**
+ * @brief AVX2 kernel: every 8-wide chunk of a weight row is widened once and
+ * multiplied into the accumulators of up to HALF_GEMM_SAMPLE_BLOCK samples.
+ */
+__attribute__((target("avx2,fma,f16c")))
+static void half_gemm_avx2(const float* A, const uint16_t* W, const float* b, float* Z,
+                           size_t N, size_t K, size_t lo, size_t hi, size_t M,
+                           HalfFormat format) {
+    size_t K8 = K - K % 8;
+    for (size_t o = lo; o < hi; o++) {
+        const uint16_t* w = W + o * K;
+        float bias = b != nullptr ? b[o] : 0.0f;
+        for (size_t n0 = 0; n0 < N; n0 += HALF_GEMM_SAMPLE_BLOCK) {
+            size_t nb = std::min(HALF_GEMM_SAMPLE_BLOCK, N - n0);
+            __m256 acc[HALF_GEMM_SAMPLE_BLOCK];
+            for (size_t j = 0; j < nb; j++) {
+                acc[j] = _mm256_setzero_ps();
+            }
+            for (size_t k = 0; k < K8; k += 8) {
+                __m256 wk = widen8(w + k, format);
+                for (size_t j = 0; j < nb; j++) {
+                    acc[j] = _mm256_fmadd_ps(wk, _mm256_loadu_ps(A + (n0 + j) * K + k), acc[j]);
+                }
+            }
+            for (size_t j = 0; j < nb; j++) {
+                float sum = hsum8(acc[j]);
+                for (size_t k = K8; k < K; k++) {
+                    sum += half_to_float(w[k], format) * A[(n0 + j) * K + k];
+                }
+                Z[(n0 + j) * M + o] = sum + bias;
+            }
+        }
+    }
+}
+
+__attribute__((target("avx512f")))
+static inline __m512 widen16(const uint16_t* w, HalfFormat format) {
+    __m256i h = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(w));
+    if (format == HalfFormat::BFloat16) {
+        return _mm512_castsi512_ps(_mm512_slli_epi32(_mm512_cvtepu16_epi32(h), 16));
+    }
+    return _mm512_cvtph_ps(h);
+}
+
+/**
+ * @brief AVX-512 kernel, same blocking as the AVX2 kernel with 16 lanes.
+ */
+__attribute__((target("avx512f")))
+static void half_gemm_avx512(const float* A, const uint16_t* W, const float* b, float* Z,
+                             size_t N, size_t K, size_t lo, size_t hi, size_t M,
+                             HalfFormat format) {
+    size_t K16 = K - K % 16;
+    for (size_t o = lo; o < hi; o++) {
+        const uint16_t* w = W + o * K;
+        float bias = b != nullptr ? b[o] : 0.0f;
+        for (size_t n0 = 0; n0 < N; n0 += HALF_GEMM_SAMPLE_BLOCK) {
+            size_t nb = std::min(HALF_GEMM_SAMPLE_BLOCK, N - n0);
+            __m512 acc[HALF_GEMM_SAMPLE_BLOCK];
+            for (size_t j = 0; j < nb; j++) {
+                acc[j] = _mm512_setzero_ps();
+            }
+            for (size_t k = 0; k < K16; k += 16) {
+                __m512 wk = widen16(w + k, format);
+                for (size_t j = 0; j < nb; j++) {
+                    acc[j] = _mm512_fmadd_ps(wk, _mm512_loadu_ps(A + (n0 + j) * K + k), acc[j]);
+                }
+            }
+            for (size_t j = 0; j < nb; j++) {
+                float sum = _mm512_reduce_add_ps(acc[j]);
+                for (size_t k = K16; k < K; k++) {
+                    sum += half_to_float(w[k], format) * A[(n0 + j) * K + k];
+                }
+                Z[(n0 + j) * M + o] = sum + bias;
+            }
+        }
+    }
+}
+
+#endif // DNN_HALF_X86
+
+void half_gemm(const float* A, const uint16_t* W, const float* b, float* Z,
+               size_t N, size_t K, size_t M, HalfFormat format, HalfIsa isa) {
+    size_t grain = std::max<size_t>(1, HALF_GEMM_PARALLEL_GRAIN / std::max<size_t>(N * K, 1));
+    parallel_for(0, M, grain, [&](size_t lo, size_t hi) {
+        switch (isa) {
+#ifdef DNN_HALF_X86
+        case HalfIsa::AVX512:
+            half_gemm_avx512(A, W, b, Z, N, K, lo, hi, M, format);
+            break;
+        case HalfIsa::AVX2:
+            half_gemm_avx2(A, W, b, Z, N, K, lo, hi, M, format);
+            break;
+#endif
+        default:
+            half_gemm_portable(A, W, b, Z, N, K, lo, hi, M, format);
+            break;
+        }
+    });
+}
@@ -11,25 +11,486 @@
  */
 
 #include "../../include/nn/layer.h"
+#include "../../include/utils/gemm.h"
+#include "../../include/utils/parallel.h"
 #include <Eigen/Dense>
+#include <algorithm>
+#include <cassert>
 #include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <utility>
 
-Eigen::MatrixXd Linear::forward(const Eigen::MatrixXd& A) {
+// Below this many elements, the bias broadcast and sum run on a single thread
+static const size_t BIAS_PARALLEL_GRAIN = 1 << 15;
+
+// Below this many copied values, lookups run on a single thread
+static const size_t EMBEDDING_PARALLEL_GRAIN = 1 << 14;
+
+// Below this many multiply-adds, sparse products run on a single thread
+static const size_t SPARSE_PARALLEL_GRAIN = 1 << 16;
+
+typedef Eigen::Map<const Eigen::MatrixXd> ConstMap;
+
+static ConstMap as_map(const Eigen::MatrixXd& A) {
+    return ConstMap(A.data(), A.rows(), A.cols());
+}
+
+std::unique_ptr<Layer> Layer::clone() const {
+    throw std::runtime_error("Layer::clone: this layer type does not support snapshots");
+}
+
+// Serializes the default Layer::predict, which borrows the layer's forward
+static std::mutex default_predict_mutex;
+
+Eigen::MatrixXd Layer::predict(const Eigen::MatrixXd& A) const {
+    std::lock_guard<std::mutex> lock(default_predict_mutex);
+    Layer& layer = const_cast<Layer&>(*this);
+    Cache saved;
+    layer.swap_cache(saved);
+    Eigen::MatrixXd Z;
+    try {
+        Z = layer.forward(A);
+    } catch (...) {
+        layer.swap_cache(saved);
+        throw;
+    }
+    layer.swap_cache(saved);
+    return Z;
+}
+
+/**
+ * @brief Keeps a view of A in place of a cached copy (see Layer::forward_view).
+ */
+static void keep_view(Layer& layer, ConstMap A) {
+    layer.A_.resize(0, 0);
+    layer.A_view_ = A.data();
+    layer.A_view_cols_ = A.cols();
+    layer.N_ = A.rows();
+}
+
+/**
+ * @brief Caches a copy of A for backward.
+ */
+static void keep_copy(Layer& layer, const Eigen::MatrixXd& A) {
+    layer.A_ = A;
+    layer.A_view_ = nullptr;
+    layer.N_ = A.rows();
+}
+
+/**
+ * @brief Z = A * W^T + ι_N * b^T: starts from the broadcast bias, then accumulates.
+ */
+static Eigen::MatrixXd linear_predict(const Linear& layer, ConstMap A) {
     size_t N = A.rows();
-    this->A_ = A;
-    this->N_ = A.rows();
-    Eigen::MatrixXd one = Eigen::MatrixXd::Ones(this->N_, 1);
-    Eigen::MatrixXd W = this->W_;
-    Eigen::MatrixXd b = this->b_;
-    Eigen::MatrixXd Z = A * W.transpose() + one * b.transpose();
+    Eigen::MatrixXd Z(N, layer.out_size_);
+    size_t grain = std::max<size_t>(1, BIAS_PARALLEL_GRAIN / std::max<size_t>(N, 1));
+    parallel_for(0, layer.out_size_, grain, [&](size_t lo, size_t hi) {
+        for (size_t j = lo; j < hi; j++) {
+            Z.col(j).setConstant(layer.b_(j));
+        }
+    });
+    gemm(false, true, N, layer.out_size_, layer.in_size_,
+         1.0, A.data(), A.rows(), layer.W_.data(), layer.W_.rows(),
+         1.0, Z.data(), Z.rows());
     return Z;
 }
 
+Eigen::MatrixXd Linear::forward(const Eigen::MatrixXd& A) {
+    keep_copy(*this, A);
+    return linear_predict(*this, as_map(A));
+}
+
+Eigen::MatrixXd Linear::forward_view(ConstMap A) {
+    keep_view(*this, A);
+    return linear_predict(*this, A);
+}
+
+Eigen::MatrixXd Linear::predict(const Eigen::MatrixXd& A) const {
+    return linear_predict(*this, as_map(A));
+}
+
 Eigen::MatrixXd Linear::backward(const Eigen::MatrixXd& dLdZ) {
-    Eigen::MatrixXd dLdA = dLdZ * this->W_;
+    Eigen::MatrixXd dLdA(this->N_, this->in_size_);
+    gemm(false, false, this->N_, this->in_size_, this->out_size_,
+         1.0, dLdZ.data(), dLdZ.rows(), this->W_.data(), this->W_.rows(),
+         0.0, dLdA.data(), dLdA.rows());
+    ConstMap A = this->cached_input();
+    this->dLdW_.resize(this->out_size_, this->in_size_);
+    gemm(true, false, this->out_size_, this->in_size_, this->N_,
+         1.0, dLdZ.data(), dLdZ.rows(), A.data(), A.rows(),
+         0.0, this->dLdW_.data(), this->dLdW_.rows());
+    this->dLdb_.resize(this->out_size_, 1);
+    size_t grain = std::max<size_t>(1, BIAS_PARALLEL_GRAIN / std::max<size_t>(this->N_, 1));
+    parallel_for(0, this->out_size_, grain, [&](size_t lo, size_t hi) {
+        for (size_t j = lo; j < hi; j++) {
+            this->dLdb_(j) = dLdZ.col(j).sum();
+        }
+    });
+    return dLdA;
+}
+
+
+static Eigen::MatrixXd embedding_predict(const Embedding& layer, ConstMap A) {
+    size_t N = A.rows();
+    size_t F = A.cols();
+    size_t D = layer.out_size_;
+    // The indices come from the input data, so they are checked in release
+    // builds too (NaN fails both comparisons)
+    double limit = static_cast<double>(layer.in_size_);
+    for (Eigen::Index k = 0; k < A.size(); k++) {
+        double index = A.data()[k];
+        if (!(index >= 0 && index < limit)) {
+            throw std::out_of_range("Embedding: index " + std::to_string(index)
+                                    + " is outside the table of " + std::to_string(layer.in_size_)
+                                    + " entries");
+        }
+    }
+
+    Eigen::MatrixXd Z(N, F * D);
+    size_t grain = std::max<size_t>(1, EMBEDDING_PARALLEL_GRAIN / std::max<size_t>(F * D, 1));
+    parallel_for(0, N, grain, [&](size_t lo, size_t hi) {
+        for (size_t n = lo; n < hi; n++) {
+            for (size_t f = 0; f < F; f++) {
+                Eigen::Index idx = static_cast<Eigen::Index>(A(n, f));
+                Z.block(n, f * D, 1, D) = layer.W_.col(idx).transpose();
+            }
+        }
+    });
+    return Z;
+}
+
+// The indices are only cached once embedding_predict has checked them
+Eigen::MatrixXd Embedding::forward(const Eigen::MatrixXd& A) {
+    Eigen::MatrixXd Z = embedding_predict(*this, as_map(A));
+    keep_copy(*this, A);
+    return Z;
+}
+
+Eigen::MatrixXd Embedding::forward_view(ConstMap A) {
+    Eigen::MatrixXd Z = embedding_predict(*this, A);
+    keep_view(*this, A);
+    return Z;
+}
+
+Eigen::MatrixXd Embedding::predict(const Eigen::MatrixXd& A) const {
+    return embedding_predict(*this, as_map(A));
+}
+
+Eigen::MatrixXd Embedding::backward(const Eigen::MatrixXd& dLdZ) {
+    ConstMap A = this->cached_input();
+    size_t F = A.cols();
+    size_t D = this->out_size_;
+    size_t M = A.size();
+
+    // Sort the lookups by index so that repeated indices form contiguous runs.
+    // Lookup k is field k % F of sample k / F.
+    std::vector<std::pair<Eigen::Index, size_t>> order(M);
+    for (size_t k = 0; k < M; k++) {
+        order[k] = std::make_pair(static_cast<Eigen::Index>(A(k / F, k % F)), k);
+    }
+    std::sort(order.begin(), order.end());
+
+    std::vector<size_t> run_starts;
+    this->sparse_indices_.clear();
+    for (size_t k = 0; k < M; k++) {
+        if (k == 0 || order[k].first != order[k - 1].first) {
+            run_starts.push_back(k);
+            this->sparse_indices_.push_back(order[k].first);
+        }
+    }
+    run_starts.push_back(M);
+
+    // Every run owns its own column, so runs can be summed in parallel
+    size_t nnz = this->sparse_indices_.size();
+    this->sparse_values_ = Eigen::MatrixXd::Zero(D, nnz);
+    size_t grain = std::max<size_t>(1, EMBEDDING_PARALLEL_GRAIN / std::max<size_t>(D, 1));
+    parallel_for(0, nnz, grain, [&](size_t lo, size_t hi) {
+        for (size_t s = lo; s < hi; s++) {
+            for (size_t k = run_starts[s]; k < run_starts[s + 1]; k++) {
+                size_t pos = order[k].second;
+                this->sparse_values_.col(s) += dLdZ.block(pos / F, (pos % F) * D, 1, D).transpose();
+            }
+        }
+    });
+
+    return Eigen::MatrixXd::Zero(this->N_, F);
+}
+
+SparseLinear::SparseLinear(const Linear& linear)
+    : Layer(linear.in_size_, linear.out_size_) {
+    this->b_ = linear.b_;
+    this->set_weights(linear.W_);
+    this->W_ = Eigen::MatrixXd(0, 0);
+}
+
+void SparseLinear::set_weights(const Eigen::MatrixXd& W) {
+    this->row_ptr_.clear();
+    this->col_idx_.clear();
+    this->values_.clear();
+    this->row_ptr_.reserve(this->out_size_ + 1);
+    this->row_ptr_.push_back(0);
+    for (size_t o = 0; o < this->out_size_; o++) {
+        for (size_t k = 0; k < this->in_size_; k++) {
+            double w = W(o, k);
+            if (w != 0.0) {
+                this->col_idx_.push_back(k);
+                this->values_.push_back(w);
+            }
+        }
+        this->row_ptr_.push_back(this->values_.size());
+    }
+}
+
+static Eigen::MatrixXd sparse_predict(const SparseLinear& layer, ConstMap A) {
+    size_t N = A.rows();
+    Eigen::MatrixXd Z(N, layer.out_size_);
+    size_t avg_row_nnz = std::max<size_t>(1, layer.nnz() / std::max<size_t>(layer.out_size_, 1));
+    size_t grain = std::max<size_t>(1, SPARSE_PARALLEL_GRAIN / (avg_row_nnz * std::max<size_t>(N, 1)));
+    parallel_for(0, layer.out_size_, grain, [&](size_t lo, size_t hi) {
+        for (size_t o = lo; o < hi; o++) {
+            Z.col(o).setConstant(layer.b_(o, 0));
+            for (Eigen::Index k = layer.row_ptr_[o]; k < layer.row_ptr_[o + 1]; k++) {
+                Z.col(o) += layer.values_[k] * A.col(layer.col_idx_[k]);
+            }
+        }
+    });
+    return Z;
+}
+
+Eigen::MatrixXd SparseLinear::forward(const Eigen::MatrixXd& A) {
+    this->N_ = A.rows();
+    return sparse_predict(*this, as_map(A));
+}
+
+Eigen::MatrixXd SparseLinear::forward_view(ConstMap A) {
+    this->N_ = A.rows();
+    return sparse_predict(*this, A);
+}
+
+Eigen::MatrixXd SparseLinear::predict(const Eigen::MatrixXd& A) const {
+    return sparse_predict(*this, as_map(A));
+}
+
+Eigen::MatrixXd SparseLinear::backward(const Eigen::MatrixXd& dLdZ) {
+    // Scatters into the columns of dLdA, so this runs on a single thread
+    Eigen::MatrixXd dLdA = Eigen::MatrixXd::Zero(dLdZ.rows(), this->in_size_);
+    for (size_t o = 0; o < this->out_size_; o++) {
+        for (Eigen::Index k = this->row_ptr_[o]; k < this->row_ptr_[o + 1]; k++) {
+            dLdA.col(this->col_idx_[k]) += this->values_[k] * dLdZ.col(o);
+        }
+    }
+    return dLdA;
+}
+
+Eigen::MatrixXd SparseLinear::dense() const {
+    Eigen::MatrixXd W = Eigen::MatrixXd::Zero(this->out_size_, this->in_size_);
+    for (size_t o = 0; o < this->out_size_; o++) {
+        for (Eigen::Index k = this->row_ptr_[o]; k < this->row_ptr_[o + 1]; k++) {
+            W(o, this->col_idx_[k]) = this->values_[k];
+        }
+    }
+    return W;
+}
+
+HalfLinear::HalfLinear(const Linear& linear, HalfFormat format, bool half_activations)
+    : Layer(linear.in_size_, linear.out_size_), format_(format),
+      half_activations_(half_activations) {
+    this->b_ = linear.b_;
+    this->set_weights(linear.W_);
+    this->W_ = Eigen::MatrixXd(0, 0);
+}
+
+void HalfLinear::set_weights(const Eigen::MatrixXd& W) {
+    size_t K = this->in_size_;
+    this->W_half_.resize(this->out_size_ * K);
+    for (size_t o = 0; o < this->out_size_; o++) {
+        for (size_t k = 0; k < K; k++) {
+            this->W_half_[o * K + k] = float_to_half(static_cast<float>(W(o, k)), this->format_);
+        }
+    }
+}
+
+Eigen::MatrixXd HalfLinear::dense() const {
+    size_t K = this->in_size_;
+    Eigen::MatrixXd W(this->out_size_, K);
+    for (size_t o = 0; o < this->out_size_; o++) {
+        for (size_t k = 0; k < K; k++) {
+            W(o, k) = half_to_float(this->W_half_[o * K + k], this->format_);
+        }
+    }
+    return W;
+}
+
+static Eigen::MatrixXd half_predict(const HalfLinear& layer, ConstMap A) {
+    typedef Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> RowMatrixXf;
+    size_t N = A.rows();
+    size_t K = layer.in_size_;
+    RowMatrixXf A_f = A.cast<float>();
+    Eigen::VectorXf b_f = layer.b_.col(0).cast<float>();
+    RowMatrixXf Z_f(N, layer.out_size_);
+    half_gemm(A_f.data(), layer.W_half_.data(), b_f.data(), Z_f.data(),
+              N, K, layer.out_size_, layer.format_);
+    return Z_f.cast<double>();
+}
+
+/**
+ * @brief Rounds the input into the 16-bit cache of the layer.
+ */
+static void keep_half(HalfLinear& layer, ConstMap A) {
+    size_t N = A.rows();
+    size_t K = layer.in_size_;
+    layer.N_ = N;
+    layer.A_half_.resize(N * K);
+    for (size_t n = 0; n < N; n++) {
+        for (size_t k = 0; k < K; k++) {
+            layer.A_half_[n * K + k] = float_to_half(static_cast<float>(A(n, k)), layer.format_);
+        }
+    }
+    layer.A_ = Eigen::MatrixXd(0, 0);
+    layer.A_view_ = nullptr;
+}
+
+Eigen::MatrixXd HalfLinear::forward(const Eigen::MatrixXd& A) {
+    if (this->half_activations_) {
+        keep_half(*this, as_map(A));
+    } else {
+        keep_copy(*this, A);
+    }
+    return half_predict(*this, as_map(A));
+}
+
+Eigen::MatrixXd HalfLinear::forward_view(ConstMap A) {
+    if (this->half_activations_) {
+        keep_half(*this, A);
+    } else {
+        keep_view(*this, A);
+    }
+    return half_predict(*this, A);
+}
+
+Eigen::MatrixXd HalfLinear::predict(const Eigen::MatrixXd& A) const {
+    return half_predict(*this, as_map(A));
+}
+
+Eigen::MatrixXd HalfLinear::backward(const Eigen::MatrixXd& dLdZ) {
+    Eigen::MatrixXd W = this->dense();
+    Eigen::MatrixXd A = this->cached_input();
+    if (this->half_activations_) {
+        size_t K = this->in_size_;
+        A.resize(this->N_, K);
+        for (size_t n = 0; n < this->N_; n++) {
+            for (size_t k = 0; k < K; k++) {
+                A(n, k) = half_to_float(this->A_half_[n * K + k], this->format_);
+            }
+        }
+    }
     Eigen::MatrixXd one = Eigen::MatrixXd::Ones(this->N_, 1);
-    this->dLdW_ = dLdZ.transpose() * this->A_;
+    this->dLdW_ = dLdZ.transpose() * A;
     this->dLdb_ = dLdZ.transpose() * one;
+    return dLdZ * W;
+}
+
+
+// Below this many multiply-adds, the GEMMs of the stacked models run one after
+// the other on a single thread
+static const size_t STACKED_PARALLEL_GRAIN = 1 << 15;
+
+static Eigen::MatrixXd stacked_predict(const StackedLinear& layer, ConstMap A) {
+    size_t N = A.rows(), K = layer.num_models_, in = layer.in_size_, out = layer.out_size_;
+    bool shared = static_cast<size_t>(A.cols()) == in;
+    assert(shared || static_cast<size_t>(A.cols()) == K * in);
+
+    Eigen::MatrixXd Z(N, K * out);
+    size_t grain = std::max<size_t>(1, BIAS_PARALLEL_GRAIN / std::max<size_t>(N, 1));
+    parallel_for(0, K * out, grain, [&](size_t lo, size_t hi) {
+        for (size_t j = lo; j < hi; j++) {
+            Z.col(j).setConstant(layer.b_(j));
+        }
+    });
+    if (shared) {
+        // Every model sees the same input: Z = A * W^T covers all of them at once
+        gemm(false, true, N, K * out, in,
+             1.0, A.data(), A.rows(), layer.W_.data(), layer.W_.rows(),
+             1.0, Z.data(), Z.rows());
+        return Z;
+    }
+    size_t models_grain = std::max<size_t>(1, STACKED_PARALLEL_GRAIN / std::max<size_t>(N * in * out, 1));
+    parallel_for(0, K, models_grain, [&](size_t lo, size_t hi) {
+        for (size_t k = lo; k < hi; k++) {
+            gemm(false, true, N, out, in,
+                 1.0, A.data() + k * in * N, A.rows(), layer.W_.data() + k * out, layer.W_.rows(),
+                 1.0, Z.data() + k * out * N, Z.rows());
+        }
+    });
+    return Z;
+}
+
+Eigen::MatrixXd StackedLinear::forward(const Eigen::MatrixXd& A) {
+    keep_copy(*this, A);
+    return stacked_predict(*this, as_map(A));
+}
+
+Eigen::MatrixXd StackedLinear::forward_view(ConstMap A) {
+    keep_view(*this, A);
+    return stacked_predict(*this, A);
+}
+
+Eigen::MatrixXd StackedLinear::predict(const Eigen::MatrixXd& A) const {
+    return stacked_predict(*this, as_map(A));
+}
+
+Eigen::MatrixXd StackedLinear::backward(const Eigen::MatrixXd& dLdZ) {
+    size_t N = this->N_, K = this->num_models_, in = this->in_size_, out = this->out_size_;
+    ConstMap A = this->cached_input();
+    bool shared = static_cast<size_t>(A.cols()) == in;
+
+    this->dLdW_.resize(K * out, in);
+    Eigen::MatrixXd dLdA(N, A.cols());
+    if (shared) {
+        // ∂L/∂W = (∂L/∂Z)^T * A and ∂L/∂A = ∂L/∂Z * W, summed over the models
+        gemm(true, false, K * out, in, N,
+             1.0, dLdZ.data(), dLdZ.rows(), A.data(), A.rows(),
+             0.0, this->dLdW_.data(), this->dLdW_.rows());
+        gemm(false, false, N, in, K * out,
+             1.0, dLdZ.data(), dLdZ.rows(), this->W_.data(), this->W_.rows(),
+             0.0, dLdA.data(), dLdA.rows());
+    } else {
+        size_t models_grain = std::max<size_t>(1, STACKED_PARALLEL_GRAIN / std::max<size_t>(N * in * out, 1));
+        parallel_for(0, K, models_grain, [&](size_t lo, size_t hi) {
+            for (size_t k = lo; k < hi; k++) {
+                gemm(true, false, out, in, N,
+                     1.0, dLdZ.data() + k * out * N, dLdZ.rows(), A.data() + k * in * N, A.rows(),
+                     0.0, this->dLdW_.data() + k * out, this->dLdW_.rows());
+                gemm(false, false, N, in, out,
+                     1.0, dLdZ.data() + k * out * N, dLdZ.rows(), this->W_.data() + k * out, this->W_.rows(),
+                     0.0, dLdA.data() + k * in * N, dLdA.rows());
+            }
+        });
+    }
+
+    this->dLdb_.resize(K * out, 1);
+    size_t grain = std::max<size_t>(1, BIAS_PARALLEL_GRAIN / std::max<size_t>(N, 1));
+    parallel_for(0, K * out, grain, [&](size_t lo, size_t hi) {
+        for (size_t j = lo; j < hi; j++) {
+            this->dLdb_(j) = dLdZ.col(j).sum();
+        }
+    });
     return dLdA;
 }
 
+std::unique_ptr<Linear> StackedLinear::unstack(size_t k) const {
+    assert(k < this->num_models_);
+    std::unique_ptr<Linear> linear = std::make_unique<Linear>(this->in_size_, this->out_size_);
+    linear->W_ = this->W_.middleRows(k * this->out_size_, this->out_size_);
+    linear->b_ = this->b_.middleRows(k * this->out_size_, this->out_size_);
+    return linear;
+}
+
+void StackedLinear::stack(size_t k, const Linear& linear) {
+    assert(k < this->num_models_);
+    assert(linear.in_size_ == this->in_size_ && linear.out_size_ == this->out_size_);
+    this->W_.middleRows(k * this->out_size_, this->out_size_) = linear.W_;
+    this->b_.middleRows(k * this->out_size_, this->out_size_) = linear.b_;
+}
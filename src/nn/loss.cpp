@@ -11,6 +11,12 @@
  */
 
 #include "../../include/nn/loss.h"
+#include "../../include/utils/parallel.h"
+#include <algorithm>
+#include <cassert>
+
+// Below this many elements, the softmax runs on a single thread
+static const size_t SOFTMAX_PARALLEL_GRAIN = 1 << 14;
 
 /**
  * @brief Computes the mean squared error loss function given the predicted output
@@ -22,14 +28,11 @@
  */
 double MeanSquaredError::forward(const Eigen::MatrixXd& A, const Eigen::MatrixXd& Y) {
 
-    // If the matrices are empty, initialize them to the input value A and Y
-    if(this->A_.size() == 0 || this->Y_.size() == 0
-        || this->N_ == 0 || this->C_ == 0) {
-        this->A_ = A;
-        this->Y_ = Y;
-        this->N_ = A.rows();
-        this->C_ = A.cols();
-    }
+    // Cache the inputs of this batch for the backward pass
+    this->A_ = A;
+    this->Y_ = Y;
+    this->N_ = A.rows();
+    this->C_ = A.cols();
     double loss = (A - Y).array().square().sum();
     return loss / (N_ * C_);
 
@@ -59,14 +62,11 @@ Eigen::MatrixXd MeanSquaredError::backward() {
  * @return double The loss value
  */
 double SoftmaxCrossEntropy::forward(const Eigen::MatrixXd& A, const Eigen::MatrixXd& Y) {
-    // If the matrices are empty, initialize them to the input value A and Y
-    if(this->A_.size() == 0 || this->Y_.size() == 0
-        || this->N_ == 0 || this->C_ == 0) {
-        this->A_ = A;
-        this->Y_ = Y;
-        this->N_ = A.rows();
-        this->C_ = A.cols();
-    }
+    // Cache the inputs of this batch for the backward pass
+    this->A_ = A;
+    this->Y_ = Y;
+    this->N_ = A.rows();
+    this->C_ = A.cols();
 
     Eigen::MatrixXd softmax = SoftmaxCrossEntropy::softmax(A);
 
@@ -89,4 +89,65 @@ Eigen::MatrixXd SoftmaxCrossEntropy::backward() {
     Eigen::MatrixXd Y = this->Y_;
     Eigen::MatrixXd softmax = SoftmaxCrossEntropy::softmax(A);
     return (softmax - Y) / N_;
-}
\ No newline at end of file
+}
+
+/**
+ * @brief Computes the row-wise softmax of A, subtracting the maximum of every
+ *        row first for numerical stability. Blocks of rows are independent,
+ *        so they are spread over threads for large inputs.
+ *
+ * @param A The input, one sample per row
+ * @return Eigen::MatrixXd The softmax of every row of A
+ */
+Eigen::MatrixXd SoftmaxCrossEntropy::softmax(const Eigen::MatrixXd& A) {
+    Eigen::MatrixXd softmax(A.rows(), A.cols());
+    size_t grain = std::max<size_t>(1, SOFTMAX_PARALLEL_GRAIN / std::max<Eigen::Index>(A.cols(), 1));
+    parallel_for(0, A.rows(), grain, [&](size_t lo, size_t hi) {
+        auto rows = A.middleRows(lo, hi - lo).array();
+        Eigen::ArrayXXd exps = (rows.colwise() - rows.rowwise().maxCoeff()).exp();
+        softmax.middleRows(lo, hi - lo) = (exps.colwise() / exps.rowwise().sum()).matrix();
+    });
+    return softmax;
+}
+
+
+StackedLoss::StackedLoss(size_t num_models,
+                         const std::function<std::unique_ptr<LossFunction>()>& make_loss)
+    : losses_(num_models, 0.0) {
+    for (size_t k = 0; k < num_models; k++) {
+        this->loss_fns_.push_back(make_loss());
+    }
+}
+
+double StackedLoss::forward(const Eigen::MatrixXd& A, const Eigen::MatrixXd& Y) {
+    size_t K = this->loss_fns_.size();
+    assert(A.cols() % K == 0);
+    this->N_ = A.rows();
+    this->C_ = A.cols() / K;
+    bool shared = static_cast<size_t>(Y.cols()) == this->C_;
+    assert(shared || Y.cols() == A.cols());
+
+    // The models are independent, so their losses run in parallel
+    parallel_for(0, K, 1, [&](size_t lo, size_t hi) {
+        for (size_t k = lo; k < hi; k++) {
+            Eigen::MatrixXd Yk = shared ? Y : Y.middleCols(k * this->C_, this->C_);
+            this->losses_[k] = this->loss_fns_[k]->forward(A.middleCols(k * this->C_, this->C_), Yk);
+        }
+    });
+    double sum = 0.0;
+    for (double loss : this->losses_) {
+        sum += loss;
+    }
+    return sum / K;
+}
+
+Eigen::MatrixXd StackedLoss::backward() {
+    size_t K = this->loss_fns_.size();
+    Eigen::MatrixXd dLdA(this->N_, K * this->C_);
+    parallel_for(0, K, 1, [&](size_t lo, size_t hi) {
+        for (size_t k = lo; k < hi; k++) {
+            dLdA.middleCols(k * this->C_, this->C_) = this->loss_fns_[k]->backward();
+        }
+    });
+    return dLdA;
+}
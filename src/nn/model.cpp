@@ -12,27 +12,38 @@
 
 #include "../../include/nn/model.h"
 #include <Eigen/Dense>
+#include <algorithm>
+#include <cmath>
 
 /**
  * @brief Implements the generic forward pass of the model.
  * Calls the forward function of each layer and activation function
- * in the model.
+ * in the model. With checkpoints, the input of every segment is saved
+ * and the caches of every segment but the last are released.
  *
  * @param X
  * @return Eigen::MatrixXd
  */
 Eigen::MatrixXd Model::forward(const Eigen::MatrixXd& X) {
-    Eigen::MatrixXd A = X;
-    for (int i = 0; i < this->layers_.size(); i++) {
-        A = this->layers_[i]->forward(A);
-
-        // Guard check if activations are not provided
-        if(i > this->activations_.size() - 1) {
-            return A;
-        }
+    this->peak_cache_bytes_ = 0;
+    if (this->checkpoints_.empty()) {
+        Eigen::MatrixXd A = this->forward_segment(X, 0, this->layers_.size());
+        this->update_peak();
+        return A;
+    }
 
-        A = this->activations_[i]->forward(A);
+    this->segment_inputs_.clear();
+    Eigen::MatrixXd A = X;
+    size_t first = 0;
+    for (size_t last : this->checkpoints_) {
+        this->segment_inputs_.push_back(A);
+        A = this->forward_segment(std::move(A), first, last);
+        this->update_peak();
+        this->release_segment(first, last);
+        first = last;
     }
+    A = this->forward_segment(std::move(A), first, this->layers_.size());
+    this->update_peak();
     return A;
 }
 
@@ -45,12 +56,116 @@ Eigen::MatrixXd Model::forward(const Eigen::MatrixXd& X) {
 
  */
 void Model::backward() {
+    this->backward([](size_t) {});
+}
+
+void Model::backward(const std::function<void(size_t)>& after_layer) {
     Eigen::MatrixXd dLdA = this->loss_->backward();
+    size_t last = this->layers_.size();
+    for (size_t s = this->checkpoints_.size() + 1; s-- > 0;) {
+        size_t first = s == 0 ? 0 : this->checkpoints_[s - 1];
+        if (s < this->checkpoints_.size()) {
+            // Recompute the caches of this segment from its saved input
+            this->forward_segment(std::move(this->segment_inputs_[s]), first, last);
+            this->segment_inputs_.pop_back();
+            this->update_peak();
+        }
+        dLdA = this->backward_segment(std::move(dLdA), first, last, after_layer);
+        if (!this->checkpoints_.empty()) {
+            this->release_segment(first, last);
+        }
+        last = first;
+    }
+}
+
+Eigen::MatrixXd Model::predict(const Eigen::MatrixXd& X) const {
+    Eigen::MatrixXd A = X;
+    for (size_t i = 0; i < this->layers_.size(); i++) {
+        A = this->layers_[i]->predict(A);
+        if (i < this->activations_.size()) {
+            A = this->activations_[i]->predict(A);
+        }
+    }
+    return A;
+}
+
+Eigen::MatrixXd Model::forward_segment(Eigen::MatrixXd A, size_t first, size_t last) {
+    for (size_t i = first; i < last; i++) {
+        A = this->layers_[i]->forward(A);
+
+        // Guard check if activations are not provided
+        if(i >= this->activations_.size()) {
+            continue;
+        }
+
+        A = this->activations_[i]->forward(A);
+    }
+    return A;
+}
+
+Eigen::MatrixXd Model::backward_segment(Eigen::MatrixXd dLdA, size_t first, size_t last,
+                                        const std::function<void(size_t)>& after_layer) {
     Eigen::MatrixXd dLdZ;
-    for (int i = this->layers_.size() - 1; i >= 0; i--) {
-        if(i <= this->activations_.size() - 1) {
+    for (size_t i = last; i-- > first;) {
+        if(i < this->activations_.size()) {
             dLdZ = this->activations_[i]->backward(dLdA);
+        } else {
+            dLdZ = dLdA;
         }
-        dLdA = layers_[i]->backward(dLdA);
+        dLdA = layers_[i]->backward(dLdZ);
+        after_layer(i);
     }
-}
\ No newline at end of file
+    return dLdA;
+}
+
+void Model::release_segment(size_t first, size_t last) {
+    for (size_t i = first; i < last; i++) {
+        Layer::Cache released;
+        this->layers_[i]->swap_cache(released);
+        if (i < this->activations_.size()) {
+            ActivationFunction::Cache released_A;
+            this->activations_[i]->swap_cache(released_A);
+        }
+    }
+}
+
+void Model::set_checkpoints(const std::vector<size_t>& checkpoints) {
+    this->checkpoints_.clear();
+    for (size_t c : checkpoints) {
+        if (c > 0 && c < this->layers_.size()) {
+            this->checkpoints_.push_back(c);
+        }
+    }
+    std::sort(this->checkpoints_.begin(), this->checkpoints_.end());
+    this->checkpoints_.erase(std::unique(this->checkpoints_.begin(), this->checkpoints_.end()),
+                             this->checkpoints_.end());
+    this->segment_inputs_.clear();
+}
+
+void Model::set_sqrt_checkpoints() {
+    size_t L = this->layers_.size();
+    size_t segment = std::max<size_t>(1, static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(L)))));
+    std::vector<size_t> checkpoints;
+    for (size_t c = segment; c < L; c += segment) {
+        checkpoints.push_back(c);
+    }
+    this->set_checkpoints(checkpoints);
+}
+
+size_t Model::cache_bytes() const {
+    size_t bytes = 0;
+    for (const std::unique_ptr<Layer>& layer : this->layers_) {
+        bytes += layer->cache_bytes();
+    }
+    for (const std::unique_ptr<ActivationFunction>& activation : this->activations_) {
+        bytes += activation->A_.size() * sizeof(double);
+    }
+    for (const Eigen::MatrixXd& input : this->segment_inputs_) {
+        bytes += input.size() * sizeof(double);
+    }
+    return bytes;
+}
+
+void Model::update_peak() {
+    this->peak_cache_bytes_ = std::max(this->peak_cache_bytes_, this->cache_bytes());
+}
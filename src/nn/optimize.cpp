@@ -0,0 +1,126 @@
+/**
+ * @file optimize.cpp
+ * @author Krish Suraparaju (csurapar@andrew.cmu.edu)
+ * @brief Provides the implementation of the inference rewrites defined in
+ *        include/nn/optimize.h header.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include "../../include/nn/optimize.h"
+#include <memory>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief One layer and the activation that follows it, if any.
+ */
+struct Step {
+    std::unique_ptr<Layer> layer;
+    std::unique_ptr<ActivationFunction> activation;
+};
+
+static Linear* as_linear(const std::unique_ptr<Layer>& layer) {
+    // Exactly Linear: other layers may reuse W_ and b_ with another meaning
+    return layer && typeid(*layer) == typeid(Linear) ? static_cast<Linear*>(layer.get()) : nullptr;
+}
+
+static bool is_identity(const Linear& linear) {
+    return linear.in_size_ == linear.out_size_
+        && linear.W_.isIdentity(0.0) && linear.b_.isZero(0.0);
+}
+
+OptimizeStats optimize_for_inference(Model& model) {
+    OptimizeStats stats;
+    std::vector<Step> steps(model.layers_.size());
+    for (size_t i = 0; i < steps.size(); i++) {
+        steps[i].layer = std::move(model.layers_[i]);
+        if (i < model.activations_.size()) {
+            steps[i].activation = std::move(model.activations_[i]);
+        }
+    }
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (size_t i = 0; i < steps.size(); i++) {
+            Linear* linear = as_linear(steps[i].layer);
+            ActivationFunction* activation = steps[i].activation.get();
+
+            if (dynamic_cast<Identity*>(activation) != nullptr) {
+                steps[i].activation.reset();
+                stats.removed_identities++;
+                changed = true;
+                continue;
+            }
+
+            Scale* scale = dynamic_cast<Scale*>(activation);
+            if (linear != nullptr && scale != nullptr) {
+                linear->W_ *= scale->scale_;
+                linear->b_ *= scale->scale_;
+                steps[i].activation.reset();
+                stats.folded_scales++;
+                changed = true;
+                continue;
+            }
+
+            // An identity layer can go if its activation (if any) can move
+            // onto the previous layer
+            if (linear != nullptr && is_identity(*linear)) {
+                bool has_activation = steps[i].activation != nullptr;
+                if (!has_activation || (i > 0 && steps[i - 1].activation == nullptr)) {
+                    if (has_activation) {
+                        steps[i - 1].activation = std::move(steps[i].activation);
+                    }
+                    steps.erase(steps.begin() + i);
+                    stats.removed_identities++;
+                    changed = true;
+                    break;
+                }
+            }
+
+            Linear* next = i + 1 < steps.size() ? as_linear(steps[i + 1].layer) : nullptr;
+            if (linear != nullptr && next != nullptr && activation == nullptr) {
+                size_t in = linear->in_size_, mid = linear->out_size_, out = next->out_size_;
+                if (in * out < in * mid + mid * out) {
+                    std::unique_ptr<Linear> fused = std::make_unique<Linear>(in, out);
+                    fused->W_ = next->W_ * linear->W_;
+                    fused->b_ = next->W_ * linear->b_ + next->b_;
+                    steps[i].layer = std::move(fused);
+                    steps[i].activation = std::move(steps[i + 1].activation);
+                    steps.erase(steps.begin() + i + 1);
+                    stats.fused_linears++;
+                    changed = true;
+                    break;
+                }
+            }
+        }
+    }
+
+    // Rebuild the model, with Identity placeholders up to the last activation
+    size_t with_activation = 0;
+    for (size_t i = 0; i < steps.size(); i++) {
+        if (steps[i].activation != nullptr) {
+            with_activation = i + 1;
+        }
+    }
+    model.layers_.clear();
+    model.activations_.clear();
+    // Checkpoints refer to layer indices that no longer exist
+    model.checkpoints_.clear();
+    model.segment_inputs_.clear();
+    for (size_t i = 0; i < steps.size(); i++) {
+        model.layers_.push_back(std::move(steps[i].layer));
+        if (i < with_activation) {
+            if (steps[i].activation == nullptr) {
+                steps[i].activation = std::make_unique<Identity>();
+            }
+            model.activations_.push_back(std::move(steps[i].activation));
+        }
+    }
+    return stats;
+}
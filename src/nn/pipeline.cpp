@@ -0,0 +1,318 @@
+/**
+ * @file pipeline.cpp
+ * @author Krish Suraparaju (csurapar@andrew.cmu.edu)
+ * @brief Provides the implementation of the pipeline-parallel execution
+ *        defined in include/nn/pipeline.h header.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include "../../include/nn/pipeline.h"
+#include "../../include/utils/parallel.h"
+#include "../../include/utils/thread_pool.h"
+#include <algorithm>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+/**
+ * @brief The core of every stage: the cores the process may run on, minus the
+ * ones the global pool's workers are pinned to (unless that leaves none),
+ * dealt out in turn. -1 everywhere if the cores cannot be queried.
+ */
+static std::vector<int> stage_cores(size_t num_stages) {
+    std::vector<int> cores(num_stages, -1);
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) != 0) {
+        return cores;
+    }
+    std::vector<int> allowed, free;
+    ThreadPool& pool = ThreadPool::global();
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (!CPU_ISSET(cpu, &set)) {
+            continue;
+        }
+        allowed.push_back(cpu);
+        bool taken = false;
+        for (size_t i = 0; i + 1 < pool.num_threads(); i++) {
+            taken = taken || pool.worker_cpu(i) == cpu;
+        }
+        if (!taken) {
+            free.push_back(cpu);
+        }
+    }
+    const std::vector<int>& pick = free.empty() ? allowed : free;
+    for (size_t s = 0; s < num_stages && !pick.empty(); s++) {
+        cores[s] = pick[s % pick.size()];
+    }
+#endif
+    return cores;
+}
+
+PipelineModel::PipelineModel(Model& model, size_t num_stages, size_t num_micro_batches,
+                             PipelineSchedule schedule, bool pin_threads)
+    : model_(model), num_micro_batches_(std::max<size_t>(num_micro_batches, 1)),
+      schedule_(schedule) {
+    size_t L = model.layers_.size();
+    num_stages = std::max<size_t>(1, std::min(num_stages, L));
+
+    // Split the layers into contiguous stages of about the same parameter count
+    std::vector<size_t> params(L);
+    size_t total = 0;
+    for (size_t i = 0; i < L; i++) {
+        params[i] = model.layers_[i]->W_.size() + model.layers_[i]->b_.size() + 1;
+        total += params[i];
+    }
+    size_t first = 0;
+    size_t seen = 0;
+    for (size_t s = 0; s < num_stages; s++) {
+        size_t last = first + 1;
+        seen += params[first];
+        size_t target = total * (s + 1) / num_stages;
+        // Leave at least one layer for every remaining stage
+        while (last < L - (num_stages - s - 1) && seen + params[last] / 2 < target) {
+            seen += params[last];
+            last++;
+        }
+        if (s == num_stages - 1) {
+            for (; last < L; last++) {
+                seen += params[last];
+            }
+        }
+        this->stages_.push_back(std::make_pair(first, last));
+        first = last;
+    }
+
+    this->workers_.resize(num_stages);
+    for (size_t s = 0; s < num_stages; s++) {
+        Stage& stage = this->workers_[s];
+        if (s > 0) {
+            stage.activations_in = std::make_unique<SpscQueue<Message>>(this->num_micro_batches_);
+        }
+        if (s + 1 < num_stages) {
+            stage.gradients_in = std::make_unique<SpscQueue<Message>>(this->num_micro_batches_);
+        }
+        size_t layers = this->stages_[s].second - this->stages_[s].first;
+        stage.layer_stash.assign(this->num_micro_batches_, std::vector<Layer::Cache>(layers));
+        stage.activation_stash.assign(this->num_micro_batches_, std::vector<ActivationFunction::Cache>(layers));
+        stage.dLdW.resize(layers);
+        stage.dLdb.resize(layers);
+    }
+    std::vector<int> cores = pin_threads ? stage_cores(num_stages) : std::vector<int>(num_stages, -1);
+    for (size_t s = 0; s < num_stages; s++) {
+        this->workers_[s].thread = std::thread(&PipelineModel::worker, this, s, cores[s]);
+    }
+}
+
+PipelineModel::~PipelineModel() {
+    {
+        std::lock_guard<std::mutex> lock(this->mutex_);
+        this->stop_ = true;
+    }
+    this->start_cv_.notify_all();
+    for (Stage& stage : this->workers_) {
+        stage.thread.join();
+    }
+}
+
+Eigen::MatrixXd PipelineModel::forward(const Eigen::MatrixXd& X) {
+    this->run(false, X, nullptr);
+    return std::move(this->output_);
+}
+
+double PipelineModel::train_step(const Eigen::MatrixXd& X, const Eigen::MatrixXd& Y) {
+    this->run(true, X, &Y);
+
+    // Every micro-batch loss is a mean over its own rows
+    double loss = 0.0;
+    for (size_t m = 0; m < this->losses_.size(); m++) {
+        double rows = static_cast<double>(this->offsets_[m + 1] - this->offsets_[m]);
+        loss += this->losses_[m] * rows / X.rows();
+    }
+    return loss;
+}
+
+void PipelineModel::run(bool training, const Eigen::MatrixXd& X, const Eigen::MatrixXd* Y) {
+    size_t N = X.rows();
+    size_t M = std::min(this->num_micro_batches_, std::max<size_t>(N, 1));
+    this->offsets_.resize(M + 1);
+    for (size_t m = 0; m <= M; m++) {
+        this->offsets_[m] = N * m / M;
+    }
+    this->training_ = training;
+    this->X_ = &X;
+    this->Y_ = Y;
+    this->losses_.assign(M, 0.0);
+    this->loss_gradients_.assign(M, Eigen::MatrixXd());
+
+    std::unique_lock<std::mutex> lock(this->mutex_);
+    this->finished_ = 0;
+    this->generation_++;
+    this->start_cv_.notify_all();
+    this->done_cv_.wait(lock, [this]() { return this->finished_ == this->workers_.size(); });
+}
+
+void PipelineModel::worker(size_t s, int cpu) {
+#ifdef __linux__
+    if (cpu >= 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    }
+#endif
+    // A pinned stage keeps its layers' work on its own core
+    std::unique_ptr<SerialScope> serial = cpu >= 0 ? std::make_unique<SerialScope>() : nullptr;
+    size_t seen = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(this->mutex_);
+            this->start_cv_.wait(lock, [&]() { return this->stop_ || this->generation_ != seen; });
+            if (this->stop_) {
+                return;
+            }
+            seen = this->generation_;
+        }
+        this->run_stage(s);
+        {
+            std::lock_guard<std::mutex> lock(this->mutex_);
+            this->finished_++;
+        }
+        this->done_cv_.notify_one();
+    }
+}
+
+std::vector<PipelineModel::Op> PipelineModel::schedule(size_t s) const {
+    size_t M = this->offsets_.size() - 1;
+    std::vector<Op> ops;
+    if (!this->training_ || this->schedule_ == PipelineSchedule::GPipe) {
+        for (size_t m = 0; m < M; m++) {
+            ops.push_back({true, m});
+        }
+        for (size_t m = 0; this->training_ && m < M; m++) {
+            ops.push_back({false, m});
+        }
+        return ops;
+    }
+
+    // 1F1B: stage s runs ahead by (stages - s - 1) forward passes, which is
+    // how long its first micro-batch takes to come back from the last stage
+    size_t warmup = std::min(this->workers_.size() - s - 1, M);
+    for (size_t m = 0; m < warmup; m++) {
+        ops.push_back({true, m});
+    }
+    for (size_t m = warmup; m < M; m++) {
+        ops.push_back({true, m});
+        ops.push_back({false, m - warmup});
+    }
+    for (size_t m = M - warmup; m < M; m++) {
+        ops.push_back({false, m});
+    }
+    return ops;
+}
+
+void PipelineModel::run_stage(size_t s) {
+    bool first = true;
+    for (const Op& op : this->schedule(s)) {
+        if (op.forward) {
+            this->stage_forward(s, op.micro_batch);
+        } else {
+            this->stage_backward(s, op.micro_batch, first);
+            first = false;
+        }
+    }
+    if (!this->training_) {
+        return;
+    }
+    Stage& stage = this->workers_[s];
+    for (size_t i = this->stages_[s].first; i < this->stages_[s].second; i++) {
+        size_t j = i - this->stages_[s].first;
+        this->model_.layers_[i]->dLdW_.swap(stage.dLdW[j]);
+        this->model_.layers_[i]->dLdb_.swap(stage.dLdb[j]);
+    }
+}
+
+void PipelineModel::stage_forward(size_t s, size_t m) {
+    Stage& stage = this->workers_[s];
+    size_t row = this->offsets_[m];
+    size_t rows = this->offsets_[m + 1] - row;
+    Eigen::MatrixXd A = s == 0 ? Eigen::MatrixXd(this->X_->middleRows(row, rows))
+                               : stage.activations_in->pop().data;
+
+    for (size_t i = this->stages_[s].first; i < this->stages_[s].second; i++) {
+        size_t j = i - this->stages_[s].first;
+        A = this->model_.layers_[i]->forward(A);
+        if (this->training_) {
+            this->model_.layers_[i]->swap_cache(stage.layer_stash[m][j]);
+        }
+        if (i < this->model_.activations_.size()) {
+            A = this->model_.activations_[i]->forward(A);
+            if (this->training_) {
+                this->model_.activations_[i]->swap_cache(stage.activation_stash[m][j]);
+            }
+        }
+    }
+
+    if (s + 1 < this->workers_.size()) {
+        Message message;
+        message.micro_batch = m;
+        message.data = std::move(A);
+        this->workers_[s + 1].activations_in->push(std::move(message));
+    } else if (this->training_) {
+        // Scale the mean loss of the micro-batch to its share of the mini-batch
+        this->losses_[m] = this->model_.loss_->forward(A, this->Y_->middleRows(row, rows));
+        this->loss_gradients_[m] = this->model_.loss_->backward()
+                                   * (static_cast<double>(rows) / this->X_->rows());
+    } else {
+        if (m == 0) {
+            this->output_.resize(this->X_->rows(), A.cols());
+        }
+        this->output_.middleRows(row, rows) = A;
+    }
+}
+
+void PipelineModel::stage_backward(size_t s, size_t m, bool first) {
+    Stage& stage = this->workers_[s];
+    Eigen::MatrixXd dLdA = s + 1 == this->workers_.size() ? std::move(this->loss_gradients_[m])
+                                                          : stage.gradients_in->pop().data;
+    Eigen::MatrixXd dLdZ;
+
+    for (size_t i = this->stages_[s].second; i-- > this->stages_[s].first;) {
+        size_t j = i - this->stages_[s].first;
+        Layer& layer = *this->model_.layers_[i];
+        if (i < this->model_.activations_.size()) {
+            this->model_.activations_[i]->swap_cache(stage.activation_stash[m][j]);
+            dLdZ = this->model_.activations_[i]->backward(dLdA);
+        } else {
+            dLdZ = std::move(dLdA);
+        }
+        layer.swap_cache(stage.layer_stash[m][j]);
+        dLdA = layer.backward(dLdZ);
+
+        if (first) {
+            stage.dLdW[j] = layer.dLdW_;
+            stage.dLdb[j] = layer.dLdb_;
+        } else {
+            if (stage.dLdW[j].size() == layer.dLdW_.size()) {
+                stage.dLdW[j] += layer.dLdW_;
+            }
+            if (stage.dLdb[j].size() == layer.dLdb_.size()) {
+                stage.dLdb[j] += layer.dLdb_;
+            }
+        }
+    }
+
+    if (s > 0) {
+        Message message;
+        message.micro_batch = m;
+        message.data = std::move(dLdA);
+        this->workers_[s - 1].gradients_in->push(std::move(message));
+    }
+}
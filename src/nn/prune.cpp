@@ -0,0 +1,86 @@
+/**
+ * @file prune.cpp
+ * @author Krish Suraparaju (csurapar@andrew.cmu.edu)
+ * @brief Provides the implementation of the pruning utilities defined in
+ *        include/nn/prune.h header.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include "../../include/nn/prune.h"
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <numeric>
+
+/**
+ * @brief Zeroes the round(sparsity * count) weights with the smallest
+ * magnitude across the given layers. Ties at the threshold are broken by
+ * position (the order of the layers, then of the weights within each), so
+ * exactly that many weights are removed.
+ */
+static size_t prune_layers(const std::vector<Linear*>& layers, double sparsity) {
+    std::vector<double*> weights;
+    for (Linear* linear : layers) {
+        double* data = linear->W_.data();
+        for (Eigen::Index k = 0; k < linear->W_.size(); k++) {
+            weights.push_back(data + k);
+        }
+    }
+    size_t count = static_cast<size_t>(std::llround(sparsity * weights.size()));
+    count = std::min(count, weights.size());
+    if (count == 0) {
+        return 0;
+    }
+    std::vector<size_t> order(weights.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::nth_element(order.begin(), order.begin() + (count - 1), order.end(),
+                     [&](size_t a, size_t b) {
+                         double wa = std::abs(*weights[a]), wb = std::abs(*weights[b]);
+                         return wa < wb || (wa == wb && a < b);
+                     });
+    for (size_t k = 0; k < count; k++) {
+        *weights[order[k]] = 0.0;
+    }
+    return count;
+}
+
+size_t magnitude_prune(Model& model, const std::vector<size_t>& layer_indices,
+                       double sparsity, PruneScope scope, bool to_sparse) {
+    sparsity = std::min(std::max(sparsity, 0.0), 1.0);
+
+    // A layer listed twice is pruned once; otherwise it would count twice in
+    // the global threshold and be converted again after it was replaced
+    std::vector<size_t> indices = layer_indices;
+    std::sort(indices.begin(), indices.end());
+    indices.erase(std::unique(indices.begin(), indices.end()), indices.end());
+
+    std::vector<size_t> selected;
+    std::vector<Linear*> linears;
+    for (size_t i : indices) {
+        Linear* linear = dynamic_cast<Linear*>(model.layers_.at(i).get());
+        if (linear != nullptr) {
+            selected.push_back(i);
+            linears.push_back(linear);
+        }
+    }
+
+    size_t pruned = 0;
+    if (scope == PruneScope::Global) {
+        pruned = prune_layers(linears, sparsity);
+    } else {
+        for (Linear* linear : linears) {
+            pruned += prune_layers({linear}, sparsity);
+        }
+    }
+
+    if (to_sparse) {
+        for (size_t k = 0; k < selected.size(); k++) {
+            model.layers_[selected[k]] = std::make_unique<SparseLinear>(*linears[k]);
+        }
+    }
+    return pruned;
+}
@@ -0,0 +1,192 @@
+/**
+ * @file online.cpp
+ * @author Krish Suraparaju (csurapar@andrew.cmu.edu)
+ * @brief Provides the implementation of the online trainer defined in
+ *        include/optim/online.h header.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include "../../include/optim/online.h"
+#include <algorithm>
+#include <cassert>
+
+/**
+ * @brief Releases everything a copied layer kept for backward, so a snapshot
+ * only holds parameters.
+ */
+static void release_training_state(Layer& layer) {
+    Layer::Cache empty;
+    layer.swap_cache(empty);
+    layer.dLdW_.resize(0, 0);
+    layer.dLdb_.resize(0, 0);
+    for (Layer* child : layer.children()) {
+        release_training_state(*child);
+    }
+}
+
+ModelSnapshot::ModelSnapshot(const Model& model, size_t step) : step_(step) {
+    for (const std::unique_ptr<Layer>& layer : model.layers_) {
+        this->layers_.push_back(layer->clone());
+        release_training_state(*this->layers_.back());
+    }
+    for (const std::unique_ptr<ActivationFunction>& activation : model.activations_) {
+        this->activations_.push_back(activation->clone());
+        ActivationFunction::Cache empty;
+        this->activations_.back()->swap_cache(empty);
+    }
+}
+
+Eigen::MatrixXd ModelSnapshot::predict(const Eigen::MatrixXd& X) const {
+    Eigen::MatrixXd A = X;
+    for (size_t i = 0; i < this->layers_.size(); i++) {
+        A = this->layers_[i]->predict(A);
+        if (i < this->activations_.size()) {
+            A = this->activations_[i]->predict(A);
+        }
+    }
+    return A;
+}
+
+OnlineTrainer::OnlineTrainer(Model& model, SGD& sgd, size_t input_size, size_t target_size,
+                             size_t capacity, size_t batch_size, size_t publish_every,
+                             bool drop_oldest)
+    : model_(model), sgd_(sgd), batch_size_(batch_size), publish_every_(publish_every),
+      drop_oldest_(drop_oldest), X_ring_(capacity, input_size), Y_ring_(capacity, target_size),
+      X_batch_(batch_size, input_size), Y_batch_(batch_size, target_size) {
+    assert(batch_size > 0 && capacity >= batch_size && publish_every > 0);
+}
+
+OnlineTrainer::~OnlineTrainer() {
+    if (this->thread_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(this->mutex_);
+            this->stopping_ = true;
+        }
+        this->not_empty_.notify_all();
+        this->not_full_.notify_all();
+        this->thread_.join();
+    }
+}
+
+void OnlineTrainer::start() {
+    assert(!this->thread_.joinable());
+    this->stopping_ = false;
+    this->publish();
+    this->thread_ = std::thread([this]() { this->train_loop(); });
+}
+
+void OnlineTrainer::stop() {
+    {
+        std::lock_guard<std::mutex> lock(this->mutex_);
+        this->stopping_ = true;
+    }
+    this->not_empty_.notify_all();
+    this->not_full_.notify_all();
+    if (this->thread_.joinable()) {
+        this->thread_.join();
+    }
+    if (this->error_) {
+        std::exception_ptr error = this->error_;
+        this->error_ = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
+bool OnlineTrainer::push(const Eigen::MatrixXd& X, const Eigen::MatrixXd& Y) {
+    assert(X.rows() == Y.rows());
+    assert(X.cols() == this->X_ring_.cols() && Y.cols() == this->Y_ring_.cols());
+    size_t capacity = this->X_ring_.rows();
+    size_t pushed = 0, total = X.rows();
+
+    std::unique_lock<std::mutex> lock(this->mutex_);
+    while (pushed < total) {
+        if (this->size_ == capacity) {
+            if (this->drop_oldest_) {
+                // Make room for the rest of X by forgetting the oldest samples
+                size_t drop = std::min(total - pushed, capacity);
+                this->head_ = (this->head_ + drop) % capacity;
+                this->size_ -= drop;
+                this->dropped_ += drop;
+            } else {
+                this->not_full_.wait(lock, [&]() { return this->size_ < capacity || this->stopping_; });
+            }
+        }
+        if (this->stopping_) {
+            return false;
+        }
+        // Copy as many rows as fit before the end of the ring or the head
+        size_t tail = (this->head_ + this->size_) % capacity;
+        size_t rows = std::min({total - pushed, capacity - this->size_, capacity - tail});
+        this->X_ring_.middleRows(tail, rows) = X.middleRows(pushed, rows);
+        this->Y_ring_.middleRows(tail, rows) = Y.middleRows(pushed, rows);
+        this->size_ += rows;
+        pushed += rows;
+        if (this->size_ >= this->batch_size_) {
+            this->not_empty_.notify_one();
+        }
+    }
+    return true;
+}
+
+std::shared_ptr<const ModelSnapshot> OnlineTrainer::snapshot() const {
+    return std::atomic_load(&this->snapshot_);
+}
+
+size_t OnlineTrainer::dropped() const {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    return this->dropped_;
+}
+
+void OnlineTrainer::publish() {
+    std::shared_ptr<const ModelSnapshot> snapshot =
+        std::make_shared<const ModelSnapshot>(this->model_, this->steps());
+    std::atomic_store(&this->snapshot_, snapshot);
+}
+
+void OnlineTrainer::train_loop() {
+    size_t capacity = this->X_ring_.rows();
+    try {
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(this->mutex_);
+                this->not_empty_.wait(lock, [&]() {
+                    return this->size_ >= this->batch_size_ || this->stopping_;
+                });
+                if (this->size_ < this->batch_size_) {
+                    break;
+                }
+                // The oldest batch_size samples, in at most two pieces
+                size_t first = std::min(this->batch_size_, capacity - this->head_);
+                size_t second = this->batch_size_ - first;
+                this->X_batch_.topRows(first) = this->X_ring_.middleRows(this->head_, first);
+                this->Y_batch_.topRows(first) = this->Y_ring_.middleRows(this->head_, first);
+                this->X_batch_.bottomRows(second) = this->X_ring_.topRows(second);
+                this->Y_batch_.bottomRows(second) = this->Y_ring_.topRows(second);
+                this->head_ = (this->head_ + this->batch_size_) % capacity;
+                this->size_ -= this->batch_size_;
+            }
+            this->not_full_.notify_all();
+
+            double loss = this->model_.loss_->forward(this->model_.forward(this->X_batch_), this->Y_batch_);
+            this->model_.backward();
+            this->sgd_.step();
+            this->last_loss_.store(loss, std::memory_order_relaxed);
+            size_t steps = this->steps_.fetch_add(1, std::memory_order_relaxed) + 1;
+            if (steps % this->publish_every_ == 0) {
+                this->publish();
+            }
+        }
+        this->publish();
+    } catch (...) {
+        this->error_ = std::current_exception();
+        {
+            std::lock_guard<std::mutex> lock(this->mutex_);
+            this->stopping_ = true;
+        }
+        this->not_full_.notify_all();
+    }
+}
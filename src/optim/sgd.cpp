@@ -0,0 +1,91 @@
+/**
+ * @file sgd.cpp
+ * @author Krish Suraparaju
+ * @brief Provides the concrete implementation of the SGD optimizer
+ *        defined in include/optim/sgd.h header.
+ * @version 0.1
+ * @date 2024-05-12
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include "../../include/optim/sgd.h"
+#include "../../include/utils/parallel.h"
+#include <algorithm>
+#include <cassert>
+
+// Below this many updated values, sparse updates run on a single thread
+static const size_t SPARSE_UPDATE_PARALLEL_GRAIN = 1 << 14;
+
+// Below this many updated weights, the stacked models are updated on a single thread
+static const size_t STACKED_UPDATE_PARALLEL_GRAIN = 1 << 15;
+
+void SGD::step() {
+    for (std::unique_ptr<Layer>& layer : this->layers_) {
+        this->step(*layer);
+    }
+}
+
+void SGD::step(Layer& layer) {
+    for (Layer* child : layer.children()) {
+        this->step(*child);
+    }
+    Embedding* embedding = dynamic_cast<Embedding*>(&layer);
+    if (embedding != nullptr) {
+        this->step(*embedding);
+        return;
+    }
+    HalfLinear* half = dynamic_cast<HalfLinear*>(&layer);
+    if (half != nullptr) {
+        this->step(*half);
+        return;
+    }
+    StackedLinear* stacked = dynamic_cast<StackedLinear*>(&layer);
+    if (stacked != nullptr) {
+        this->step(*stacked);
+        return;
+    }
+    if (layer.dLdW_.size() == layer.W_.size() && layer.W_.size() > 0) {
+        layer.W_ -= this->lr_ * layer.dLdW_;
+    }
+    if (layer.dLdb_.size() == layer.b_.size() && layer.b_.size() > 0) {
+        layer.b_ -= this->lr_ * layer.dLdb_;
+    }
+}
+
+void SGD::step(Embedding& embedding) {
+    const std::vector<Eigen::Index>& indices = embedding.sparse_indices_;
+    const Eigen::MatrixXd& values = embedding.sparse_values_;
+    size_t D = std::max<size_t>(values.rows(), 1);
+    parallel_for(0, indices.size(), std::max<size_t>(1, SPARSE_UPDATE_PARALLEL_GRAIN / D),
+                 [&](size_t lo, size_t hi) {
+        for (size_t s = lo; s < hi; s++) {
+            embedding.W_.col(indices[s]) -= this->lr_ * values.col(s);
+        }
+    });
+}
+
+void SGD::step(HalfLinear& half) {
+    if (half.dLdW_.size() == 0) {
+        return;
+    }
+    half.set_weights(half.dense() - this->lr_ * half.dLdW_);
+    half.b_ -= this->lr_ * half.dLdb_;
+}
+
+void SGD::step(StackedLinear& stacked) {
+    if (stacked.dLdW_.size() != stacked.W_.size()) {
+        return;
+    }
+    size_t K = stacked.num_models_, out = stacked.out_size_;
+    assert(this->model_lrs_.empty() || this->model_lrs_.size() == K);
+    size_t grain = std::max<size_t>(1, STACKED_UPDATE_PARALLEL_GRAIN / std::max<size_t>(out * stacked.in_size_, 1));
+    parallel_for(0, K, grain, [&](size_t lo, size_t hi) {
+        for (size_t k = lo; k < hi; k++) {
+            double lr = this->model_lrs_.empty() ? this->lr_ : this->model_lrs_[k];
+            stacked.W_.middleRows(k * out, out) -= lr * stacked.dLdW_.middleRows(k * out, out);
+            stacked.b_.middleRows(k * out, out) -= lr * stacked.dLdb_.middleRows(k * out, out);
+        }
+    });
+}
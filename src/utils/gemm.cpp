@@ -0,0 +1,447 @@
+/**
+ * @file gemm.cpp
+ * @author Krish Suraparaju (csurapar@andrew.cmu.edu)
+ * @brief Provides the implementation of the GEMM backends defined in
+ *        include/utils/gemm.h header.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include "../../include/utils/gemm.h"
+#include "../../include/utils/parallel.h"
+#include <Eigen/Dense>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define DNN_GEMM_X86 1
+#include <immintrin.h>
+#endif
+
+#ifdef DNN_HAVE_CBLAS
+#include <cblas.h>
+#endif
+
+static std::atomic<GemmBackend> current_backend(GemmBackend::Eigen);
+
+// Cache blocking of the packed backend: a KC x MC panel of op(A) stays in L2,
+// a KC x NC panel of op(B) in L3, and one KC x NR sliver of it in L1
+static const size_t GEMM_KC = 256;
+static const size_t GEMM_MC = 128;
+static const size_t GEMM_NC = 4096;
+
+// Below this many multiply-adds, a GEMM runs on a single thread
+static const size_t GEMM_PARALLEL_WORK = 1 << 18;
+
+/**
+ * @brief A register-blocked micro-kernel. It adds the product of a packed
+ * MR x kc sliver of op(A) (stored k-major, MR values per k) and a packed
+ * kc x NR sliver of op(B) (NR values per k) to an MR x NR tile of C.
+ */
+struct MicroKernel {
+    size_t mr;
+    size_t nr;
+    void (*fn)(size_t kc, const double* a, const double* b, double* c, size_t ldc);
+    const char* name;
+};
+
+static void kernel_portable(size_t kc, const double* a, const double* b, double* c, size_t ldc) {
+    double acc[4][4] = {};
+    for (size_t k = 0; k < kc; k++) {
+        for (size_t j = 0; j < 4; j++) {
+            for (size_t i = 0; i < 4; i++) {
+                acc[j][i] += a[k * 4 + i] * b[k * 4 + j];
+            }
+        }
+    }
+    for (size_t j = 0; j < 4; j++) {
+        for (size_t i = 0; i < 4; i++) {
+            c[j * ldc + i] += acc[j][i];
+        }
+    }
+}
+
+#ifdef DNN_GEMM_X86
+/**
+ * @brief 8 x 6 tile: two 4-wide columns of A times 6 broadcast values of B,
+ * accumulated in 12 of the 16 ymm registers.
+ */
+__attribute__((target("avx2,fma")))
+static void kernel_avx2(size_t kc, const double* a, const double* b, double* c, size_t ldc) {
+    __m256d acc0[6], acc1[6];
+#pragma GCC unroll 6
+    for (size_t j = 0; j < 6; j++) {
+        acc0[j] = _mm256_setzero_pd();
+        acc1[j] = _mm256_setzero_pd();
+    }
+    for (size_t k = 0; k < kc; k++) {
+        __m256d a0 = _mm256_loadu_pd(a + k * 8);
+        __m256d a1 = _mm256_loadu_pd(a + k * 8 + 4);
+#pragma GCC unroll 6
+        for (size_t j = 0; j < 6; j++) {
+            __m256d bj = _mm256_broadcast_sd(b + k * 6 + j);
+            acc0[j] = _mm256_fmadd_pd(a0, bj, acc0[j]);
+            acc1[j] = _mm256_fmadd_pd(a1, bj, acc1[j]);
+        }
+    }
+#pragma GCC unroll 6
+    for (size_t j = 0; j < 6; j++) {
+        double* col = c + j * ldc;
+        _mm256_storeu_pd(col, _mm256_add_pd(_mm256_loadu_pd(col), acc0[j]));
+        _mm256_storeu_pd(col + 4, _mm256_add_pd(_mm256_loadu_pd(col + 4), acc1[j]));
+    }
+}
+
+/**
+ * @brief 16 x 12 tile: two 8-wide columns of A times 12 broadcast values of
+ * B, accumulated in 24 of the 32 zmm registers.
+ */
+__attribute__((target("avx512f")))
+static void kernel_avx512(size_t kc, const double* a, const double* b, double* c, size_t ldc) {
+    __m512d acc0[12], acc1[12];
+#pragma GCC unroll 12
+    for (size_t j = 0; j < 12; j++) {
+        acc0[j] = _mm512_setzero_pd();
+        acc1[j] = _mm512_setzero_pd();
+    }
+    for (size_t k = 0; k < kc; k++) {
+        __m512d a0 = _mm512_loadu_pd(a + k * 16);
+        __m512d a1 = _mm512_loadu_pd(a + k * 16 + 8);
+#pragma GCC unroll 12
+        for (size_t j = 0; j < 12; j++) {
+            __m512d bj = _mm512_set1_pd(b[k * 12 + j]);
+            acc0[j] = _mm512_fmadd_pd(a0, bj, acc0[j]);
+            acc1[j] = _mm512_fmadd_pd(a1, bj, acc1[j]);
+        }
+    }
+#pragma GCC unroll 12
+    for (size_t j = 0; j < 12; j++) {
+        double* col = c + j * ldc;
+        _mm512_storeu_pd(col, _mm512_add_pd(_mm512_loadu_pd(col), acc0[j]));
+        _mm512_storeu_pd(col + 8, _mm512_add_pd(_mm512_loadu_pd(col + 8), acc1[j]));
+    }
+}
+#endif
+
+static const MicroKernel& micro_kernel(GemmKernel kernel) {
+    static const MicroKernel portable{4, 4, kernel_portable, "packed-portable"};
+#ifdef DNN_GEMM_X86
+    static const MicroKernel avx2{8, 6, kernel_avx2, "packed-avx2"};
+    static const MicroKernel avx512{16, 12, kernel_avx512, "packed-avx512"};
+    switch (kernel) {
+    case GemmKernel::AVX2:
+        return avx2;
+    case GemmKernel::AVX512:
+        return avx512;
+    case GemmKernel::Portable:
+        break;
+    }
+#else
+    (void)kernel;
+#endif
+    return portable;
+}
+
+/**
+ * @brief The selected micro-kernel, initialized to the fastest supported one.
+ */
+static std::atomic<GemmKernel>& current_kernel() {
+    static std::atomic<GemmKernel> kernel(detect_gemm_kernel());
+    return kernel;
+}
+
+GemmKernel detect_gemm_kernel() {
+    if (gemm_kernel_supported(GemmKernel::AVX512)) {
+        return GemmKernel::AVX512;
+    }
+    if (gemm_kernel_supported(GemmKernel::AVX2)) {
+        return GemmKernel::AVX2;
+    }
+    return GemmKernel::Portable;
+}
+
+bool gemm_kernel_supported(GemmKernel kernel) {
+#ifdef DNN_GEMM_X86
+    __builtin_cpu_init();
+    switch (kernel) {
+    case GemmKernel::AVX512:
+        return __builtin_cpu_supports("avx512f");
+    case GemmKernel::AVX2:
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    case GemmKernel::Portable:
+        return true;
+    }
+    return false;
+#else
+    return kernel == GemmKernel::Portable;
+#endif
+}
+
+void set_gemm_kernel(GemmKernel kernel) {
+    if (!gemm_kernel_supported(kernel)) {
+        throw std::invalid_argument(std::string("set_gemm_kernel: ")
+                                    + gemm_kernel_name(kernel) + " is not supported by this CPU");
+    }
+    current_kernel().store(kernel);
+}
+
+GemmKernel gemm_kernel() {
+    return current_kernel().load();
+}
+
+const char* gemm_kernel_name(GemmKernel kernel) {
+    switch (kernel) {
+    case GemmKernel::Portable:
+        return "packed-portable";
+    case GemmKernel::AVX2:
+        return "packed-avx2";
+    case GemmKernel::AVX512:
+        return "packed-avx512";
+    }
+    return "unknown";
+}
+
+/**
+ * @brief Copies alpha * op(A)[i0 : i0 + m, k0 : k0 + kc] into slivers of mr
+ * rows, zero-padding the last one.
+ */
+static void pack_a(bool trans_a, const double* A, size_t lda, size_t i0, size_t m,
+                   size_t k0, size_t kc, double alpha, size_t mr, double* packed) {
+    for (size_t ir = 0; ir < m; ir += mr) {
+        size_t rows = std::min(mr, m - ir);
+        for (size_t k = 0; k < kc; k++) {
+            double* dst = packed + ir * kc + k * mr;
+            for (size_t i = 0; i < rows; i++) {
+                size_t row = i0 + ir + i, col = k0 + k;
+                dst[i] = alpha * (trans_a ? A[col + row * lda] : A[row + col * lda]);
+            }
+            std::fill(dst + rows, dst + mr, 0.0);
+        }
+    }
+}
+
+/**
+ * @brief Copies op(B)[k0 : k0 + kc, j0 : j0 + n] into slivers of nr columns,
+ * zero-padding the last one.
+ */
+static void pack_b(bool trans_b, const double* B, size_t ldb, size_t k0, size_t kc,
+                   size_t j0, size_t n, size_t nr, double* packed) {
+    for (size_t jr = 0; jr < n; jr += nr) {
+        size_t cols = std::min(nr, n - jr);
+        for (size_t k = 0; k < kc; k++) {
+            double* dst = packed + jr * kc + k * nr;
+            for (size_t j = 0; j < cols; j++) {
+                size_t row = k0 + k, col = j0 + jr + j;
+                dst[j] = trans_b ? B[col + row * ldb] : B[row + col * ldb];
+            }
+            std::fill(dst + cols, dst + nr, 0.0);
+        }
+    }
+}
+
+/**
+ * @brief Adds alpha * op(A)[ic : ic + mc, pc : pc + kc] times the packed
+ * slivers jr0 .. jr1 (in columns) of op(B) to C, tile by tile.
+ */
+static void packed_block(const MicroKernel& kernel, bool trans_a, const double* A, size_t lda,
+                         double alpha, size_t ic, size_t mc, size_t pc, size_t kc,
+                         const double* packed_b, size_t jc, size_t jr0, size_t jr1,
+                         double* packed_a, bool pack, double* C, size_t ldc) {
+    size_t mr = kernel.mr, nr = kernel.nr;
+    if (pack) {
+        pack_a(trans_a, A, lda, ic, mc, pc, kc, alpha, mr, packed_a);
+    }
+    double tile[16 * 12];
+    for (size_t jr = jr0; jr < jr1; jr += nr) {
+        size_t n = std::min(nr, jr1 - jr);
+        for (size_t ir = 0; ir < mc; ir += mr) {
+            size_t m = std::min(mr, mc - ir);
+            const double* a = packed_a + ir * kc;
+            const double* b = packed_b + jr * kc;
+            double* c = C + (ic + ir) + (jc + jr) * ldc;
+            if (m == mr && n == nr) {
+                kernel.fn(kc, a, b, c, ldc);
+                continue;
+            }
+            // Edge tile: compute the full tile aside, keep the valid part
+            std::fill(tile, tile + mr * nr, 0.0);
+            kernel.fn(kc, a, b, tile, mr);
+            for (size_t j = 0; j < n; j++) {
+                for (size_t i = 0; i < m; i++) {
+                    c[j * ldc + i] += tile[j * mr + i];
+                }
+            }
+        }
+    }
+}
+
+static void gemm_packed(bool trans_a, bool trans_b, size_t M, size_t N, size_t K,
+                        double alpha, const double* A, size_t lda, const double* B, size_t ldb,
+                        double* C, size_t ldc) {
+    const MicroKernel& kernel = micro_kernel(gemm_kernel());
+    size_t nr = kernel.nr;
+    size_t nc_max = GEMM_NC / nr * nr;
+    // op(B) panels are shared by all threads, op(A) blocks are per thread
+    size_t b_size = std::min(K, GEMM_KC) * ((std::min(N, nc_max) + nr - 1) / nr * nr);
+    std::unique_ptr<double[]> packed_b(new double[b_size]);
+    bool parallel = M * N * K >= GEMM_PARALLEL_WORK && num_threads() > 1;
+
+    for (size_t jc = 0; jc < N; jc += nc_max) {
+        size_t nc = std::min(nc_max, N - jc);
+        size_t slivers = (nc + nr - 1) / nr;
+        for (size_t pc = 0; pc < K; pc += GEMM_KC) {
+            size_t kc = std::min(GEMM_KC, K - pc);
+            parallel_for(0, slivers, parallel ? 1 : slivers, [&](size_t lo, size_t hi) {
+                pack_b(trans_b, B, ldb, pc, kc, jc + lo * nr, std::min(nc, hi * nr) - lo * nr,
+                       nr, packed_b.get() + lo * nr * kc);
+            });
+
+            // Tasks are (row block, group of slivers) pairs. Tall-skinny
+            // products have few row blocks, so their columns are split too.
+            size_t blocks = (M + GEMM_MC - 1) / GEMM_MC;
+            size_t groups = parallel ? std::min(slivers, (2 * num_threads() + blocks - 1) / blocks) : 1;
+            size_t per_group = (slivers + groups - 1) / groups;
+            groups = (slivers + per_group - 1) / per_group;
+            parallel_for(0, blocks * groups, parallel ? 1 : blocks * groups, [&](size_t lo, size_t hi) {
+                thread_local std::vector<double> packed_a;
+                packed_a.resize(GEMM_KC * GEMM_MC);
+                size_t packed_block_index = blocks;
+                for (size_t t = lo; t < hi; t++) {
+                    size_t block = t / groups, group = t % groups;
+                    size_t ic = block * GEMM_MC, mc = std::min(GEMM_MC, M - ic);
+                    size_t jr0 = group * per_group * nr;
+                    size_t jr1 = std::min(nc, (group + 1) * per_group * nr);
+                    packed_block(kernel, trans_a, A, lda, alpha, ic, mc, pc, kc, packed_b.get(),
+                                 jc, jr0, jr1, packed_a.data(), block != packed_block_index, C, ldc);
+                    packed_block_index = block;
+                }
+            });
+        }
+    }
+}
+
+static void gemm_eigen(bool trans_a, bool trans_b, size_t M, size_t N, size_t K,
+                       double alpha, const double* A, size_t lda, const double* B, size_t ldb,
+                       double* C, size_t ldc) {
+    typedef Eigen::Map<const Eigen::MatrixXd, 0, Eigen::OuterStride<>> ConstMap;
+    ConstMap a(A, trans_a ? K : M, trans_a ? M : K, Eigen::OuterStride<>(lda));
+    ConstMap b(B, trans_b ? N : K, trans_b ? K : N, Eigen::OuterStride<>(ldb));
+    Eigen::Map<Eigen::MatrixXd, 0, Eigen::OuterStride<>> c(C, M, N, Eigen::OuterStride<>(ldc));
+
+    // Eigen runs single-threaded; large products are split along the longer
+    // side of C into blocks that run on the thread pool
+    bool split_cols = N >= M;
+    size_t length = split_cols ? N : M;
+    size_t grain = M * N * K >= GEMM_PARALLEL_WORK ? std::max<size_t>(16, length / (4 * num_threads())) : length;
+    parallel_for(0, length, grain, [&](size_t lo, size_t hi) {
+        size_t n = hi - lo;
+        if (split_cols) {
+            auto c_block = c.middleCols(lo, n);
+            if (trans_a && trans_b) {
+                c_block.noalias() += alpha * a.transpose() * b.middleRows(lo, n).transpose();
+            } else if (trans_a) {
+                c_block.noalias() += alpha * a.transpose() * b.middleCols(lo, n);
+            } else if (trans_b) {
+                c_block.noalias() += alpha * a * b.middleRows(lo, n).transpose();
+            } else {
+                c_block.noalias() += alpha * a * b.middleCols(lo, n);
+            }
+        } else {
+            auto c_block = c.middleRows(lo, n);
+            if (trans_a && trans_b) {
+                c_block.noalias() += alpha * a.middleCols(lo, n).transpose() * b.transpose();
+            } else if (trans_a) {
+                c_block.noalias() += alpha * a.middleCols(lo, n).transpose() * b;
+            } else if (trans_b) {
+                c_block.noalias() += alpha * a.middleRows(lo, n) * b.transpose();
+            } else {
+                c_block.noalias() += alpha * a.middleRows(lo, n) * b;
+            }
+        }
+    });
+}
+
+void set_gemm_backend(GemmBackend backend) {
+    if (!gemm_backend_available(backend)) {
+        throw std::invalid_argument(std::string("set_gemm_backend: ")
+                                    + gemm_backend_name(backend) + " is not available");
+    }
+    current_backend.store(backend);
+}
+
+GemmBackend gemm_backend() {
+    return current_backend.load();
+}
+
+bool gemm_backend_available(GemmBackend backend) {
+#ifndef DNN_HAVE_CBLAS
+    if (backend == GemmBackend::Cblas) {
+        return false;
+    }
+#endif
+    return true;
+}
+
+const char* gemm_backend_name(GemmBackend backend) {
+    switch (backend) {
+    case GemmBackend::Eigen:
+        return "eigen";
+    case GemmBackend::Cblas:
+        return "cblas";
+    case GemmBackend::Packed:
+        return gemm_kernel_name(gemm_kernel());
+    }
+    return "unknown";
+}
+
+void gemm(bool trans_a, bool trans_b, size_t M, size_t N, size_t K,
+          double alpha, const double* A, size_t lda, const double* B, size_t ldb,
+          double beta, double* C, size_t ldc, GemmBackend backend) {
+    if (M == 0 || N == 0) {
+        return;
+    }
+    Eigen::Map<Eigen::MatrixXd, 0, Eigen::OuterStride<>> c(C, M, N, Eigen::OuterStride<>(ldc));
+#ifdef DNN_HAVE_CBLAS
+    if (backend == GemmBackend::Cblas && K > 0) {
+        cblas_dgemm(CblasColMajor, trans_a ? CblasTrans : CblasNoTrans,
+                    trans_b ? CblasTrans : CblasNoTrans,
+                    static_cast<int>(M), static_cast<int>(N), static_cast<int>(K),
+                    alpha, A, static_cast<int>(lda), B, static_cast<int>(ldb),
+                    beta, C, static_cast<int>(ldc));
+        return;
+    }
+#endif
+    // The Eigen and packed backends accumulate, so apply beta first. A zero
+    // beta overwrites C, which may hold garbage.
+    if (beta == 0.0) {
+        c.setZero();
+    } else if (beta != 1.0) {
+        c *= beta;
+    }
+    if (K == 0 || alpha == 0.0) {
+        return;
+    }
+    switch (backend) {
+    case GemmBackend::Packed:
+        // Matrix-vector products are bound by reading the matrix once, so
+        // packing it first would only double the memory traffic
+        if (M == 1 || N == 1) {
+            gemm_eigen(trans_a, trans_b, M, N, K, alpha, A, lda, B, ldb, C, ldc);
+            break;
+        }
+        gemm_packed(trans_a, trans_b, M, N, K, alpha, A, lda, B, ldb, C, ldc);
+        break;
+    case GemmBackend::Eigen:
+        gemm_eigen(trans_a, trans_b, M, N, K, alpha, A, lda, B, ldb, C, ldc);
+        break;
+    case GemmBackend::Cblas:
+        throw std::invalid_argument("gemm: cblas is not available");
+    }
+}
@@ -0,0 +1,503 @@
+/**
+ * @file npy.cpp
+ * @author Krish Suraparaju (csurapar@andrew.cmu.edu)
+ * @brief Provides the implementation of the .npy and .npz readers and writers
+ *        defined in include/utils/npy.h header.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include "../../include/utils/npy.h"
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Zip fields are 16 or 32 bits; larger archives would need the zip64 extension
+static const uint64_t ZIP_LIMIT = 0xFFFFFFFFu;
+
+// Every .npy file starts with this magic string
+static const char NPY_MAGIC[] = "\x93NUMPY";
+static const size_t NPY_MAGIC_SIZE = 6;
+
+static uint16_t read_u16(const char* p) {
+    const unsigned char* b = reinterpret_cast<const unsigned char*>(p);
+    return static_cast<uint16_t>(b[0] | (b[1] << 8));
+}
+
+static uint32_t read_u32(const char* p) {
+    const unsigned char* b = reinterpret_cast<const unsigned char*>(p);
+    return static_cast<uint32_t>(b[0]) | (static_cast<uint32_t>(b[1]) << 8)
+        | (static_cast<uint32_t>(b[2]) << 16) | (static_cast<uint32_t>(b[3]) << 24);
+}
+
+static uint64_t read_u64(const char* p) {
+    return static_cast<uint64_t>(read_u32(p)) | (static_cast<uint64_t>(read_u32(p + 4)) << 32);
+}
+
+static void write_u16(std::string& out, uint16_t v) {
+    out.push_back(static_cast<char>(v & 0xFF));
+    out.push_back(static_cast<char>(v >> 8));
+}
+
+static void write_u32(std::string& out, uint32_t v) {
+    for (int i = 0; i < 4; i++) {
+        out.push_back(static_cast<char>((v >> (8 * i)) & 0xFF));
+    }
+}
+
+/**
+ * @brief Updates a CRC-32 (the zip polynomial, 0xEDB88320 reflected) with
+ * the given bytes. Start from 0.
+ */
+static uint32_t crc32_update(uint32_t crc, const char* data, size_t size) {
+    static const std::vector<uint32_t> table = []() {
+        std::vector<uint32_t> t(256);
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++) {
+                c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            t[i] = c;
+        }
+        return t;
+    }();
+    crc = ~crc;
+    const unsigned char* b = reinterpret_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; i++) {
+        crc = table[(crc ^ b[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+/**
+ * @brief The text following key in the header dictionary, with leading
+ * spaces skipped.
+ */
+static std::string header_value(const std::string& dict, const std::string& key) {
+    size_t pos = dict.find("'" + key + "'");
+    if (pos == std::string::npos) {
+        throw std::runtime_error("npy: header has no '" + key + "'");
+    }
+    pos = dict.find(':', pos);
+    pos = dict.find_first_not_of(' ', pos + 1);
+    if (pos == std::string::npos) {
+        throw std::runtime_error("npy: header has no value for '" + key + "'");
+    }
+    return dict.substr(pos);
+}
+
+/**
+ * @brief Parses the header of the .npy data of the given size.
+ */
+static NpyHeader parse_header(const char* data, size_t size) {
+    if (size < 10 || std::memcmp(data, NPY_MAGIC, NPY_MAGIC_SIZE) != 0) {
+        throw std::runtime_error("npy: not a .npy file");
+    }
+    size_t prefix, length;
+    if (data[6] == 1) {
+        prefix = 10;
+        length = read_u16(data + 8);
+    } else if ((data[6] == 2 || data[6] == 3) && size >= 12) {
+        prefix = 12;
+        length = read_u32(data + 8);
+    } else {
+        throw std::runtime_error("npy: unsupported format version");
+    }
+    if (prefix + length > size) {
+        throw std::runtime_error("npy: truncated header");
+    }
+    std::string dict(data + prefix, length);
+
+    NpyHeader header;
+    std::string descr = header_value(dict, "descr");
+    if (descr.compare(0, 5, "'<f8'") == 0) {
+        header.dtype = NpyType::Float64;
+    } else if (descr.compare(0, 5, "'<f4'") == 0) {
+        header.dtype = NpyType::Float32;
+    } else {
+        throw std::runtime_error("npy: unsupported dtype " + descr.substr(0, descr.find(',')));
+    }
+    header.fortran_order = header_value(dict, "fortran_order").compare(0, 4, "True") == 0;
+
+    std::string shape = header_value(dict, "shape");
+    if (shape.empty() || shape[0] != '(' || shape.find(')') == std::string::npos) {
+        throw std::runtime_error("npy: malformed shape");
+    }
+    std::vector<size_t> dims;
+    size_t pos = 1, end = shape.find(')');
+    while (pos < end) {
+        size_t next = shape.find(',', pos);
+        std::string dim = shape.substr(pos, std::min(next, end) - pos);
+        if (dim.find_first_not_of(' ') != std::string::npos) {
+            try {
+                dims.push_back(std::stoul(dim));
+            } catch (const std::logic_error&) {
+                throw std::runtime_error("npy: malformed shape");
+            }
+        }
+        pos = next == std::string::npos ? end : next + 1;
+    }
+    if (dims.size() > 2) {
+        throw std::runtime_error("npy: only 0-, 1- and 2-D arrays are supported");
+    }
+    header.rows = dims.empty() ? 1 : dims[0];
+    header.cols = dims.size() < 2 ? 1 : dims[1];
+    header.data_offset = prefix + length;
+    if (header.data_offset + header.rows * header.cols * header.element_size() > size) {
+        throw std::runtime_error("npy: file is shorter than the array");
+    }
+    return header;
+}
+
+/**
+ * @brief Copies an array of the given type and order into a MatrixXd.
+ */
+template <typename Scalar>
+static Eigen::MatrixXd to_double(const char* data, const NpyHeader& header) {
+    const Scalar* values = reinterpret_cast<const Scalar*>(data);
+    if (header.fortran_order) {
+        return Eigen::Map<const Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic, Eigen::ColMajor>>(
+            values, header.rows, header.cols).template cast<double>();
+    }
+    return Eigen::Map<const Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>>(
+        values, header.rows, header.cols).template cast<double>();
+}
+
+static Eigen::MatrixXd decode(const char* data, const NpyHeader& header) {
+    const char* values = data + header.data_offset;
+    return header.dtype == NpyType::Float64 ? to_double<double>(values, header)
+                                            : to_double<float>(values, header);
+}
+
+/**
+ * @brief The .npy header of a Fortran-order 2-D array, padded so that the
+ * array starts at a multiple of 64 bytes.
+ */
+static std::string make_header(NpyType dtype, size_t rows, size_t cols) {
+    std::string dict = std::string("{'descr': '") + (dtype == NpyType::Float64 ? "<f8" : "<f4")
+        + "', 'fortran_order': True, 'shape': (" + std::to_string(rows) + ", "
+        + std::to_string(cols) + "), }";
+    size_t unpadded = NPY_MAGIC_SIZE + 4 + dict.size() + 1;
+    dict += std::string((64 - unpadded % 64) % 64, ' ') + "\n";
+
+    std::string header(NPY_MAGIC, NPY_MAGIC_SIZE);
+    header.push_back(1);
+    header.push_back(0);
+    write_u16(header, static_cast<uint16_t>(dict.size()));
+    return header + dict;
+}
+
+/**
+ * @brief The raw array of a matrix, column-major, in the given type. Doubles
+ * are not copied; floats are converted into the given matrix.
+ */
+static std::pair<const char*, size_t> payload(const Eigen::MatrixXd& M, NpyType dtype,
+                                              Eigen::MatrixXf& converted) {
+    if (dtype == NpyType::Float64) {
+        return {reinterpret_cast<const char*>(M.data()), M.size() * sizeof(double)};
+    }
+    converted = M.cast<float>();
+    return {reinterpret_cast<const char*>(converted.data()), converted.size() * sizeof(float)};
+}
+
+/**
+ * @brief Maps a whole file read-only. Throws std::runtime_error on failure.
+ */
+static const char* map_file(const std::string& path, size_t& bytes) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("npy: cannot open " + path);
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        throw std::runtime_error("npy: cannot read " + path);
+    }
+    bytes = static_cast<size_t>(st.st_size);
+    void* base = mmap(nullptr, bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        throw std::runtime_error("npy: mmap failed for " + path);
+    }
+    return static_cast<const char*>(base);
+}
+
+NpyMap::NpyMap(const std::string& path) {
+    this->base_ = map_file(path, this->bytes_);
+    try {
+        this->header_ = parse_header(this->base_, this->bytes_);
+    } catch (...) {
+        munmap(const_cast<char*>(this->base_), this->bytes_);
+        throw;
+    }
+}
+
+NpyMap::~NpyMap() {
+    munmap(const_cast<char*>(this->base_), this->bytes_);
+}
+
+Eigen::MatrixXd NpyMap::to_matrix() const {
+    return decode(this->base_, this->header_);
+}
+
+Eigen::MatrixXd load_npy(const std::string& path) {
+    return NpyMap(path).to_matrix();
+}
+
+void save_npy(const std::string& path, const Eigen::MatrixXd& M, NpyType dtype) {
+    std::ofstream file(path, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("save_npy: cannot open " + path);
+    }
+    Eigen::MatrixXf converted;
+    std::pair<const char*, size_t> data = payload(M, dtype, converted);
+    file << make_header(dtype, M.rows(), M.cols());
+    file.write(data.first, data.second);
+    if (!file) {
+        throw std::runtime_error("save_npy: cannot write " + path);
+    }
+}
+
+std::map<std::string, Eigen::MatrixXd> load_npz(const std::string& path) {
+    size_t bytes;
+    const char* base = map_file(path, bytes);
+    std::map<std::string, Eigen::MatrixXd> arrays;
+    try {
+        // The end of central directory record is last, before a comment of
+        // at most 64 KiB
+        size_t eocd = std::string::npos;
+        if (bytes >= 22) {
+            size_t lowest = bytes - 22 > 0xFFFF ? bytes - 22 - 0xFFFF : 0;
+            for (size_t pos = bytes - 22 + 1; pos-- > lowest;) {
+                if (read_u32(base + pos) == 0x06054b50) {
+                    eocd = pos;
+                    break;
+                }
+            }
+        }
+        if (eocd == std::string::npos) {
+            throw std::runtime_error("load_npz: " + path + " is not a zip archive");
+        }
+        size_t entries = read_u16(base + eocd + 10);
+        size_t pos = read_u32(base + eocd + 16);
+
+        for (size_t e = 0; e < entries; e++) {
+            if (pos + 46 > bytes || read_u32(base + pos) != 0x02014b50) {
+                throw std::runtime_error("load_npz: corrupt central directory in " + path);
+            }
+            uint16_t method = read_u16(base + pos + 10);
+            uint32_t crc = read_u32(base + pos + 16);
+            uint64_t size = read_u32(base + pos + 24);
+            size_t name_length = read_u16(base + pos + 28);
+            size_t extra_length = read_u16(base + pos + 30);
+            size_t comment_length = read_u16(base + pos + 32);
+            uint64_t offset = read_u32(base + pos + 42);
+            if (pos + 46 + name_length + extra_length > bytes) {
+                throw std::runtime_error("load_npz: corrupt central directory in " + path);
+            }
+            std::string name(base + pos + 46, name_length);
+
+            // Sizes and offsets that do not fit are in the zip64 extra field,
+            // in this order
+            const char* extra = base + pos + 46 + name_length;
+            for (size_t x = 0; x + 4 <= extra_length;) {
+                uint16_t id = read_u16(extra + x), length = read_u16(extra + x + 2);
+                if (id == 0x0001) {
+                    const char* field = extra + x + 4;
+                    if (size == ZIP_LIMIT) {
+                        size = read_u64(field);
+                        field += 8;
+                    }
+                    if (read_u32(base + pos + 20) == ZIP_LIMIT) {
+                        field += 8;  // Compressed size, the same for stored entries
+                    }
+                    if (offset == ZIP_LIMIT) {
+                        offset = read_u64(field);
+                    }
+                }
+                x += 4 + length;
+            }
+            pos += 46 + name_length + extra_length + comment_length;
+
+            if (method != 0) {
+                throw std::runtime_error("load_npz: " + name + " in " + path
+                                         + " is compressed, only np.savez archives are supported");
+            }
+            if (offset + 30 > bytes || read_u32(base + offset) != 0x04034b50) {
+                throw std::runtime_error("load_npz: corrupt entry " + name + " in " + path);
+            }
+            size_t data = offset + 30 + read_u16(base + offset + 26) + read_u16(base + offset + 28);
+            if (data + size > bytes) {
+                throw std::runtime_error("load_npz: truncated entry " + name + " in " + path);
+            }
+            if (crc32_update(0, base + data, size) != crc) {
+                throw std::runtime_error("load_npz: bad checksum for " + name + " in " + path);
+            }
+            if (name.size() < 4 || name.compare(name.size() - 4, 4, ".npy") != 0) {
+                continue;
+            }
+            NpyHeader header = parse_header(base + data, size);
+            arrays[name.substr(0, name.size() - 4)] = decode(base + data, header);
+        }
+    } catch (...) {
+        munmap(const_cast<char*>(base), bytes);
+        throw;
+    }
+    munmap(const_cast<char*>(base), bytes);
+    return arrays;
+}
+
+void save_npz(const std::string& path, const std::map<std::string, Eigen::MatrixXd>& arrays,
+              NpyType dtype) {
+    std::ofstream file(path, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("save_npz: cannot open " + path);
+    }
+    const uint16_t VERSION = 20;     // Zip format 2.0
+    const uint16_t DOS_DATE = 0x21;  // 1980-01-01, the zip epoch
+    std::string directory;
+    uint64_t offset = 0;
+
+    for (const auto& entry : arrays) {
+        std::string name = entry.first + ".npy";
+        std::string header = make_header(dtype, entry.second.rows(), entry.second.cols());
+        Eigen::MatrixXf converted;
+        std::pair<const char*, size_t> data = payload(entry.second, dtype, converted);
+        uint64_t size = header.size() + data.second;
+        if (offset + size + 30 + name.size() >= ZIP_LIMIT) {
+            throw std::runtime_error("save_npz: archives over 4 GiB are not supported");
+        }
+        uint32_t crc = crc32_update(crc32_update(0, header.data(), header.size()),
+                                    data.first, data.second);
+
+        // Local file header, then the .npy data, stored as is
+        std::string local;
+        write_u32(local, 0x04034b50);
+        write_u16(local, VERSION);
+        write_u16(local, 0);  // Flags
+        write_u16(local, 0);  // Stored
+        write_u16(local, 0);  // Time
+        write_u16(local, DOS_DATE);
+        write_u32(local, crc);
+        write_u32(local, static_cast<uint32_t>(size));
+        write_u32(local, static_cast<uint32_t>(size));
+        write_u16(local, static_cast<uint16_t>(name.size()));
+        write_u16(local, 0);  // Extra field
+        file << local << name << header;
+        file.write(data.first, data.second);
+
+        // Its central directory entry
+        write_u32(directory, 0x02014b50);
+        write_u16(directory, VERSION);  // Made by
+        write_u16(directory, VERSION);  // Needed
+        write_u16(directory, 0);
+        write_u16(directory, 0);
+        write_u16(directory, 0);
+        write_u16(directory, DOS_DATE);
+        write_u32(directory, crc);
+        write_u32(directory, static_cast<uint32_t>(size));
+        write_u32(directory, static_cast<uint32_t>(size));
+        write_u16(directory, static_cast<uint16_t>(name.size()));
+        write_u16(directory, 0);  // Extra field
+        write_u16(directory, 0);  // Comment
+        write_u16(directory, 0);  // Disk
+        write_u16(directory, 0);  // Internal attributes
+        write_u32(directory, 0);  // External attributes
+        write_u32(directory, static_cast<uint32_t>(offset));
+        directory += name;
+        offset += local.size() + name.size() + size;
+    }
+
+    std::string end;
+    write_u32(end, 0x06054b50);
+    write_u16(end, 0);  // This disk
+    write_u16(end, 0);  // Disk with the directory
+    write_u16(end, static_cast<uint16_t>(arrays.size()));
+    write_u16(end, static_cast<uint16_t>(arrays.size()));
+    write_u32(end, static_cast<uint32_t>(directory.size()));
+    write_u32(end, static_cast<uint32_t>(offset));
+    write_u16(end, 0);  // Comment
+    file << directory << end;
+    if (!file) {
+        throw std::runtime_error("save_npz: cannot write " + path);
+    }
+}
+
+/**
+ * @brief Adds the parameters of a layer and of its sublayers to arrays.
+ */
+static void collect_parameters(Layer& layer, const std::string& prefix,
+                               std::map<std::string, Eigen::MatrixXd>& arrays) {
+    Eigen::MatrixXd W = layer.weights();
+    if (W.size() > 0) {
+        arrays[prefix + ".weight"] = W;
+    }
+    if (layer.b_.size() > 0) {
+        arrays[prefix + ".bias"] = layer.b_;
+    }
+    std::vector<Layer*> children = layer.children();
+    for (size_t j = 0; j < children.size(); j++) {
+        collect_parameters(*children[j], prefix + "." + std::to_string(j), arrays);
+    }
+}
+
+/**
+ * @brief The array of the given name, which must have the given shape.
+ */
+static const Eigen::MatrixXd& find_parameter(const std::map<std::string, Eigen::MatrixXd>& arrays,
+                                             const std::string& name, Eigen::Index rows,
+                                             Eigen::Index cols) {
+    auto it = arrays.find(name);
+    if (it == arrays.end()) {
+        throw std::runtime_error("load_parameters: no array " + name);
+    }
+    if (it->second.rows() != rows || it->second.cols() != cols) {
+        throw std::runtime_error("load_parameters: " + name + " is "
+                                 + std::to_string(it->second.rows()) + " x "
+                                 + std::to_string(it->second.cols()) + ", expected "
+                                 + std::to_string(rows) + " x " + std::to_string(cols));
+    }
+    return it->second;
+}
+
+/**
+ * @brief Copies the parameters of a layer and of its sublayers out of arrays.
+ */
+static void assign_parameters(Layer& layer, const std::string& prefix,
+                              const std::map<std::string, Eigen::MatrixXd>& arrays) {
+    Eigen::MatrixXd W = layer.weights();
+    if (W.size() > 0) {
+        layer.set_weights(find_parameter(arrays, prefix + ".weight", W.rows(), W.cols()));
+    }
+    if (layer.b_.size() > 0) {
+        layer.b_ = find_parameter(arrays, prefix + ".bias", layer.b_.rows(), layer.b_.cols());
+    }
+    std::vector<Layer*> children = layer.children();
+    for (size_t j = 0; j < children.size(); j++) {
+        assign_parameters(*children[j], prefix + "." + std::to_string(j), arrays);
+    }
+}
+
+void save_parameters(const std::string& path, Model& model) {
+    std::map<std::string, Eigen::MatrixXd> arrays;
+    for (size_t i = 0; i < model.layers_.size(); i++) {
+        collect_parameters(*model.layers_[i], "layer" + std::to_string(i), arrays);
+    }
+    save_npz(path, arrays);
+}
+
+void load_parameters(const std::string& path, Model& model) {
+    std::map<std::string, Eigen::MatrixXd> arrays = load_npz(path);
+    for (size_t i = 0; i < model.layers_.size(); i++) {
+        assign_parameters(*model.layers_[i], "layer" + std::to_string(i), arrays);
+    }
+}
@@ -0,0 +1,59 @@
+/**
+ * @file parallel.cpp
+ * @author Krish Suraparaju (csurapar@andrew.cmu.edu)
+ * @brief Provides the implementation of the helpers defined in
+ *        include/utils/parallel.h header.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include "../../include/utils/parallel.h"
+#include "../../include/utils/thread_pool.h"
+#include <algorithm>
+
+// Chunks per thread, so that stealing can even out chunks of unequal cost
+static const size_t CHUNKS_PER_THREAD = 4;
+
+// Set by SerialScope on the threads that must not fan out
+static thread_local bool serial = false;
+
+SerialScope::SerialScope() : previous_(serial) {
+    serial = true;
+}
+
+SerialScope::~SerialScope() {
+    serial = this->previous_;
+}
+
+size_t num_threads() {
+    return ThreadPool::global().num_threads();
+}
+
+void parallel_for(size_t begin, size_t end, size_t grain,
+                  const std::function<void(size_t, size_t)>& fn) {
+    if (end <= begin) {
+        return;
+    }
+    if (serial) {
+        fn(begin, end);
+        return;
+    }
+    size_t n = end - begin;
+    grain = std::max<size_t>(grain, 1);
+    ThreadPool& pool = ThreadPool::global();
+    size_t chunks = std::min(pool.num_threads() * CHUNKS_PER_THREAD, n / grain);
+    if (pool.num_threads() < 2 || chunks < 2) {
+        fn(begin, end);
+        return;
+    }
+
+    size_t step = (n + chunks - 1) / chunks;
+    chunks = (n + step - 1) / step;
+    pool.run(chunks, [&](size_t c) {
+        size_t lo = begin + c * step;
+        fn(lo, std::min(end, lo + step));
+    });
+}
@@ -0,0 +1,295 @@
+/**
+ * @file thread_pool.cpp
+ * @author Krish Suraparaju (csurapar@andrew.cmu.edu)
+ * @brief Provides the implementation of the work-stealing thread pool
+ *        defined in include/utils/thread_pool.h header.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include "../../include/utils/thread_pool.h"
+#include <Eigen/Core>
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+// The pool running the current thread, if it is a worker
+static thread_local ThreadPool* current_pool = nullptr;
+static thread_local size_t current_worker = 0;
+
+/**
+ * @brief Parses a sysfs cpu list such as "0-3,8-11".
+ */
+static std::vector<int> parse_cpu_list(const std::string& list) {
+    std::vector<int> cpus;
+    std::stringstream ss(list);
+    std::string range;
+    while (std::getline(ss, range, ',')) {
+        size_t dash = range.find('-');
+        try {
+            int lo = std::stoi(range.substr(0, dash));
+            int hi = dash == std::string::npos ? lo : std::stoi(range.substr(dash + 1));
+            for (int cpu = lo; cpu <= hi; cpu++) {
+                cpus.push_back(cpu);
+            }
+        } catch (const std::exception&) {
+            // Ignore malformed entries
+        }
+    }
+    return cpus;
+}
+
+/**
+ * @brief The cores this process may run on, grouped by NUMA node.
+ */
+static std::vector<std::vector<int>> numa_nodes() {
+    std::vector<int> allowed;
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+            if (CPU_ISSET(cpu, &set)) {
+                allowed.push_back(cpu);
+            }
+        }
+    }
+#endif
+    if (allowed.empty()) {
+        for (unsigned cpu = 0; cpu < std::max(1u, std::thread::hardware_concurrency()); cpu++) {
+            allowed.push_back(static_cast<int>(cpu));
+        }
+    }
+
+    std::vector<std::vector<int>> nodes;
+    for (int node = 0;; node++) {
+        std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+        if (!file) {
+            break;
+        }
+        std::string list;
+        std::getline(file, list);
+        std::vector<int> cpus;
+        for (int cpu : parse_cpu_list(list)) {
+            if (std::find(allowed.begin(), allowed.end(), cpu) != allowed.end()) {
+                cpus.push_back(cpu);
+            }
+        }
+        if (!cpus.empty()) {
+            nodes.push_back(cpus);
+        }
+    }
+    if (nodes.empty()) {
+        nodes.push_back(allowed);
+    }
+    return nodes;
+}
+
+/**
+ * @brief The order in which threads are assigned to cores.
+ */
+static std::vector<int> cpu_order(ThreadAffinity affinity) {
+    std::vector<std::vector<int>> nodes = numa_nodes();
+    std::vector<int> order;
+    if (affinity == ThreadAffinity::Compact) {
+        for (const std::vector<int>& node : nodes) {
+            order.insert(order.end(), node.begin(), node.end());
+        }
+    } else {
+        for (size_t k = 0;; k++) {
+            bool any = false;
+            for (const std::vector<int>& node : nodes) {
+                if (k < node.size()) {
+                    order.push_back(node[k]);
+                    any = true;
+                }
+            }
+            if (!any) {
+                break;
+            }
+        }
+    }
+    return order;
+}
+
+ThreadPool::ThreadPool(size_t num_threads, ThreadAffinity affinity) {
+    // Eigen must not start threads of its own next to the pool's
+    Eigen::setNbThreads(1);
+
+    num_threads = std::max<size_t>(num_threads, 1);
+    std::vector<int> order;
+    if (affinity != ThreadAffinity::None) {
+        order = cpu_order(affinity);
+    }
+    for (size_t i = 0; i + 1 < num_threads; i++) {
+        this->workers_.push_back(std::make_unique<Worker>());
+        if (!order.empty()) {
+            // The first core is left to the thread that submits the work
+            this->workers_[i]->cpu = order[(i + 1) % order.size()];
+        }
+    }
+    for (size_t i = 0; i < this->workers_.size(); i++) {
+        this->workers_[i]->thread = std::thread(&ThreadPool::worker_loop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(this->sleep_mutex_);
+        this->stop_ = true;
+    }
+    this->wake_.notify_all();
+    for (std::unique_ptr<Worker>& worker : this->workers_) {
+        worker->thread.join();
+    }
+}
+
+void ThreadPool::worker_loop(size_t i) {
+#ifdef __linux__
+    int cpu = this->workers_[i]->cpu;
+    if (cpu >= 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    }
+#endif
+    current_pool = this;
+    current_worker = i;
+    Task task;
+    while (true) {
+        if (this->try_take(task)) {
+            this->execute(task);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(this->sleep_mutex_);
+        this->wake_.wait(lock, [this]() { return this->stop_ || this->queued_.load() > 0; });
+        if (this->stop_ && this->queued_.load() <= 0) {
+            return;
+        }
+    }
+}
+
+bool ThreadPool::try_take(Task& task) {
+    size_t W = this->workers_.size();
+    if (W == 0) {
+        return false;
+    }
+    // Newest task of our own deque first, it is the most likely to be in cache
+    if (current_pool == this) {
+        Worker& own = *this->workers_[current_worker];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = own.tasks.back();
+            own.tasks.pop_back();
+            this->queued_--;
+            return true;
+        }
+    }
+    // Otherwise steal the oldest task of another deque
+    size_t start = this->next_victim_.fetch_add(1) % W;
+    for (size_t k = 0; k < W; k++) {
+        Worker& victim = *this->workers_[(start + k) % W];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = victim.tasks.front();
+            victim.tasks.pop_front();
+            this->queued_--;
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::execute(const Task& task) {
+    Group& group = *task.group;
+    try {
+        (*group.task)(task.index);
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(group.mutex);
+        if (!group.error) {
+            group.error = std::current_exception();
+        }
+    }
+    // Decrement under the lock, so the group outlives the notification
+    std::lock_guard<std::mutex> lock(group.mutex);
+    if (--group.remaining == 0) {
+        group.done.notify_all();
+    }
+}
+
+void ThreadPool::run(size_t num_tasks, const std::function<void(size_t)>& task) {
+    if (num_tasks == 0) {
+        return;
+    }
+    if (num_tasks == 1 || this->workers_.empty()) {
+        for (size_t i = 0; i < num_tasks; i++) {
+            task(i);
+        }
+        return;
+    }
+
+    Group group;
+    group.task = &task;
+    group.remaining = num_tasks;
+    size_t W = this->workers_.size();
+    size_t first = this->next_victim_.fetch_add(1);
+    for (size_t i = 0; i < num_tasks; i++) {
+        // A worker keeps its tasks, other threads spread them over all deques
+        size_t w = current_pool == this ? current_worker : (first + i) % W;
+        std::lock_guard<std::mutex> lock(this->workers_[w]->mutex);
+        this->workers_[w]->tasks.push_back(Task{&group, i});
+    }
+    {
+        std::lock_guard<std::mutex> lock(this->sleep_mutex_);
+        this->queued_ += static_cast<long>(num_tasks);
+    }
+    this->wake_.notify_all();
+
+    // Help until the queues run dry, then wait for the tasks still running
+    Task next;
+    while (group.remaining.load() > 0 && this->try_take(next)) {
+        this->execute(next);
+    }
+    std::unique_lock<std::mutex> lock(group.mutex);
+    group.done.wait(lock, [&group]() { return group.remaining.load() == 0; });
+    if (group.error) {
+        std::rethrow_exception(group.error);
+    }
+}
+
+static std::mutex global_mutex;
+static std::unique_ptr<ThreadPool> global_pool;
+
+static size_t default_num_threads() {
+    const char* env = std::getenv("DNN_NUM_THREADS");
+    if (env != nullptr && std::atoi(env) > 0) {
+        return static_cast<size_t>(std::atoi(env));
+    }
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+ThreadPool& ThreadPool::global() {
+    std::lock_guard<std::mutex> lock(global_mutex);
+    if (!global_pool) {
+        global_pool = std::make_unique<ThreadPool>(default_num_threads());
+    }
+    return *global_pool;
+}
+
+void ThreadPool::configure(size_t num_threads, ThreadAffinity affinity) {
+    std::lock_guard<std::mutex> lock(global_mutex);
+    global_pool.reset();
+    global_pool = std::make_unique<ThreadPool>(num_threads == 0 ? default_num_threads() : num_threads,
+                                               affinity);
+}